@@ -0,0 +1,85 @@
+#include "BitField.h"
+#include <algorithm>
+
+BitField::BitField() : BitField(0, 0, 0) {}
+
+BitField::BitField(int ni, int nj, int nk) {
+    this->ni = ni;
+    this->nj = nj;
+    this->nk = nk;
+    this->is_planar = false;
+
+    int used_words = (nk + 2 * HALO + WORD_BITS - 1) / WORD_BITS;
+    this->row_words = (used_words + ROW_ALIGN_WORDS - 1) / ROW_ALIGN_WORDS * ROW_ALIGN_WORDS;
+    this->plane_words = (std::size_t)(nj + 2 * HALO) * this->row_words;
+    this->words.assign((std::size_t)(ni + 2 * HALO) * this->plane_words + 2 * GUARD_WORDS, 0);
+}
+
+BitField::BitField(int nj, int nk) : BitField(1, nj, nk) {
+    this->is_planar = true;
+    this->words.assign(this->plane_words + 2 * GUARD_WORDS, 0);
+}
+
+void BitField::clear() {
+    std::fill(this->words.begin(), this->words.end(), 0);
+}
+
+std::vector<uint64_t> BitField::interiorMask() const {
+    std::vector<uint64_t> mask(this->row_words, 0);
+    for (int k = 0; k < this->nk; k++) {
+        const int bit = k + HALO;
+        mask[bit / WORD_BITS] |= uint64_t(1) << (bit % WORD_BITS);
+    }
+    return mask;
+}
+
+void BitField::fillRowHalo(uint64_t* r, int nk, bool isTorus) {
+    const int low = 0;
+    const int high = nk + HALO;
+    const int first = HALO;
+    const int last = nk - 1 + HALO;
+    const bool wrap_low = isTorus && ((r[last / WORD_BITS] >> (last % WORD_BITS)) & 1);
+    const bool wrap_high = isTorus && ((r[first / WORD_BITS] >> (first % WORD_BITS)) & 1);
+    r[low / WORD_BITS] = (r[low / WORD_BITS] & ~(uint64_t(1) << (low % WORD_BITS)))
+        | ((uint64_t)wrap_low << (low % WORD_BITS));
+    r[high / WORD_BITS] = (r[high / WORD_BITS] & ~(uint64_t(1) << (high % WORD_BITS)))
+        | ((uint64_t)wrap_high << (high % WORD_BITS));
+}
+
+void BitField::fillHalo(bool isTorus) {
+    // k方向: 各内部行の両端ビット
+    // Along k: the two end bits of every interior row
+    for (int i = 0; i < this->ni; i++) {
+        for (int j = 0; j < this->nj; j++) {
+            fillRowHalo(this->row(i, j), this->nk, isTorus);
+        }
+    }
+
+    // j方向: 袖付きの行を丸ごとコピー
+    // Along j: copy whole rows, k ghosts included
+    for (int i = 0; i < this->ni; i++) {
+        uint64_t* below = this->row(i, -HALO);
+        uint64_t* above = this->row(i, this->nj);
+        if (isTorus) {
+            std::copy(this->row(i, this->nj - 1), this->row(i, this->nj - 1) + this->row_words, below);
+            std::copy(this->row(i, 0), this->row(i, 0) + this->row_words, above);
+        } else {
+            std::fill(below, below + this->row_words, 0);
+            std::fill(above, above + this->row_words, 0);
+        }
+    }
+
+    if (this->is_planar) return;
+
+    // i方向: 袖付きの平面を丸ごとコピー
+    // Along i: copy whole planes, j and k ghosts included
+    uint64_t* front = this->row(-HALO, -HALO);
+    uint64_t* back = this->row(this->ni, -HALO);
+    if (isTorus) {
+        std::copy(this->row(this->ni - 1, -HALO), this->row(this->ni - 1, -HALO) + this->plane_words, front);
+        std::copy(this->row(0, -HALO), this->row(0, -HALO) + this->plane_words, back);
+    } else {
+        std::fill(front, front + this->plane_words, 0);
+        std::fill(back, back + this->plane_words, 0);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef BIT_FIELD_H_
+#define BIT_FIELD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// SIMDロードに合わせて64バイト境界に確保するアロケータ
+// Allocator that aligns storage to 64 bytes for SIMD loads
+template <typename T>
+struct AlignedAllocator
+{
+    using value_type = T;
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(ALIGNMENT));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+// 1セル1ビットで詰め込んだ連続配列. k方向が64bitワードの行になり,
+// 行の長さはSIMD幅(256bit)の倍数に切り上げる.
+// 各軸の両端に1セル幅の袖領域(ゴーストセル)を持ち, 座標 -1 と n で参照できる.
+// 平面(2次元)のフィールドは i 方向の袖を持たない
+// Contiguous bit-packed cell array. Cells along k form rows of 64-bit words,
+// and every row is padded to a multiple of the SIMD width (256 bits).
+// Each axis carries a one-cell ghost layer on both ends, addressed as -1 and n.
+// Planar (2D) fields have no ghost layer along i
+class BitField
+{
+private:
+    int ni;
+    int nj;
+    int nk;
+    bool is_planar;
+    int row_words;
+    std::size_t plane_words;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> words;
+
+    std::size_t rowOffset(int i, int j) const {
+        return GUARD_WORDS + (std::size_t)(i + (this->is_planar ? 0 : HALO)) * this->plane_words
+            + (std::size_t)(j + HALO) * this->row_words;
+    }
+
+public:
+    static const int WORD_BITS = 64;
+    static const int ROW_ALIGN_WORDS = 4;
+    static const int HALO = 1;
+    // 隣接ワードを読むカーネルのために配列の前後に置く0のワード
+    // Zero words before and after the array for kernels that read adjacent words
+    static const int GUARD_WORDS = 8;
+
+    BitField();
+    BitField(int ni, int nj, int nk);
+    // i方向の袖を持たない平面フィールド
+    // Planar field without a ghost layer along i
+    BitField(int nj, int nk);
+
+    int sizeI() const { return this->ni; }
+    int sizeJ() const { return this->nj; }
+    int sizeK() const { return this->nk; }
+    bool isPlanar() const { return this->is_planar; }
+    int rowWords() const { return this->row_words; }
+    std::size_t planeWords() const { return this->plane_words; }
+
+    // 行(i, j)の先頭ワード. セルkは HALO + k ビット目
+    // First word of row (i, j). Cell k lives at bit HALO + k
+    const uint64_t* row(int i, int j) const {
+        return this->words.data() + this->rowOffset(i, j);
+    }
+    uint64_t* row(int i, int j) {
+        return this->words.data() + this->rowOffset(i, j);
+    }
+
+    bool get(int i, int j, int k) const {
+        const int bit = k + HALO;
+        return (this->row(i, j)[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+    }
+    void set(int i, int j, int k, bool alive) {
+        const int bit = k + HALO;
+        uint64_t& w = this->row(i, j)[bit / WORD_BITS];
+        const uint64_t mask = uint64_t(1) << (bit % WORD_BITS);
+        if (alive) w |= mask;
+        else w &= ~mask;
+    }
+
+    void clear();
+    // 内部セルのビットだけが立った1行分のマスク
+    // One row worth of words with only the interior-cell bits set
+    std::vector<uint64_t> interiorMask() const;
+    // 袖領域をトーラスなら反対側のコピーで, そうでなければ0で埋める
+    // Fills the ghost layer with wrapped copies for a torus, or with zeros otherwise
+    void fillHalo(bool isTorus);
+    // 1行のk方向の袖ビットだけを埋める. フィールドの外にある行の写しにも使う
+    // Fills only the k ghost bits of one row. Also used on copies of rows outside a field
+    static void fillRowHalo(uint64_t* row, int nk, bool isTorus);
+};
+
+#endif // BIT_FIELD_H_
@@ -0,0 +1,576 @@
+#ifndef BIT_KERNEL_H_
+#define BIT_KERNEL_H_
+
+#include <cstdint>
+#include <cstring>
+#include "KernelDispatch.h"
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+#include <immintrin.h>
+#endif
+
+// 1ワードに64セルを詰めたまま近傍数を数えるビットスライス演算.
+// W は uint64_t か, GCCのベクトル拡張型 (複数ワードを同時に扱う)
+// Bit-sliced neighbor counting that keeps 64 cells per word.
+// W is uint64_t or a GCC vector-extension type covering several words at once.
+// SIMD版は命令セットを変えた別の翻訳単位でもこのヘッダを読むので, 実体が
+// リンク時に混ざらないよう関数はすべて static (内部リンケージ) にする
+// The SIMD versions include this header from translation units built for other
+// instruction sets, so every function is static (internal linkage) to keep the
+// linker from mixing their bodies.
+// 桁のループは -O2 でも展開させ, 桁ごとの値をレジスタに置く
+// Digit loops are unrolled even at -O2 so each digit stays in a register
+namespace bitkernel {
+
+template <typename W>
+static inline W load(const uint64_t* p) {
+    W w;
+    std::memcpy(&w, p, sizeof(W));
+    return w;
+}
+
+template <typename W>
+static inline void store(uint64_t* p, W w) {
+    std::memcpy(p, &w, sizeof(W));
+}
+
+template <typename W>
+static inline void fullAdd(W a, W b, W c, W& sum, W& carry) {
+    const W t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+template <typename W>
+static inline void halfAdd(W a, W b, W& sum, W& carry) {
+    sum = a ^ b;
+    carry = a & b;
+}
+
+// k-1 側 (西) と k+1 側 (東) の隣接セルを各ビット位置へずらす. 隣のワードから桁を借りる
+// Moves the k-1 (west) and k+1 (east) neighbors onto each bit, borrowing from adjacent words
+template <typename W>
+static inline W west(const uint64_t* p) {
+    return (load<W>(p) << 1) | (load<W>(p - 1) >> 63);
+}
+
+template <typename W>
+static inline W east(const uint64_t* p) {
+    return (load<W>(p) >> 1) | (load<W>(p + 1) << 63);
+}
+
+// 1行の横3セル (西, 中央, 東) の和を2桁で返す
+// Sum of the three horizontal cells (west, center, east) of a row, as two digits
+template <typename W>
+static inline void rowSum(const uint64_t* p, W (&sum)[2]) {
+    fullAdd(west<W>(p), load<W>(p), east<W>(p), sum[0], sum[1]);
+}
+
+// 3つのビットスライス数を足す. 各桁で全加算器を2段使う
+// Adds three bit-sliced numbers with two full adders per digit
+template <typename W, int IN, int OUT>
+static inline void add3(const W (&a)[IN], const W (&b)[IN], const W (&c)[IN], W (&sum)[OUT]) {
+    W carry0{};
+    W carry1{};
+    #pragma GCC unroll 8
+    for (int d = 0; d < OUT; d++) {
+        const W x = d < IN ? a[d] : W{};
+        const W y = d < IN ? b[d] : W{};
+        const W z = d < IN ? c[d] : W{};
+        W t, k0, k1;
+        fullAdd(x, y, z, t, k0);
+        fullAdd(t, carry0, carry1, sum[d], k1);
+        carry0 = k0;
+        carry1 = k1;
+    }
+}
+
+// ビットスライスのカウンタに誕生/生存規則を論理関数として適用する.
+// カウンタは中央セル自身を含むので, 生存条件は1つずらして照合する
+// Applies the birth/survival rule to a bit-sliced counter as a boolean function.
+// The counter includes the center cell itself, so survival is matched one count higher
+// 統計を足した大きなループでも展開させる (呼び出しになるとベクトルレジスタを退避することになる)
+// Force inlining even into the larger loops with statistics; a call would spill the vector registers
+template <typename W, int BITS>
+__attribute__((always_inline)) static inline W applyRule(uint32_t birth_mask, uint32_t survival_mask,
+    W alive, const W (&count)[BITS]) {
+    // 下位3桁と上位2桁の一致パターンを共有してから各カウント値と照合する
+    // Share the match terms of the low three and high two digits, then test each count
+    W c[5] = {};
+    #pragma GCC unroll 8
+    for (int b = 0; b < BITS; b++) c[b] = count[b];
+    const W c0 = c[0], c1 = c[1], c2 = c[2], c3 = c[3], c4 = c[4];
+    W low[8];
+    W high[4];
+    const W low2[4] = { ~c1 & ~c0, ~c1 & c0, c1 & ~c0, c1 & c0 };
+    #pragma GCC unroll 8
+    for (int x = 0; x < 4; x++) {
+        low[x] = ~c2 & low2[x];
+        low[x + 4] = c2 & low2[x];
+    }
+    high[0] = ~c4 & ~c3;
+    high[1] = ~c4 & c3;
+    high[2] = c4 & ~c3;
+    high[3] = c4 & c3;
+
+    const uint32_t representable = BITS >= 5 ? 0xFFFFFFF : (uint32_t(1) << (1 << BITS)) - 1;
+    const uint32_t birth = birth_mask & representable;
+    const uint32_t survival = (survival_mask << 1) & representable;
+
+    W born{};
+    W survive{};
+    for (uint32_t rest = birth | survival; rest; rest &= rest - 1) {
+        const int c = __builtin_ctz(rest);
+        const W eq = low[c & 7] & high[c >> 3];
+        if ((birth >> c) & 1) born |= eq;
+        if ((survival >> c) & 1) survive |= eq;
+    }
+    return (born & ~alive) | (survive & alive);
+}
+
+// SIMD版の翻訳単位では popcnt 命令になる
+// Becomes the popcnt instruction in the SIMD translation units
+static inline uint64_t popcount(uint64_t x) {
+    return (uint64_t)__builtin_popcountll(x);
+}
+
+// ビットスライスのカウンタから生存近傍数ごとのセル数を数える. カウンタは中央セルを含むので,
+// 生きたセルは1つ下の数に入れる
+// Counts cells per live-neighbor count from a bit-sliced counter. The counter includes the center
+// cell, so live cells go one count lower
+template <typename W, int BITS>
+static inline void accumulateHistogram(const W (&count)[BITS], W alive, W mask, uint64_t* histogram) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    const int max_count = BITS >= 5 ? 27 : (1 << BITS) - 1;
+    uint64_t digits[BITS][LANES];
+    uint64_t live[LANES];
+    uint64_t inside[LANES];
+    #pragma GCC unroll 8
+    for (int d = 0; d < BITS; d++) store<W>(digits[d], count[d]);
+    store<W>(live, alive);
+    store<W>(inside, mask);
+    for (int l = 0; l < LANES; l++) {
+        for (int c = 0; c <= max_count; c++) {
+            uint64_t eq = inside[l];
+            for (int d = 0; d < BITS; d++) eq &= ((c >> d) & 1) ? digits[d][l] : ~digits[d][l];
+            if (c < 27) histogram[c] += popcount(eq & ~live[l]);
+            if (c > 0) histogram[c - 1] += popcount(eq & live[l]);
+        }
+    }
+}
+
+// 各レーンの popcount をベクトルのまま求められるか. AVX-512 VPOPCNTDQ と VL 向けの翻訳単位だけ
+// Whether per-lane popcounts can be taken without leaving the vector: only in the translation unit
+// built for AVX-512 VPOPCNTDQ and VL
+template <typename W>
+constexpr bool hasLanePopcount() {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+    return sizeof(W) == 64 || sizeof(W) == 32;
+#else
+    return false;
+#endif
+}
+
+template <typename W>
+static inline W lanePopcount(W x) {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+    if constexpr (sizeof(W) == 64) return (W)_mm512_popcnt_epi64((__m512i)x);
+    if constexpr (sizeof(W) == 32) return (W)_mm256_popcnt_epi64((__m256i)x);
+#endif
+    return x;
+}
+
+// タイルで集める統計. レーンごとの popcount があれば誕生と死亡はレーンごとの数に足し, タイルの終わりに
+// 一度だけまとめる. 無ければビット位置ごとの数をビットスライスで持ち, 溢れる前に popcount でまとめる
+// Statistics gathered over a tile. With a per-lane popcount, births and deaths go into per-lane totals
+// that are summed once at the end of the tile. Without one they are held per bit position as bit-sliced
+// counts and drained with popcount before they overflow
+template <typename W>
+struct TileStats
+{
+    static const int DIGITS = 4;
+
+    W born[DIGITS] = {};
+    W died[DIGITS] = {};
+    int pending = 0;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+    uint64_t* histogram = nullptr;
+};
+
+template <typename W, int DIGITS>
+static inline void increment(W (&digits)[DIGITS], W x) {
+    #pragma GCC unroll 8
+    for (int d = 0; d < DIGITS; d++) {
+        const W carry = digits[d] & x;
+        digits[d] ^= x;
+        x = carry;
+    }
+}
+
+template <typename W, int DIGITS>
+static inline uint64_t drain(W (&digits)[DIGITS]) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    uint64_t total = 0;
+    #pragma GCC unroll 8
+    for (int d = 0; d < DIGITS; d++) {
+        uint64_t lanes[LANES];
+        store<W>(lanes, digits[d]);
+        for (int l = 0; l < LANES; l++) {
+            total += (hasLanePopcount<W>() ? lanes[l] : popcount(lanes[l])) << d;
+        }
+        digits[d] = W{};
+    }
+    return total;
+}
+
+template <typename W>
+static inline void drainChanges(TileStats<W>& stats) {
+    stats.births += drain(stats.born);
+    stats.deaths += drain(stats.died);
+    stats.pending = 0;
+}
+
+// 次世代の1ベクトル分の誕生, 死亡と近傍数を足し込む. next と alive は領域内のビットだけ
+// Adds the births, deaths and neighbor counts of one next-generation vector. next and alive hold in-field bits only
+template <typename W, int BITS>
+__attribute__((always_inline)) static inline void collectStats(TileStats<W>& stats, W next, W alive,
+    W mask, const W (&count)[BITS]) {
+    if constexpr (hasLanePopcount<W>()) {
+        stats.born[0] += lanePopcount(next & ~alive);
+        stats.died[0] += lanePopcount(alive & ~next);
+    } else {
+        const W flips = next ^ alive;
+        increment(stats.born, flips & next);
+        increment(stats.died, flips & alive);
+        if (++stats.pending == (1 << TileStats<W>::DIGITS) - 1) drainChanges(stats);
+    }
+    if (stats.histogram != nullptr) accumulateHistogram(count, alive, mask, stats.histogram);
+}
+
+// タイルの終わりに残りを数えてワーカーの統計へ足す
+// At the end of a tile, drains the rest into the worker's statistics
+template <typename W>
+static inline void finishStats(TileStats<W>& stats, const StepTile& t) {
+    drainChanges(stats);
+    t.worker_stats->births += stats.births;
+    t.worker_stats->deaths += stats.deaths;
+}
+
+// 統計を集めるときは, 1行が1ベクトルに収まればブリックに入る行 (最大 STATS_BRICK_ROWS 行) をまとめて書き,
+// 論理和をレジスタに持ってブリックへは一度だけ書く. 行が長ければ L1 に収まるブリックの論理和へ1行ずつ足す
+// With statistics and rows of one vector, the rows inside one brick (up to STATS_BRICK_ROWS) are written
+// together and the OR stays in a register until it is written to the brick once. Longer rows go one at a
+// time, merging into the brick ORs, which stay in L1
+template <typename W, bool Stats>
+static inline int rowGroupEnd(const StepTile& t, int j) {
+    if constexpr (!Stats) return j + 1;
+    if (t.word_end - t.word_begin != (int)(sizeof(W) / sizeof(uint64_t))) return j + 1;
+    const int end = (j / STATS_BRICK_ROWS + 1) * STATS_BRICK_ROWS;
+    return end < t.j_end ? end : t.j_end;
+}
+
+// 平面 i の行 j を含むブリックの論理和の先頭
+// Start of the ORs of the brick holding row j of plane i
+static inline uint64_t* brickOrs(const StepTile& t, int i, int j) {
+    return t.brick_or + ((std::size_t)(i / STATS_BRICK_PLANES) * t.bricks_j + j / STATS_BRICK_ROWS) * t.row_words;
+}
+
+// ブリックの論理和のワード w から any を足す. ブリックの最初の平面の最初の行なら前の世代の値を上書きする
+// Merges any into the brick ORs from word w. The first row of a brick's first plane overwrites the previous
+// generation's values
+template <typename W>
+static inline void mergeBrickOr(uint64_t* ors, int w, bool first, W any) {
+    store<W>(ors + w, first ? any : load<W>(ors + w) | any);
+}
+
+// von Neumann近傍で行 [j_begin, j_end) の次世代を計算する. ワードを外側, 行を内側に回す
+// Steps rows [j_begin, j_end) of plane i with the von Neumann neighborhood, words outside and rows inside
+template <typename W, int Dim, bool Stats>
+static inline void stepRowsNeumann(const StepTile& t, int i, int j_begin, int j_end, TileStats<W>& stats) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    // 書き込みはどの型とも別名になりうるので, タイルの値は局所変数に写してから回す
+    // Stores may alias anything, so the tile's fields are copied to locals before the loops
+    const std::ptrdiff_t rs = t.row_stride;
+    const std::ptrdiff_t ps = t.plane_stride;
+    const uint64_t* src = t.src + i * ps;
+    uint64_t* dst = t.dst + i * ps;
+    const uint64_t* mask = t.mask;
+    const uint32_t birth_mask = t.birth_mask;
+    const uint32_t survival_mask = t.survival_mask;
+    const int w_end = t.word_end;
+    uint64_t* ors = Stats ? brickOrs(t, i, j_begin) : nullptr;
+    const bool first = i % STATS_BRICK_PLANES == 0 && j_begin % STATS_BRICK_ROWS == 0;
+    for (int w = t.word_begin; w < w_end; w += LANES) {
+        const W in_field = load<W>(mask + w);
+        W any{};
+        for (int j = j_begin; j < j_end; j++) {
+            const uint64_t* c = src + j * rs + w;
+            // 中央行の横3セル + 上下の行 (+ 前後の平面) の中央セル
+            // Three horizontal cells of the center row + the rows above and below (+ the planes in front and behind)
+            W center[2];
+            rowSum(c, center);
+            W count[3];
+            W s0, k;
+            fullAdd(center[0], load<W>(c - rs), load<W>(c + rs), s0, k);
+            if constexpr (Dim == 3) {
+                W t1;
+                fullAdd(load<W>(c - ps), load<W>(c + ps), s0, count[0], t1);
+                fullAdd(center[1], k, t1, count[1], count[2]);
+            } else {
+                count[0] = s0;
+                halfAdd(center[1], k, count[1], count[2]);
+            }
+
+            const W alive = load<W>(c);
+            const W next = applyRule(birth_mask, survival_mask, alive, count) & in_field;
+            store<W>(dst + j * rs + w, next);
+            if constexpr (Stats) {
+                collectStats(stats, next, alive & in_field, in_field, count);
+                any |= next;
+            }
+        }
+        if constexpr (Stats) mergeBrickOr(ors, w, first, any);
+    }
+}
+
+// ワード [w_begin, w_end) の行の3セル和 (2桁) を out[digit * row_words + w] に書く
+// Writes the three-cell row sums (two digits) of words [w_begin, w_end) to out[digit * row_words + w]
+template <typename W>
+static inline void rowSumRow(const uint64_t* src, uint64_t* out, int row_words, int w_begin, int w_end) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    for (int w = w_begin; w < w_end; w += LANES) {
+        W sum[2];
+        rowSum(src + w, sum);
+        store<W>(out + w, sum[0]);
+        store<W>(out + row_words + w, sum[1]);
+    }
+}
+
+// 連続する3行の行和から平面の3x3和 (4桁) を作る
+// Builds the 3x3 plane sums (four digits) from the row sums of three consecutive rows
+template <typename W>
+static inline void planeSumRow(const uint64_t* a, const uint64_t* b, const uint64_t* c,
+    uint64_t* out, int row_words, int w_begin, int w_end) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    for (int w = w_begin; w < w_end; w += LANES) {
+        const W x[2] = { load<W>(a + w), load<W>(a + row_words + w) };
+        const W y[2] = { load<W>(b + w), load<W>(b + row_words + w) };
+        const W z[2] = { load<W>(c + w), load<W>(c + row_words + w) };
+        W sum[4];
+        add3(x, y, z, sum);
+        #pragma GCC unroll 8
+        for (int d = 0; d < 4; d++) store<W>(out + d * row_words + w, sum[d]);
+    }
+}
+
+// 平面和から平面 i の行 [j_begin, j_end) の次世代を書く. 3次元では前後の平面和も足す.
+// 和は行 j_begin の分から 4 * row_words ワードおきに並ぶ
+// Writes the next generation of rows [j_begin, j_end) of plane i from the plane sums; in 3D the sums
+// of the planes in front and behind are added. The sums start at row j_begin, 4 * row_words words apart
+template <typename W, int Dim, bool Stats>
+static inline void emitRowsMoore(const StepTile& t, const uint64_t* front, const uint64_t* mid,
+    const uint64_t* back, int i, int j_begin, int j_end, TileStats<W>& stats) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    // 書き込みはどの型とも別名になりうるので, タイルの値は局所変数に写してから回す
+    // Stores may alias anything, so the tile's fields are copied to locals before the loops
+    const int rw = t.row_words;
+    const std::ptrdiff_t rs = t.row_stride;
+    const uint64_t* src = t.src + i * t.plane_stride;
+    uint64_t* dst = t.dst + i * t.plane_stride;
+    const uint64_t* mask = t.mask;
+    const uint32_t birth_mask = t.birth_mask;
+    const uint32_t survival_mask = t.survival_mask;
+    const int w_end = t.word_end;
+    uint64_t* ors = Stats ? brickOrs(t, i, j_begin) : nullptr;
+    const bool first = i % STATS_BRICK_PLANES == 0 && j_begin % STATS_BRICK_ROWS == 0;
+    for (int w = t.word_begin; w < w_end; w += LANES) {
+        const W in_field = load<W>(mask + w);
+        W any{};
+        for (int j = j_begin; j < j_end; j++) {
+            const std::size_t n = (std::size_t)(j - j_begin) * 4 * rw + w;
+            W y[4];
+            #pragma GCC unroll 8
+            for (int d = 0; d < 4; d++) y[d] = load<W>(mid + n + d * rw);
+
+            const W alive = load<W>(src + j * rs + w);
+            uint64_t* out = dst + j * rs + w;
+            if constexpr (Dim == 3) {
+                W x[4], z[4], count[5];
+                #pragma GCC unroll 8
+                for (int d = 0; d < 4; d++) {
+                    x[d] = load<W>(front + n + d * rw);
+                    z[d] = load<W>(back + n + d * rw);
+                }
+                add3(x, y, z, count);
+                const W next = applyRule(birth_mask, survival_mask, alive, count) & in_field;
+                store<W>(out, next);
+                if constexpr (Stats) {
+                    collectStats(stats, next, alive & in_field, in_field, count);
+                    any |= next;
+                }
+            } else {
+                const W next = applyRule(birth_mask, survival_mask, alive, y) & in_field;
+                store<W>(out, next);
+                if constexpr (Stats) {
+                    collectStats(stats, next, alive & in_field, in_field, y);
+                    any |= next;
+                }
+            }
+        }
+        if constexpr (Stats) mergeBrickOr(ors, w, first, any);
+    }
+}
+
+// Moore近傍のタイルを平面ごとに流す. 行和は3行, 平面和は3平面のリングに置いて再利用し,
+// セル1つあたりの読み込みを27から約3に減らす
+// Streams a Moore tile plane by plane. Row sums live in a ring of three rows and plane sums
+// in a ring of three planes, so each cell is read about 3 times instead of 27
+template <typename W, int Dim, bool Stats>
+static inline void stepTileMoore(const StepTile& t) {
+    const int rw = t.row_words;
+    const int wb = t.word_begin;
+    const int we = t.word_end;
+    const int rows = t.j_end - t.j_begin;
+    const std::size_t plane_sum_words = (std::size_t)rows * 4 * rw;
+    uint64_t* row_ring = t.scratch;
+    uint64_t* plane_ring = t.scratch + 3 * 2 * rw;
+
+    auto srcRow = [&](int i, int j) { return t.src + i * t.plane_stride + j * t.row_stride; };
+    auto planeSums = [&](int i) { return plane_ring + ((i % 3 + 3) % 3) * plane_sum_words; };
+    TileStats<W> stats;
+    if constexpr (Stats) stats.histogram = t.histogram ? t.worker_stats->histogram : nullptr;
+
+    const int first_plane = Dim == 3 ? t.i_begin - 1 : t.i_begin;
+    for (int p = first_plane; p < t.i_end + (Dim == 3 ? 1 : 0); p++) {
+        // 平面pの3x3和
+        // 3x3 sums of plane p
+        uint64_t* sums = planeSums(p);
+        rowSumRow<W>(srcRow(p, t.j_begin - 1), row_ring, rw, wb, we);
+        rowSumRow<W>(srcRow(p, t.j_begin), row_ring + 2 * rw, rw, wb, we);
+        for (int j = t.j_begin; j < t.j_end; j++) {
+            const int n = j - t.j_begin;
+            rowSumRow<W>(srcRow(p, j + 1), row_ring + ((n + 2) % 3) * 2 * rw, rw, wb, we);
+            planeSumRow<W>(row_ring + (n % 3) * 2 * rw, row_ring + ((n + 1) % 3) * 2 * rw,
+                row_ring + ((n + 2) % 3) * 2 * rw, sums + (std::size_t)n * 4 * rw, rw, wb, we);
+        }
+
+        // 3次元では前後の平面和がそろった平面 p - 1 を書き出す
+        // In 3D emit plane p - 1 once the sums of its neighbors are ready
+        const int out_plane = Dim == 3 ? p - 1 : p;
+        if (out_plane < t.i_begin) continue;
+        for (int j = t.j_begin; j < t.j_end;) {
+            const int j_end = rowGroupEnd<W, Stats>(t, j);
+            const std::size_t offset = (std::size_t)(j - t.j_begin) * 4 * rw;
+            emitRowsMoore<W, Dim, Stats>(t, planeSums(out_plane - 1) + offset, planeSums(out_plane) + offset,
+                planeSums(out_plane + 1) + offset, out_plane, j, j_end, stats);
+            j = j_end;
+        }
+    }
+    if constexpr (Stats) finishStats(stats, t);
+}
+
+template <typename W, int Dim, bool Stats>
+static inline void stepTileNeumann(const StepTile& t) {
+    TileStats<W> stats;
+    if constexpr (Stats) stats.histogram = t.histogram ? t.worker_stats->histogram : nullptr;
+    for (int i = t.i_begin; i < t.i_end; i++) {
+        for (int j = t.j_begin; j < t.j_end;) {
+            const int j_end = rowGroupEnd<W, Stats>(t, j);
+            stepRowsNeumann<W, Dim, Stats>(t, i, j, j_end, stats);
+            j = j_end;
+        }
+    }
+    if constexpr (Stats) finishStats(stats, t);
+}
+
+template <typename W, int Dim, Neighborhood N>
+static inline void stepTile(const StepTile& t) {
+    // 統計の有無で別々に実体化し, 集めないときの内側のループには何も足さない
+    // Instantiated separately with and without statistics, so the inner loops gain nothing when they are off
+    if constexpr (N == Neighborhood::Moore) {
+        if (t.brick_or != nullptr) stepTileMoore<W, Dim, true>(t);
+        else stepTileMoore<W, Dim, false>(t);
+    } else {
+        if (t.brick_or != nullptr) stepTileNeumann<W, Dim, true>(t);
+        else stepTileNeumann<W, Dim, false>(t);
+    }
+}
+
+// 集団のカーネル. ワードごとの論理演算は世界ごとに独立なので, 単一の世界と同じ加算器と規則を
+// ビットをずらす代わりに cell_words ワード離れた隣のセルへ使う. 3次元 Moore 近傍では9行の横3セル和から
+// 平面ごとの和を作り, 3平面を足す
+// Ensemble kernel. Word-wise logic is independent per world, so the adders and rule of a single world
+// apply as they are, with the k neighbors cell_words words away instead of one bit over. For the 3D Moore
+// neighborhood the three-cell sums of nine rows make per-plane sums, and the three planes are added
+template <typename W, int Dim, Neighborhood N>
+static inline void stepEnsembleTile(const EnsembleTile& t) {
+    const int LANES = sizeof(W) / sizeof(uint64_t);
+    const int cw = t.cell_words;
+    auto rowSum3 = [cw](const uint64_t* p, W (&sum)[2]) {
+        fullAdd(load<W>(p - cw), load<W>(p), load<W>(p + cw), sum[0], sum[1]);
+    };
+    for (int i = t.i_begin; i < t.i_end; i++) {
+        for (int j = t.j_begin; j < t.j_end; j++) {
+            const uint64_t* rows[3][3];
+            for (int di = 0; di < 3; di++) {
+                for (int dj = 0; dj < 3; dj++) {
+                    rows[di][dj] = t.src + (Dim == 3 ? i + di - 1 : i) * t.plane_stride + (j + dj - 1) * t.row_stride;
+                }
+            }
+            uint64_t* out = t.dst + i * t.plane_stride + j * t.row_stride;
+            for (int w = t.word_begin; w < t.word_end; w += LANES) {
+                const W alive = load<W>(rows[1][1] + w);
+                if constexpr (N == Neighborhood::Neumann) {
+                    W center[2];
+                    rowSum3(rows[1][1] + w, center);
+                    W count[3];
+                    W s0, k;
+                    fullAdd(center[0], load<W>(rows[1][0] + w), load<W>(rows[1][2] + w), s0, k);
+                    if constexpr (Dim == 3) {
+                        W t1;
+                        fullAdd(load<W>(rows[0][1] + w), load<W>(rows[2][1] + w), s0, count[0], t1);
+                        fullAdd(center[1], k, t1, count[1], count[2]);
+                    } else {
+                        count[0] = s0;
+                        halfAdd(center[1], k, count[1], count[2]);
+                    }
+                    store<W>(out + w, applyRule(t.birth_mask, t.survival_mask, alive, count));
+                } else {
+                    W planes[3][4];
+                    #pragma GCC unroll 3
+                    for (int di = (Dim == 3 ? 0 : 1); di < (Dim == 3 ? 3 : 2); di++) {
+                        W a[2], b[2], c[2];
+                        rowSum3(rows[di][0] + w, a);
+                        rowSum3(rows[di][1] + w, b);
+                        rowSum3(rows[di][2] + w, c);
+                        add3(a, b, c, planes[di]);
+                    }
+                    if constexpr (Dim == 3) {
+                        W count[5];
+                        add3(planes[0], planes[1], planes[2], count);
+                        store<W>(out + w, applyRule(t.birth_mask, t.survival_mask, alive, count));
+                    } else {
+                        store<W>(out + w, applyRule(t.birth_mask, t.survival_mask, alive, planes[1]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 命令セットごとの翻訳単位で, 近傍と次元に応じたタイル関数 (StepTile か EnsembleTile 用) を返す
+// Returns the tile function (for StepTile or EnsembleTile) for a neighborhood and dimension, in each
+// per-instruction-set translation unit
+template <template <int, Neighborhood> class Impl>
+static inline auto stepTileTable(int dim, Neighborhood neighborhood) -> decltype(&Impl<2, Neighborhood::Moore>::run) {
+    if (dim == 2) {
+        if (neighborhood == Neighborhood::Neumann) return Impl<2, Neighborhood::Neumann>::run;
+        return Impl<2, Neighborhood::Moore>::run;
+    }
+    if (neighborhood == Neighborhood::Neumann) return Impl<3, Neighborhood::Neumann>::run;
+    return Impl<3, Neighborhood::Moore>::run;
+}
+
+}
+
+#endif // BIT_KERNEL_H_
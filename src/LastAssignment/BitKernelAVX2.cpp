@@ -0,0 +1,53 @@
+// この翻訳単位だけAVX2向けにコンパイルする. 呼ぶのはCPUが対応している時のみ
+// Only this translation unit is compiled for AVX2. Called only when the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#pragma GCC target("avx2,popcnt")
+
+#include "KernelDispatch.h"
+#include "BitKernel.h"
+#include "ByteKernel.h"
+
+namespace {
+
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint8_t u8x32 __attribute__((vector_size(32)));
+
+template <int Dim, Neighborhood N>
+struct AVX2Tile
+{
+    static void run(const StepTile& tile) {
+        bitkernel::stepTile<u64x4, Dim, N>(tile);
+    }
+};
+
+template <int Dim, Neighborhood N>
+struct AVX2EnsembleTile
+{
+    static void run(const EnsembleTile& tile) {
+        bitkernel::stepEnsembleTile<u64x4, Dim, N>(tile);
+    }
+};
+
+template <int Dim, Neighborhood N>
+struct AVX2GenerationsTile
+{
+    static void run(const GenerationsTile& tile) {
+        bytekernel::stepGenerationsTile<u8x32, Dim, N>(tile);
+    }
+};
+
+}
+
+StepTileFn stepTileAVX2(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX2Tile>(dim, neighborhood);
+}
+
+EnsembleTileFn ensembleTileAVX2(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX2EnsembleTile>(dim, neighborhood);
+}
+
+GenerationsTileFn generationsTileAVX2(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX2GenerationsTile>(dim, neighborhood);
+}
+
+#endif
@@ -0,0 +1,43 @@
+// この翻訳単位だけAVX-512向けにコンパイルする. 呼ぶのはCPUが対応している時のみ
+// Only this translation unit is compiled for AVX-512. Called only when the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#pragma GCC target("avx512f,popcnt")
+
+#include "KernelDispatch.h"
+#include "BitKernel.h"
+
+namespace {
+
+typedef uint64_t u64x8 __attribute__((vector_size(64)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+
+// ワード範囲は4ワード単位なので, 8ワードで割り切れない幅では4ワード幅で処理する
+// Word ranges come in multiples of four words, so widths that are not a multiple of eight run four wide
+template <int Dim, Neighborhood N>
+struct AVX512Tile
+{
+    static void run(const StepTile& tile) {
+        if ((tile.word_end - tile.word_begin) % 8 == 0) bitkernel::stepTile<u64x8, Dim, N>(tile);
+        else bitkernel::stepTile<u64x4, Dim, N>(tile);
+    }
+};
+
+template <int Dim, Neighborhood N>
+struct AVX512EnsembleTile
+{
+    static void run(const EnsembleTile& tile) {
+        bitkernel::stepEnsembleTile<u64x8, Dim, N>(tile);
+    }
+};
+
+}
+
+StepTileFn stepTileAVX512(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX512Tile>(dim, neighborhood);
+}
+
+EnsembleTileFn ensembleTileAVX512(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX512EnsembleTile>(dim, neighborhood);
+}
+
+#endif
@@ -0,0 +1,31 @@
+// AVX-512 の世代計算カーネルを VPOPCNTDQ と VL 付きでもう一度コンパイルする. 統計を集めるとき,
+// 誕生と死亡をレーンごとの popcount で数えられる. 呼ぶのはCPUがすべてに対応している時のみ
+// The AVX-512 stepping kernels compiled once more with VPOPCNTDQ and VL, so births and deaths are
+// counted with per-lane popcounts when statistics are collected. Called only when the CPU supports all of them
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#pragma GCC target("avx512f,avx512vl,avx512vpopcntdq,popcnt")
+
+#include "KernelDispatch.h"
+#include "BitKernel.h"
+
+namespace {
+
+typedef uint64_t u64x8 __attribute__((vector_size(64)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+
+template <int Dim, Neighborhood N>
+struct AVX512PopcountTile
+{
+    static void run(const StepTile& tile) {
+        if ((tile.word_end - tile.word_begin) % 8 == 0) bitkernel::stepTile<u64x8, Dim, N>(tile);
+        else bitkernel::stepTile<u64x4, Dim, N>(tile);
+    }
+};
+
+}
+
+StepTileFn stepTileAVX512Popcount(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<AVX512PopcountTile>(dim, neighborhood);
+}
+
+#endif
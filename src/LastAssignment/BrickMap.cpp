@@ -0,0 +1,224 @@
+#include "BrickMap.h"
+#include "CA.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+BrickMap::BrickMap(const Rule& rule, bool isNeumannNeighborhood)
+    : stepper(isNeumannNeighborhood ? Neighborhood::Neumann : Neighborhood::Moore) {
+    if (rule.birthMask() & 1) {
+        throw std::invalid_argument("brick map cannot run rules with birth on zero neighbors: " + rule.toString());
+    }
+    this->rule = rule;
+    this->neighborhood = isNeumannNeighborhood ? Neighborhood::Neumann : Neighborhood::Moore;
+    this->generation = 0;
+    this->zero_brick.assign(BRICK_SIZE, 0);
+}
+
+uint64_t BrickMap::pack(long long bi, long long bj, long long bk) {
+    const uint64_t mask = (uint64_t(1) << AXIS_BITS) - 1;
+    return (((uint64_t)bi & mask) << (2 * AXIS_BITS)) | (((uint64_t)bj & mask) << AXIS_BITS) | ((uint64_t)bk & mask);
+}
+
+long long BrickMap::unpack(uint64_t key, int axis) {
+    // 21ビットの符号を64ビットへ広げる
+    // Sign-extend the 21-bit field to 64 bits
+    const uint64_t field = (key >> ((2 - axis) * AXIS_BITS)) & ((uint64_t(1) << AXIS_BITS) - 1);
+    return (long long)(field ^ (uint64_t(1) << (AXIS_BITS - 1))) - (1LL << (AXIS_BITS - 1));
+}
+
+uint32_t BrickMap::allocateSlot() {
+    if (!this->free_slots.empty()) {
+        const uint32_t slot = this->free_slots.back();
+        this->free_slots.pop_back();
+        return slot;
+    }
+    const uint32_t slot = (uint32_t)(this->storage.size() / BRICK_SIZE);
+    this->storage.resize(this->storage.size() + BRICK_SIZE);
+    return slot;
+}
+
+void BrickMap::freeSlot(uint32_t slot) {
+    this->free_slots.push_back(slot);
+}
+
+const uint64_t* BrickMap::findBrick(uint64_t key) const {
+    const auto found = this->bricks.find(key);
+    if (found == this->bricks.end()) return nullptr;
+    return this->storage.data() + (std::size_t)found->second * BRICK_SIZE;
+}
+
+bool BrickMap::get(long long i, long long j, long long k) const {
+    if (!fitsKey(i >> BRICK_SHIFT, j >> BRICK_SHIFT, k >> 8)) return false;
+    const uint64_t* brick = this->findBrick(brickKey(i, j, k));
+    if (brick == nullptr) return false;
+    return (brick[wordInBrick(i, j, k)] >> (k & 63)) & 1;
+}
+
+void BrickMap::set(long long i, long long j, long long k, bool alive) {
+    if (!fitsKey(i >> BRICK_SHIFT, j >> BRICK_SHIFT, k >> 8)) {
+        throw std::invalid_argument("brick map coordinate out of range: (" + std::to_string(i) + ", "
+            + std::to_string(j) + ", " + std::to_string(k) + ")");
+    }
+    const uint64_t key = brickKey(i, j, k);
+    const int w = wordInBrick(i, j, k);
+    const uint64_t bit = uint64_t(1) << (k & 63);
+    auto found = this->bricks.find(key);
+    if (found == this->bricks.end()) {
+        if (!alive) return;
+        const uint32_t slot = this->allocateSlot();
+        std::fill(this->brickAt(slot), this->brickAt(slot) + BRICK_SIZE, 0);
+        found = this->bricks.emplace(key, slot).first;
+    }
+    uint64_t* brick = this->brickAt(found->second);
+    if (alive) {
+        brick[w] |= bit;
+        return;
+    }
+    brick[w] &= ~bit;
+    if (std::all_of(brick, brick + BRICK_SIZE, [](uint64_t x) { return x == 0; })) {
+        this->freeSlot(found->second);
+        this->bricks.erase(found);
+    }
+}
+
+uint64_t BrickMap::getPopulation() const {
+    uint64_t population = 0;
+    for (const auto& entry: this->bricks) {
+        const uint64_t* brick = this->storage.data() + (std::size_t)entry.second * BRICK_SIZE;
+        for (int w = 0; w < BRICK_SIZE; w++) population += __builtin_popcountll(brick[w]);
+    }
+    return population;
+}
+
+void BrickMap::collectCandidates() {
+    // 面 (平面0/7, 行0/7, 最初のビット/最後のビット) にセルがある向きの隣だけを候補にする.
+    // 辺や角の隣は, 関係する面の両方にセルがあるときだけ (多めに拾うのは構わない)
+    // Only neighbors across a face that holds cells (plane 0/7, row 0/7, first/last bit) become
+    // candidates. Edge and corner neighbors need cells on every face involved (a superset is fine)
+    this->candidates.clear();
+    for (const auto& entry: this->bricks) {
+        const uint64_t* brick = this->storage.data() + (std::size_t)entry.second * BRICK_SIZE;
+        bool low[3] = {};
+        bool high[3] = {};
+        for (int p = 0; p < BRICK_PLANES; p++) {
+            for (int r = 0; r < BRICK_ROWS; r++) {
+                const uint64_t* row = brick + (p * BRICK_ROWS + r) * BRICK_WORDS;
+                const bool any = (row[0] | row[1] | row[2] | row[3]) != 0;
+                low[0] = low[0] || (p == 0 && any);
+                high[0] = high[0] || (p == BRICK_PLANES - 1 && any);
+                low[1] = low[1] || (r == 0 && any);
+                high[1] = high[1] || (r == BRICK_ROWS - 1 && any);
+                low[2] = low[2] || (row[0] & 1);
+                high[2] = high[2] || (row[BRICK_WORDS - 1] >> 63);
+            }
+        }
+
+        const long long bi = unpack(entry.first, 0);
+        const long long bj = unpack(entry.first, 1);
+        const long long bk = unpack(entry.first, 2);
+        for (int di = -1; di <= 1; di++) {
+            for (int dj = -1; dj <= 1; dj++) {
+                for (int dk = -1; dk <= 1; dk++) {
+                    const int d[3] = { di, dj, dk };
+                    const int distance = (di != 0) + (dj != 0) + (dk != 0);
+                    if (this->neighborhood == Neighborhood::Neumann && distance > 1) continue;
+                    bool touches = true;
+                    for (int a = 0; a < 3; a++) {
+                        if (d[a] < 0 && !low[a]) touches = false;
+                        if (d[a] > 0 && !high[a]) touches = false;
+                    }
+                    if (!touches) continue;
+                    // 場を変える前に止めるので, 投げても今の世代のまま
+                    // Stopping before anything changes leaves the current generation intact
+                    if (!fitsKey(bi + di, bj + dj, bk + dk)) {
+                        throw std::invalid_argument("brick map pattern outgrew the coordinate range at generation "
+                            + std::to_string(this->generation));
+                    }
+                    this->candidates.push_back(pack(bi + di, bj + dj, bk + dk));
+                }
+            }
+        }
+    }
+    std::sort(this->candidates.begin(), this->candidates.end());
+    this->candidates.erase(std::unique(this->candidates.begin(), this->candidates.end()), this->candidates.end());
+}
+
+void BrickMap::stepCandidate(int c, int worker) {
+    const uint64_t key = this->candidates[c];
+    const long long bi = unpack(key, 0);
+    const long long bj = unpack(key, 1);
+    const long long bk = unpack(key, 2);
+    const uint64_t* around[3][3][3];
+    for (int di = 0; di < 3; di++) {
+        for (int dj = 0; dj < 3; dj++) {
+            for (int dk = 0; dk < 3; dk++) {
+                const uint64_t* brick = this->findBrick(pack(bi + di - 1, bj + dj - 1, bk + dk - 1));
+                around[di][dj][dk] = brick != nullptr ? brick : this->zero_brick.data();
+            }
+        }
+    }
+
+    // 周り1セルを含めて集める. 行の前後のワードは隣のブリックの端のワード
+    // Gather the brick and its one-cell border. The words before and after each row are the edge
+    // words of the bricks along k
+    static const uint64_t FULL_MASK[BRICK_WORDS] = { ~uint64_t(0), ~uint64_t(0), ~uint64_t(0), ~uint64_t(0) };
+    uint64_t* next = this->brickAt(this->candidate_slots[c]);
+    this->candidate_alive[c] = this->stepper.stepBrick(this->rule, BRICK_PLANES, BRICK_ROWS, FULL_MASK, next, worker,
+        [&around](int p, int r, int di, int dj, uint64_t* row) {
+            const int offset = ((p & (BRICK_PLANES - 1)) * BRICK_ROWS + (r & (BRICK_ROWS - 1))) * BRICK_WORDS;
+            row[-1] = around[di][dj][0][offset + BRICK_WORDS - 1];
+            for (int w = 0; w < BRICK_WORDS; w++) row[w] = around[di][dj][1][offset + w];
+            row[BRICK_WORDS] = around[di][dj][2][offset];
+        });
+}
+
+void BrickMap::progressField() {
+    this->collectCandidates();
+
+    // 書き込み先を先にすべて確保しておけば, 並列に進める間は置き場が動かない
+    // Reserving every output slot up front keeps the storage from moving while bricks are stepped in parallel
+    const int n = (int)this->candidates.size();
+    this->candidate_slots.resize(n);
+    this->candidate_alive.resize(n);
+    for (int c = 0; c < n; c++) this->candidate_slots[c] = this->allocateSlot();
+
+    auto task = [this](int c, int worker) { this->stepCandidate(c, worker); };
+    this->stepper.getPool().parallelFor(n, task);
+
+    // 古いブリックを返し, 空でない結果だけを残す
+    // Release the old bricks and keep only the non-empty results
+    for (const auto& entry: this->bricks) this->freeSlot(entry.second);
+    this->bricks.clear();
+    for (int c = 0; c < n; c++) {
+        if (this->candidate_alive[c]) this->bricks.emplace(this->candidates[c], this->candidate_slots[c]);
+        else this->freeSlot(this->candidate_slots[c]);
+    }
+    this->generation++;
+}
+
+void BrickMap::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void BrickMap::loadField(const FieldView& field) {
+    for (const auto& entry: this->bricks) this->freeSlot(entry.second);
+    this->bricks.clear();
+    for (int i = 0; i < field.sizeI(); i++) {
+        for (int j = 0; j < field.sizeJ(); j++) {
+            for (int k = 0; k < field.sizeK(); k++) {
+                if (field.at(i, j, k)) this->set(i, j, k, true);
+            }
+        }
+    }
+    this->generation = field.generation();
+}
+
+void BrickMap::storeField(CA& ca) const {
+    const FieldView field = ca.getFieldView();
+    for (int i = 0; i < field.sizeI(); i++) {
+        for (int j = 0; j < field.sizeJ(); j++) {
+            for (int k = 0; k < field.sizeK(); k++) ca.setCell(i, j, k, this->get(i, j, k));
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef BRICK_MAP_H_
+#define BRICK_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "BrickStepper.h"
+#include "FieldView.h"
+#include "KernelDispatch.h"
+#include "Rule.h"
+
+class CA;
+
+// 生きたセルを含むブリックだけを持つ無限の3次元の場. ブリックの座標からブリックへのハッシュ表
+// (VDB の根にあたる) を引き, 各ブリックは CAEngine と同じ 8平面 × 8行 × 4ワードのビット列.
+// パターンが広がればブリックを足し, 空になったブリックは捨てるので, 端で切られることがない.
+// 各ブリックは BrickStepper が周り1セルを集めた局所バッファの上で密な場と同じカーネルで進める.
+// 0近傍で誕生する規則は無限に誕生が起きるので扱わない
+// Unbounded 3D field that keeps only the bricks holding live cells. A hash map from brick
+// coordinates to bricks (the VDB root level) points at bit bricks of 8 planes x 8 rows x 4 words,
+// the same bricks CAEngine tracks. Bricks are added as the pattern grows and freed once empty,
+// so nothing is clipped at an edge. Each brick is stepped by BrickStepper with the dense kernel on
+// a local buffer gathered with a one-cell border.
+// Rules with birth on zero neighbors would give births everywhere and are rejected
+class BrickMap
+{
+private:
+    static const int BRICK_SHIFT = 3;
+    static const int BRICK_PLANES = 1 << BRICK_SHIFT;
+    static const int BRICK_ROWS = 1 << BRICK_SHIFT;
+    static const int BRICK_WORDS = 4;
+    static const int BRICK_SIZE = BRICK_PLANES * BRICK_ROWS * BRICK_WORDS;
+    // ブリック座標は各軸21ビットの符号付き整数
+    // Brick coordinates are signed 21-bit integers per axis
+    static const int AXIS_BITS = 21;
+
+    Rule rule;
+    Neighborhood neighborhood;
+    BrickStepper stepper;
+    long long generation;
+
+    // BRICK_SIZE ワードずつのブリックの置き場と, 空いた場所の一覧
+    // Slots of BRICK_SIZE words each, and the list of free slots
+    std::vector<uint64_t> storage;
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<uint64_t, uint32_t> bricks;
+    // 存在しないブリックの代わりに読む空のブリック
+    // Empty brick read in place of bricks that do not exist
+    std::vector<uint64_t> zero_brick;
+
+    // 1世代分の候補ブリック: 生きたブリックと, セルが面しているその隣
+    // Candidate bricks of one generation: the live bricks and the neighbors their cells touch
+    std::vector<uint64_t> candidates;
+    std::vector<uint32_t> candidate_slots;
+    std::vector<uint8_t> candidate_alive;
+
+    static uint64_t pack(long long bi, long long bj, long long bk);
+    static long long unpack(uint64_t key, int axis);
+    // 鍵に収まるブリック座標か. 収まらない座標は詰めると別のブリックと重なる
+    // Whether brick coordinates fit in a key; those that do not would pack onto another brick
+    static bool fitsKey(long long bi, long long bj, long long bk) {
+        const long long limit = 1LL << (AXIS_BITS - 1);
+        return bi >= -limit && bi < limit && bj >= -limit && bj < limit && bk >= -limit && bk < limit;
+    }
+    // セルを含むブリックの鍵と, ブリック内のワード位置. 負の座標も算術シフトで下へ丸める
+    // Key of the brick holding a cell and the word inside it. Arithmetic shifts round negative coordinates down too
+    static uint64_t brickKey(long long i, long long j, long long k) {
+        return pack(i >> BRICK_SHIFT, j >> BRICK_SHIFT, k >> 8);
+    }
+    static int wordInBrick(long long i, long long j, long long k) {
+        return (int)(((i & (BRICK_PLANES - 1)) * BRICK_ROWS + (j & (BRICK_ROWS - 1))) * BRICK_WORDS + ((k & 255) >> 6));
+    }
+
+    uint32_t allocateSlot();
+    void freeSlot(uint32_t slot);
+    uint64_t* brickAt(uint32_t slot) { return this->storage.data() + (std::size_t)slot * BRICK_SIZE; }
+    const uint64_t* findBrick(uint64_t key) const;
+    void collectCandidates();
+    void stepCandidate(int c, int worker);
+
+public:
+    // 規則が0近傍での誕生を含むと std::invalid_argument
+    // Throws std::invalid_argument for rules with birth on zero neighbors
+    BrickMap(const Rule& rule, bool isNeumannNeighborhood);
+
+    void progressField();
+    void progressField(int generations);
+
+    // 座標は各軸 ±2^20 ブリック (i, j は ±2^23, k は ±2^28 セル) まで. 範囲外の get は偽, set は
+    // std::invalid_argument. パターンが範囲外へ広がる世代も std::invalid_argument で, 場は変わらない
+    // Coordinates reach +-2^20 bricks per axis (+-2^23 cells along i and j, +-2^28 along k). Outside
+    // that range get returns false and set throws std::invalid_argument; a generation that would grow
+    // the pattern past the range throws std::invalid_argument too and leaves the field unchanged
+    bool get(long long i, long long j, long long k) const;
+    void set(long long i, long long j, long long k, bool alive);
+
+    long long getGeneration() const { return this->generation; }
+    uint64_t getPopulation() const;
+    std::size_t getBrickCount() const { return this->bricks.size(); }
+    KernelIsa getKernelIsa() const { return this->stepper.getKernelIsa(); }
+    void setKernelIsa(KernelIsa isa) { this->stepper.setKernelIsa(isa); }
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count) { this->stepper.setThreadCount(thread_count); }
+
+    // 密な場のセル (i, j, k) を同じ座標に読み込む. それまでのセルは消え, 世代番号は場のものになる
+    // Loads the cells of a dense field at the same coordinates, replacing all cells and taking its generation
+    void loadField(const FieldView& field);
+    // [0, length)^3 の範囲を密な場へ書き出す. 範囲外のセルは書き出されない
+    // Writes the cube [0, length)^3 into a dense field. Cells outside that cube are not written
+    void storeField(CA& ca) const;
+};
+
+#endif // BRICK_MAP_H_
@@ -0,0 +1,63 @@
+#include "BrickStepper.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+BrickStepper::BrickStepper(Neighborhood neighborhood) {
+    this->neighborhood = neighborhood;
+    this->scratch_words = stepTileScratchWords(BRICK_WORDS, BRICK_ROWS);
+    this->setKernelIsa(detectKernelIsa());
+    this->setThreadCount(0);
+}
+
+void BrickStepper::setKernelIsa(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        throw std::invalid_argument(std::string("kernel not supported on this CPU: ") + kernelIsaName(isa));
+    }
+    this->kernel_isa = isa;
+    this->step_tile = selectStepTile(isa, 3, this->neighborhood);
+}
+
+void BrickStepper::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+    this->scratch.assign(this->scratch_words * thread_count, 0);
+    this->local_buffers.assign((std::size_t)LOCAL_SIZE * 2 * thread_count, 0);
+}
+
+bool BrickStepper::stepGathered(const Rule& rule, int planes, int rows, const uint64_t* mask, uint64_t* next,
+    int worker) {
+    uint64_t* local = this->localBuffer(worker);
+    StepTile tile;
+    tile.src = local + LOCAL_PLANE + LOCAL_ROW + 2;
+    tile.dst = local + LOCAL_SIZE + LOCAL_PLANE + LOCAL_ROW + 2;
+    tile.row_stride = LOCAL_ROW;
+    tile.plane_stride = LOCAL_PLANE;
+    tile.row_words = BRICK_WORDS;
+    tile.mask = mask;
+    tile.i_begin = 0;
+    tile.i_end = planes;
+    tile.j_begin = 0;
+    tile.j_end = rows;
+    tile.word_begin = 0;
+    tile.word_end = BRICK_WORDS;
+    tile.birth_mask = rule.birthMask();
+    tile.survival_mask = rule.survivalMask();
+    tile.scratch = this->scratch.data() + worker * this->scratch_words;
+    this->step_tile(tile);
+
+    // 領域外の平面と行は書かないので, 呼び出し側が0にしておいた値のまま
+    // Out-of-field planes and rows are never written and keep the zeros the caller left there
+    uint64_t any = 0;
+    for (int p = 0; p < planes; p++) {
+        for (int r = 0; r < rows; r++) {
+            const uint64_t* row = tile.dst + p * LOCAL_PLANE + r * LOCAL_ROW;
+            for (int w = 0; w < BRICK_WORDS; w++) {
+                next[(p * BRICK_ROWS + r) * BRICK_WORDS + w] = row[w];
+                any |= row[w];
+            }
+        }
+    }
+    return any != 0;
+}
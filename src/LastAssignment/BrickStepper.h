@@ -0,0 +1,83 @@
+#ifndef BRICK_STEPPER_H_
+#define BRICK_STEPPER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FieldView.h"
+#include "KernelDispatch.h"
+#include "Rule.h"
+#include "ThreadPool.h"
+
+// 8平面 × 8行 × 4ワードのブリックを1つずつ, 周り1セルを集めた局所バッファの上で行優先の場と同じ
+// カーネル (StepTile) で進める. ブリックの置き方だけが違う BrickMap と MortonEngine が共有し,
+// カーネルの選択, スレッドプールとワーカーごとのバッファを持つ
+// Steps bricks of 8 planes x 8 rows x 4 words one at a time on a local buffer gathered with a
+// one-cell border, using the same kernel (StepTile) as the row-major field. Shared by BrickMap and
+// MortonEngine, which differ only in where bricks live; owns the kernel choice, the thread pool
+// and the per-worker buffers
+class BrickStepper
+{
+public:
+    static const int BRICK_PLANES = FieldView::BRICK_PLANES;
+    static const int BRICK_ROWS = FieldView::BRICK_ROWS;
+    static const int BRICK_WORDS = FieldView::BRICK_WORDS;
+
+private:
+    // 局所バッファ: 前後1平面, 上下1行, 行の両側に1ワードずつ (行は8ワード刻み)
+    // Local buffer: one plane and one row of border each way and one word on each side of a row (rows 8 words apart)
+    static const int LOCAL_ROW = 8;
+    static const int LOCAL_PLANE = (BRICK_ROWS + 2) * LOCAL_ROW;
+    static const int LOCAL_SIZE = (BRICK_PLANES + 2) * LOCAL_PLANE;
+
+    Neighborhood neighborhood;
+    KernelIsa kernel_isa;
+    StepTileFn step_tile;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<uint64_t> scratch;
+    std::size_t scratch_words;
+    // ワーカーごとに入力と出力の2枚
+    // Two per worker, for input and output
+    std::vector<uint64_t> local_buffers;
+
+    uint64_t* localBuffer(int worker) { return this->local_buffers.data() + (std::size_t)worker * 2 * LOCAL_SIZE; }
+    bool stepGathered(const Rule& rule, int planes, int rows, const uint64_t* mask, uint64_t* next, int worker);
+
+public:
+    explicit BrickStepper(Neighborhood neighborhood);
+
+    KernelIsa getKernelIsa() const { return this->kernel_isa; }
+    // CPUが対応していない命令セットは std::invalid_argument
+    // Throws std::invalid_argument for an ISA the CPU does not support
+    void setKernelIsa(KernelIsa isa);
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count);
+    ThreadPool& getPool() { return *this->pool; }
+
+    // gather(p, r, di, dj, row) で平面 p ∈ [-1, planes], 行 r ∈ [-1, rows] を集めてから1世代進め,
+    // 領域内の平面と行を next (ブリックの並び) に書く. di, dj はその平面と行が前 (0), 自分 (1),
+    // 後 (2) のどのブリックに入るか. row[-1] の上端ビットと row[BRICK_WORDS] の下端ビットが k 方向の隣.
+    // mask は1行分の領域内のビット. 次世代に生きたセルがあれば真
+    // Gathers planes p in [-1, planes] and rows r in [-1, rows] with gather(p, r, di, dj, row), steps one
+    // generation and writes the in-field planes and rows to next (brick order). di and dj tell whether the
+    // plane and row fall in the brick before (0), the own brick (1) or the one after (2). The top bit of
+    // row[-1] and the low bits of row[BRICK_WORDS] are the neighbors along k. mask holds one row's in-field
+    // bits. Returns whether the next generation has live cells
+    template <typename Gather>
+    bool stepBrick(const Rule& rule, int planes, int rows, const uint64_t* mask, uint64_t* next, int worker,
+        Gather gather) {
+        uint64_t* local = this->localBuffer(worker);
+        for (int p = -1; p <= planes; p++) {
+            const int di = p < 0 ? 0 : (p < planes ? 1 : 2);
+            for (int r = -1; r <= rows; r++) {
+                const int dj = r < 0 ? 0 : (r < rows ? 1 : 2);
+                gather(p, r, di, dj, local + (p + 1) * LOCAL_PLANE + (r + 1) * LOCAL_ROW + 2);
+            }
+        }
+        return this->stepGathered(rule, planes, rows, mask, next, worker);
+    }
+};
+
+#endif // BRICK_STEPPER_H_
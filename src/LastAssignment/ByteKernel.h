@@ -0,0 +1,124 @@
+#ifndef BYTE_KERNEL_H_
+#define BYTE_KERNEL_H_
+
+#include <cstdint>
+#include <cstring>
+#include "KernelDispatch.h"
+
+// 1セル1バイトの状態を持つ Generations 規則のカーネル. V は uint8_t か, GCCのベクトル拡張型
+// (32バイトを同時に扱う). 状態が1の近傍をバイトの比較で数え, 減衰も同じ幅のまま進める.
+// BitKernel.h と同じ理由で関数はすべて static にする
+// Kernel for Generations rules with a one-byte state per cell. V is uint8_t or a GCC vector-extension
+// type covering 32 bytes at once. Neighbors in state 1 are counted with byte compares, and decay
+// advances at the same width. Every function is static for the same reason as in BitKernel.h
+namespace bytekernel {
+
+template <typename V>
+static inline V load(const uint8_t* p) {
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template <typename V>
+static inline void store(uint8_t* p, V v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+template <typename V>
+static inline V splat(uint8_t x) {
+    V v;
+    std::memset(&v, x, sizeof(V));
+    return v;
+}
+
+// 一致するバイトを 0xFF, それ以外を 0 にする
+// 0xFF where the bytes match, 0 elsewhere
+static inline uint8_t equalMask(uint8_t a, uint8_t b) {
+    return a == b ? 0xFF : 0;
+}
+
+template <typename V>
+static inline V equalMask(V a, V b) {
+    return (V)(a == b);
+}
+
+// 近傍数 (0..26) ごとの値を32バイトの表から引く. ベクトル版はバイトの並べ替えになる
+// Looks up a per-count (0..26) value in a 32-byte table. The vector version becomes a byte shuffle
+static inline uint8_t lookup(const uint8_t* table, uint8_t count) {
+    return table[count];
+}
+
+template <typename V>
+static inline V lookup(const uint8_t* table, V count) {
+    static_assert(sizeof(V) == 32, "the table holds 32 entries");
+    return __builtin_shuffle(load<V>(table), count);
+}
+
+template <typename V, int Dim, Neighborhood N>
+static void stepGenerationsTile(const GenerationsTile& tile) {
+    const int WIDTH = (int)sizeof(V);
+    alignas(32) uint8_t born_table[32] = {};
+    alignas(32) uint8_t survive_table[32] = {};
+    for (int c = 0; c <= 26; c++) {
+        born_table[c] = (tile.birth_mask >> c) & 1;
+        survive_table[c] = (tile.survival_mask >> c) & 1 ? 0xFF : 0;
+    }
+    const V zero = splat<V>(0);
+    const V one = splat<V>(1);
+    const V states = splat<V>((uint8_t)tile.states);
+    const std::ptrdiff_t rs = tile.row_stride;
+    const std::ptrdiff_t ps = tile.plane_stride;
+
+    for (int i = tile.i_begin; i < tile.i_end; i++) {
+        for (int j = tile.j_begin; j < tile.j_end; j++) {
+            const uint8_t* row = tile.src + i * ps + j * rs;
+            uint8_t* out = tile.dst + i * ps + j * rs;
+            for (int k = 0; k < tile.k_end; k += WIDTH) {
+                const uint8_t* p = row + k;
+                // 0xFF を引くと1増える
+                // Subtracting 0xFF adds one
+                V count = zero;
+                if (N == Neighborhood::Moore) {
+                    #pragma GCC unroll 3
+                    for (int di = (Dim == 3 ? -1 : 0); di <= (Dim == 3 ? 1 : 0); di++) {
+                        #pragma GCC unroll 3
+                        for (int dj = -1; dj <= 1; dj++) {
+                            #pragma GCC unroll 3
+                            for (int dk = -1; dk <= 1; dk++) {
+                                if (di == 0 && dj == 0 && dk == 0) continue;
+                                count -= equalMask(load<V>(p + di * ps + dj * rs + dk), one);
+                            }
+                        }
+                    }
+                } else {
+                    count -= equalMask(load<V>(p - 1), one);
+                    count -= equalMask(load<V>(p + 1), one);
+                    count -= equalMask(load<V>(p - rs), one);
+                    count -= equalMask(load<V>(p + rs), one);
+                    if (Dim == 3) {
+                        count -= equalMask(load<V>(p - ps), one);
+                        count -= equalMask(load<V>(p + ps), one);
+                    }
+                }
+
+                // 生きたセルは生存条件を満たせば1のまま, それ以外の0でないセルは1つ進み states で0に戻る.
+                // 死んだセルは誕生条件を満たせば1
+                // Live cells meeting the survival condition stay 1; every other non-zero cell advances one
+                // state, wrapping to 0 at states. Dead cells meeting the birth condition become 1
+                const V center = load<V>(p);
+                const V dead = equalMask(center, zero);
+                const V keep = equalMask(center, one) & lookup(survive_table, count);
+                V next = center + one;
+                next &= ~equalMask(next, states);
+                next = (keep & one) | (~keep & next);
+                next = (dead & lookup(born_table, count)) | (~dead & next);
+                store<V>(out + k, next);
+            }
+        }
+    }
+}
+
+}
+
+#endif // BYTE_KERNEL_H_
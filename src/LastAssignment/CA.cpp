@@ -1,25 +1,32 @@
 #include "CA.h"
+#include <utility>
 
 CA::CA(int length,
     const std::vector<int> birth_condition,
     const std::vector<int> alive_condition, 
     float init_alive_ratio, 
     bool isNeumannNeighborhood, 
+    bool isTorus)
+    : CA(length, Rule(birth_condition, alive_condition), init_alive_ratio, isNeumannNeighborhood, isTorus) {}
+
+CA::CA(int length,
+    const std::string& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
+    bool isTorus)
+    : CA(length, Rule::parse(rule), init_alive_ratio, isNeumannNeighborhood, isTorus) {}
+
+CA::CA(int length,
+    const Rule& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
     bool isTorus) {
     this->length = length;
-    this->birth_condition = birth_condition;
-    this->alive_condition = alive_condition;
     this->init_alive_ratio = init_alive_ratio;
     this->isNeumannNeighborhood = isNeumannNeighborhood;
     this->isTorus = isTorus;
-
-    this->field = std::vector<std::vector<std::vector<bool>>>(
-        this->length, std::vector<std::vector<bool>>(
-            this->length, std::vector<bool>(
-                this->length, false
-            )
-        )
-    );
+    this->engine_kind = EngineKind::Bitwise;
+    this->engine = makeCAEngine(3, this->length, rule, this->isNeumannNeighborhood, this->isTorus);
 
     std::random_device rnd;
     std::default_random_engine eng(rnd());
@@ -28,84 +35,22 @@ CA::CA(int length,
     for (int i = 0; i < this->length; i++) {
         for (int j = 0; j < this->length; j++) {
             for (int k = 0; k < this->length; k++) {
-                if (distr(eng) <= this->init_alive_ratio){
-                    this->field[i][j][k] = true;
-                } else {
-                    this->field[i][j][k] = false;
-                }
+                this->engine->set(i, j, k, distr(eng) <= this->init_alive_ratio);
             }
         }   
     }
 }
 
-bool CA::isNextAliveWhenNeumann(const int fi, const int fj, const int fk) {
-    int count_alive = 0;
-
-    for(int di = -1; di <= 1; di += 2) {
-        if((fi + di < 0 || fi + di >= this->length) && !isTorus) continue;
-        int i = (fi + this->length + di) % this->length;
-        if(this->field[i][fj][fk]) count_alive++;
-    }
-
-    for(int dj = -1; dj <= 1; dj += 2) {
-        if((fj + dj < 0 || fj + dj >= this->length) && !isTorus) continue;
-        int j = (fj + this->length + dj) % this->length;
-        if(this->field[fi][j][fk]) count_alive++;
-    }
-
-    for(int dk = -1; dk <= 1; dk += 2) {
-        if((fk + dk < 0 || fk + dk >= this->length) && !isTorus) continue;
-        int k = (fk + this->length + dk) % this->length;
-        if(this->field[fi][fj][k]) count_alive++;
-    }
-
-    if (this->field[fi][fj][fk]) {
-        for(const int alive_num: this->alive_condition) {
-            if(count_alive == alive_num) return true;
-        }
-    } else {
-        for(const int birth_num: this->birth_condition) {
-            if(count_alive == birth_num) return true;
-        }
-    }
-
-    return false;
-}
-
-bool CA::isNextAliveWhenMoore(const int fi, const int fj, const int fk) {
-    int count_alive = 0;
-
-    for(int di = -1; di <= 1; di++){
-        for(int dj = -1; dj <= 1; dj++) {
-            for(int dk = -1; dk <= 1; dk++) {
-                if(di == 0 && dj == 0 && dk == 0) continue;
-                if((fi + di < 0 || fi + di >= this->length ||
-                    fj + dj < 0 || fj + dj >= this->length ||
-                    fk + dk < 0 || fk + dk >= this->length) && !isTorus) {
-                    continue;
-                }
-                int i = (fi + this->length + di) % this->length;
-                int j = (fj + this->length + dj) % this->length;
-                int k = (fk + this->length + dk) % this->length;
-                if(this->field[i][j][k]) count_alive++;
-            }
-        }
-    }
+void CA::progressField() {
+    this->engine->progressField();
+}
 
-    if (this->field[fi][fj][fk]) {
-        for(const int alive_num: this->alive_condition) {
-            if(count_alive == alive_num) return true;
-        }
-    } else {
-        for(const int birth_num: this->birth_condition) {
-            if(count_alive == birth_num) return true;
-        }
-    }
-    return false;
+void CA::progressField(int generations) {
+    this->engine->progressField(generations);
 }
 
-void CA::progressField() {
-    auto next_field = std::vector<std::vector<std::vector<bool>>>(
+std::vector<std::vector<std::vector<bool>>> CA::getField() {
+    auto nested = std::vector<std::vector<std::vector<bool>>>(
         this->length, std::vector<std::vector<bool>>(
             this->length, std::vector<bool>(
                 this->length, false
@@ -113,21 +58,109 @@ void CA::progressField() {
         )
     );
 
-    for(int i = 0; i < this->length; i++) {
-        for(int j = 0; j < this->length; j++) {
-            for(int k = 0; k < this->length; k++) {
-                if(this->isNeumannNeighborhood) {
-                    next_field[i][j][k] = this->isNextAliveWhenNeumann(i, j, k);
-                } else {
-                    next_field[i][j][k] = this->isNextAliveWhenMoore(i, j, k);
-                }
+    for (int i = 0; i < this->length; i++) {
+        for (int j = 0; j < this->length; j++) {
+            for (int k = 0; k < this->length; k++) {
+                nested[i][j][k] = this->engine->get(i, j, k);
             }
         }
     }
 
-    std::swap(field, next_field);
+    return nested;
+};
+
+FieldView CA::getFieldView() const {
+    return this->engine->getFieldView();
 }
 
-std::vector<std::vector<std::vector<bool>>> CA::getField() {
-    return this->field;
-};
\ No newline at end of file
+void CA::setCell(int i, int j, int k, bool alive) {
+    this->engine->set(i, j, k, alive);
+}
+
+long long CA::getGeneration() const {
+    return this->engine->getGeneration();
+}
+
+KernelIsa CA::getKernelIsa() const {
+    return this->engine->getKernelIsa();
+}
+
+void CA::setKernelIsa(KernelIsa isa) {
+    this->engine->setKernelIsa(isa);
+}
+
+int CA::getThreadCount() const {
+    return this->engine->getThreadCount();
+}
+
+void CA::setThreadCount(int thread_count) {
+    this->engine->setThreadCount(thread_count);
+}
+
+std::vector<double> CA::getThreadBusySeconds() const {
+    return this->engine->getThreadBusySeconds();
+}
+
+void CA::resetThreadStats() {
+    this->engine->resetThreadStats();
+}
+
+void CA::setTileSchedule(ThreadPool::Schedule schedule) {
+    this->engine->setTileSchedule(schedule);
+}
+
+double CA::getLoadImbalance() const {
+    return this->engine->getLoadImbalance();
+}
+
+void CA::setBrickSkipping(bool enabled) {
+    this->engine->setBrickSkipping(enabled);
+}
+
+double CA::getActiveBrickFraction() const {
+    return this->engine->getActiveBrickFraction();
+}
+
+GenerationStats CA::getGenerationStats() const {
+    return this->engine->getGenerationStats();
+}
+
+void CA::setStatsCollection(bool enabled) {
+    this->engine->setStatsCollection(enabled);
+}
+
+void CA::setNeighborHistogram(bool enabled) {
+    this->engine->setNeighborHistogram(enabled);
+}
+
+void CA::setCycleDetection(bool enabled) {
+    this->engine->setCycleDetection(enabled);
+}
+
+void CA::setCycleAction(CycleAction action) {
+    this->engine->setCycleAction(action);
+}
+
+const CycleInfo& CA::getCycle() const {
+    return this->engine->getCycle();
+}
+
+EngineKind CA::getEngineKind() const {
+    return this->engine_kind;
+}
+
+void CA::setEngineKind(EngineKind kind) {
+    auto next = makeCAEngine(3, this->length, this->engine->getRule(),
+        this->isNeumannNeighborhood, this->isTorus, kind, this->engine->getThreadCount());
+    next->copyStateFrom(*this->engine);
+    next->setKernelIsa(this->engine->getKernelIsa());
+    next->setBrickSkipping(this->engine->getBrickSkipping());
+    next->setTileSchedule(this->engine->getTileSchedule());
+    next->setStatsCollection(this->engine->getStatsCollection());
+    next->setNeighborHistogram(this->engine->getNeighborHistogram());
+    next->setCycleHistory(this->engine->getCycleHistory());
+    next->setCycleDetection(this->engine->getCycleDetection());
+    next->setCycleAction(this->engine->getCycleAction());
+    this->engine = std::move(next);
+    this->engine_kind = kind;
+}
\ No newline at end of file
@@ -4,19 +4,24 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <string>
+#include <memory>
+#include "CAEngine.h"
+#include "CycleDetector.h"
+#include "FieldView.h"
+#include "GenerationStats.h"
+#include "KernelDispatch.h"
+#include "Rule.h"
 
 class CA
 {
 private:
     int length;
-    std::vector<int> birth_condition;
-    std::vector<int> alive_condition;
     float init_alive_ratio;
     bool isNeumannNeighborhood;
     bool isTorus;
-    std::vector<std::vector<std::vector<bool>>> field;
-    bool isNextAliveWhenNeumann(const int fi, const int fj, const int fk);
-    bool isNextAliveWhenMoore(const int fi, const int fj, const int fk);
+    EngineKind engine_kind;
+    std::unique_ptr<CAEngineBase> engine;
 
 public:
     CA(int length, 
@@ -25,8 +30,52 @@ public:
     float init_alive_ratio, 
     bool isNeumannNeighborhood, 
     bool isTorus);
+    CA(int length,
+    const std::string& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
+    bool isTorus);
+    CA(int length,
+    const Rule& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
+    bool isTorus);
     void progressField();
+    // n世代まとめて進める. n回の progressField() と同じ結果
+    // Advances n generations at once, with the same result as n calls to progressField()
+    void progressField(int generations);
     std::vector<std::vector<std::vector<bool>>> getField();
+    FieldView getFieldView() const;
+    // セル (i, j, k) を直接書き換える
+    // Overwrites cell (i, j, k) directly
+    void setCell(int i, int j, int k, bool alive);
+    long long getGeneration() const;
+    KernelIsa getKernelIsa() const;
+    void setKernelIsa(KernelIsa isa);
+    int getThreadCount() const;
+    void setThreadCount(int thread_count);
+    std::vector<double> getThreadBusySeconds() const;
+    void resetThreadStats();
+    void setTileSchedule(ThreadPool::Schedule schedule);
+    double getLoadImbalance() const;
+    void setBrickSkipping(bool enabled);
+    double getActiveBrickFraction() const;
+    // 直前の世代の統計. 個体数, 誕生数, 死亡数, 範囲と (有効なら) 近傍数の分布
+    // Statistics of the last generation: population, births, deaths, bounding box and, when enabled,
+    // the neighbor-count histogram
+    GenerationStats getGenerationStats() const;
+    void setStatsCollection(bool enabled);
+    void setNeighborHistogram(bool enabled);
+    // 場が前の世代に戻ったら周期として報告し, 動作に従って止めるか周期の倍数を飛ばす
+    // Reports a return to an earlier field as a cycle, then stops or skips whole periods as the action says
+    void setCycleDetection(bool enabled);
+    void setCycleAction(CycleAction action);
+    const CycleInfo& getCycle() const;
+    EngineKind getEngineKind() const;
+    // 今のセルと世代番号, スレッド数やカーネルなどの設定を引き継いで更新方式を切り替える
+    // Switches the stepping engine, carrying over the current cells, generation and settings such as
+    // the thread count and kernel
+    void setEngineKind(EngineKind kind);
 };
 
 #endif // CA_H_
\ No newline at end of file
@@ -1,23 +1,32 @@
 #include "CA2D.h"
+#include <utility>
 
 CA2D::CA2D(int length,
     const std::vector<int> birth_condition,
     const std::vector<int> alive_condition, 
     float init_alive_ratio, 
     bool isNeumannNeighborhood, 
+    bool isTorus)
+    : CA2D(length, Rule(birth_condition, alive_condition), init_alive_ratio, isNeumannNeighborhood, isTorus) {}
+
+CA2D::CA2D(int length,
+    const std::string& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
+    bool isTorus)
+    : CA2D(length, Rule::parse(rule), init_alive_ratio, isNeumannNeighborhood, isTorus) {}
+
+CA2D::CA2D(int length,
+    const Rule& rule,
+    float init_alive_ratio,
+    bool isNeumannNeighborhood,
     bool isTorus) {
     this->length = length;
-    this->birth_condition = birth_condition;
-    this->alive_condition = alive_condition;
     this->init_alive_ratio = init_alive_ratio;
     this->isNeumannNeighborhood = isNeumannNeighborhood;
     this->isTorus = isTorus;
-
-    this->field = std::vector<std::vector<bool>>(
-        this->length, std::vector<bool>(
-            this->length, false
-        )
-    );
+    this->engine_kind = EngineKind::Bitwise;
+    this->engine = makeCAEngine(2, this->length, rule, this->isNeumannNeighborhood, this->isTorus);
 
     std::random_device rnd;
     std::default_random_engine eng(rnd());
@@ -25,92 +34,123 @@ CA2D::CA2D(int length,
 
     for (int i = 0; i < this->length; i++) {
         for (int j = 0; j < this->length; j++) {
-            if (distr(eng) <= this->init_alive_ratio){
-                this->field[i][j] = true;
-            } else {
-                this->field[i][j] = false;
-            }
+            this->engine->set(0, i, j, distr(eng) <= this->init_alive_ratio);
         }   
     }
 }
 
-bool CA2D::isNextAliveWhenNeumann(const int fi, const int fj) {
-    int count_alive = 0;
+void CA2D::progressField() {
+    this->engine->progressField();
+}
 
-    for(int di = -1; di <= 1; di += 2) {
-        if((fi + di < 0 || fi + di >= this->length) && !isTorus) continue;
-        int i = (fi + this->length + di) % this->length;
-        if(this->field[i][fj]) count_alive++;
-    }
+void CA2D::progressField(int generations) {
+    this->engine->progressField(generations);
+}
 
-    for(int dj = -1; dj <= 1; dj += 2) {
-        if((fj + dj < 0 || fj + dj >= this->length) && !isTorus) continue;
-        int j = (fj + this->length + dj) % this->length;
-        if(this->field[fi][j]) count_alive++;
-    }
+std::vector<std::vector<bool>> CA2D::getField() {
+    auto nested = std::vector<std::vector<bool>>(
+        this->length, std::vector<bool>(
+            this->length, false
+        )
+    );
 
-    if (this->field[fi][fj]) {
-        for(const int alive_num: this->alive_condition) {
-            if(count_alive == alive_num) return true;
-        }
-    } else {
-        for(const int birth_num: this->birth_condition) {
-            if(count_alive == birth_num) return true;
+    for (int i = 0; i < this->length; i++) {
+        for (int j = 0; j < this->length; j++) {
+            nested[i][j] = this->engine->get(0, i, j);
         }
     }
 
-    return false;
+    return nested;
+};
+
+FieldView CA2D::getFieldView() const {
+    return this->engine->getFieldView();
 }
 
-bool CA2D::isNextAliveWhenMoore(const int fi, const int fj) {
-    int count_alive = 0;
+long long CA2D::getGeneration() const {
+    return this->engine->getGeneration();
+}
 
-    for(int di = -1; di <= 1; di++){
-        for(int dj = -1; dj <= 1; dj++) {
-            if(di == 0 && dj == 0) continue;
-            if((fi + di < 0 || fi + di >= this->length ||
-                fj + dj < 0 || fj + dj >= this->length) && !isTorus) {
-                continue;
-            }
-            int i = (fi + this->length + di) % this->length;
-            int j = (fj + this->length + dj) % this->length;
-            if(this->field[i][j]) count_alive++;
-        }
-    }
+KernelIsa CA2D::getKernelIsa() const {
+    return this->engine->getKernelIsa();
+}
 
-    if (this->field[fi][fj]) {
-        for(const int alive_num: this->alive_condition) {
-            if(count_alive == alive_num) return true;
-        }
-    } else {
-        for(const int birth_num: this->birth_condition) {
-            if(count_alive == birth_num) return true;
-        }
-    }
+void CA2D::setKernelIsa(KernelIsa isa) {
+    this->engine->setKernelIsa(isa);
+}
 
-    return false;
+int CA2D::getThreadCount() const {
+    return this->engine->getThreadCount();
 }
 
-void CA2D::progressField() {
-    auto next_field = std::vector<std::vector<bool>>(
-            this->length, std::vector<bool>(
-                this->length, false
-            )
-        );
-
-    for(int i = 0; i < this->length; i++) {
-        for(int j = 0; j < this->length; j++) {
-            if(this->isNeumannNeighborhood) {
-                next_field[i][j] = this->isNextAliveWhenNeumann(i, j);
-            } else {
-                next_field[i][j] = this->isNextAliveWhenMoore(i, j);
-            }
-        }
-    }
+void CA2D::setThreadCount(int thread_count) {
+    this->engine->setThreadCount(thread_count);
+}
 
-    std::swap(field, next_field);
+std::vector<double> CA2D::getThreadBusySeconds() const {
+    return this->engine->getThreadBusySeconds();
 }
 
-std::vector<std::vector<bool>> CA2D::getField() {
-    return this->field;
-};
\ No newline at end of file
+void CA2D::resetThreadStats() {
+    this->engine->resetThreadStats();
+}
+
+void CA2D::setTileSchedule(ThreadPool::Schedule schedule) {
+    this->engine->setTileSchedule(schedule);
+}
+
+double CA2D::getLoadImbalance() const {
+    return this->engine->getLoadImbalance();
+}
+
+void CA2D::setBrickSkipping(bool enabled) {
+    this->engine->setBrickSkipping(enabled);
+}
+
+double CA2D::getActiveBrickFraction() const {
+    return this->engine->getActiveBrickFraction();
+}
+
+GenerationStats CA2D::getGenerationStats() const {
+    return this->engine->getGenerationStats();
+}
+
+void CA2D::setStatsCollection(bool enabled) {
+    this->engine->setStatsCollection(enabled);
+}
+
+void CA2D::setNeighborHistogram(bool enabled) {
+    this->engine->setNeighborHistogram(enabled);
+}
+
+void CA2D::setCycleDetection(bool enabled) {
+    this->engine->setCycleDetection(enabled);
+}
+
+void CA2D::setCycleAction(CycleAction action) {
+    this->engine->setCycleAction(action);
+}
+
+const CycleInfo& CA2D::getCycle() const {
+    return this->engine->getCycle();
+}
+
+EngineKind CA2D::getEngineKind() const {
+    return this->engine_kind;
+}
+
+void CA2D::setEngineKind(EngineKind kind) {
+    auto next = makeCAEngine(2, this->length, this->engine->getRule(),
+        this->isNeumannNeighborhood, this->isTorus, kind, this->engine->getThreadCount());
+    next->copyStateFrom(*this->engine);
+    next->setKernelIsa(this->engine->getKernelIsa());
+    next->setBrickSkipping(this->engine->getBrickSkipping());
+    next->setTileSchedule(this->engine->getTileSchedule());
+    next->setStatsCollection(this->engine->getStatsCollection());
+    next->setNeighborHistogram(this->engine->getNeighborHistogram());
+    next->setCycleHistory(this->engine->getCycleHistory());
+    next->setCycleDetection(this->engine->getCycleDetection());
+    next->setCycleAction(this->engine->getCycleAction());
+    this->engine = std::move(next);
+    this->engine_kind = kind;
+}
\ No newline at end of file
@@ -0,0 +1,728 @@
+#include "CAEngine.h"
+#include "EventEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+CAEngineBase::CAEngineBase(const Rule& rule, const BitField& shape, int dim, Neighborhood neighborhood, int thread_count,
+    bool kernel_stepping) {
+    this->rule = rule;
+    this->field = shape;
+    if (kernel_stepping) this->next_field = shape;
+    this->kernel_stepping = kernel_stepping;
+    this->interior_mask = shape.interiorMask();
+    this->generation = 0;
+    this->dim = dim;
+    this->neighborhood = neighborhood;
+    this->scratch_words = stepTileScratchWords(shape.rowWords(), STEP_TILE_ROWS);
+    this->tile_schedule = ThreadPool::Schedule::Stealing;
+    this->block_edge = dim == 3 ? 64 : 256;
+    this->brick_skipping = true;
+    this->bricks_i = dim == 3 ? (shape.sizeI() + BRICK_PLANES - 1) / BRICK_PLANES : 1;
+    this->bricks_j = (shape.sizeJ() + BRICK_ROWS - 1) / BRICK_ROWS;
+    this->bricks_k = shape.rowWords() / BRICK_WORDS;
+    const std::size_t bricks = (std::size_t)this->bricks_i * this->bricks_j * this->bricks_k;
+    this->brick_changed.assign(bricks, 1);
+    this->brick_active.assign(bricks, 1);
+    this->brick_spread.assign(bricks, 1);
+    this->active_fraction = 1.0;
+    this->stats_enabled = false;
+    this->histogram_enabled = false;
+    this->stats_generation = -1;
+    this->population = 0;
+    if (kernel_stepping) this->brick_or.assign(bricks * BRICK_WORDS, 0);
+    this->cycle_detection = false;
+    this->cycle_action = CycleAction::Continue;
+    this->hash_generation = -1;
+    this->edited = true;
+    this->setKernelIsa(detectKernelIsa());
+    this->setThreadCount(thread_count);
+}
+
+void CAEngineBase::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->thread_count = thread_count;
+    this->stats_generation = -1;
+    if (!this->kernel_stepping) {
+        this->pool = std::make_unique<ThreadPool>(1);
+        this->worker_stats.assign(1, WorkerStats{});
+        this->worker_hash.assign(1, FieldHash());
+        return;
+    }
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+    this->pool->setSchedule(this->tile_schedule);
+    this->scratch.assign(this->scratch_words * thread_count, 0);
+    this->worker_stats.assign(thread_count, WorkerStats{});
+    this->worker_hash.assign(thread_count, FieldHash());
+
+    // 帯だけでスレッドが余るときはi方向にも切る. 厚板の境目ではリングを詰め直す分だけ余計に読む
+    // Cut along i as well when bands alone leave threads idle; each slab boundary re-primes the rings
+    const int nj = this->field.sizeJ();
+    this->tile_bands = (nj + STEP_TILE_ROWS - 1) / STEP_TILE_ROWS;
+    const int wanted = thread_count == 1 ? 1 : 4 * thread_count;
+    this->tile_slabs = std::max(1, std::min(this->maxSlabs(), (wanted + this->tile_bands - 1) / this->tile_bands));
+    this->tile_cost.assign((std::size_t)this->tile_bands * this->maxSlabs(), 1.0);
+
+    const std::size_t rows = (std::size_t)(this->block_edge + 2 * BLOCK_STEPS)
+        * (this->dim == 3 ? this->block_edge + 2 * BLOCK_STEPS : 1);
+    this->block_words = rows * this->field.rowWords() + 2 * BitField::GUARD_WORDS;
+    this->block_buffers.assign(this->block_words * 2 * thread_count, 0);
+}
+
+void CAEngineBase::setTileSchedule(ThreadPool::Schedule schedule) {
+    this->tile_schedule = schedule;
+    this->pool->setSchedule(schedule);
+}
+
+int CAEngineBase::maxSlabs() const {
+    return std::max(1, this->field.sizeI() / MIN_SLAB_PLANES);
+}
+
+int CAEngineBase::slabBegin(int slab) const {
+    const int ni = this->field.sizeI();
+    if (slab >= this->tile_slabs) return ni;
+    // 厚板は MIN_SLAB_PLANES 以上の厚さなので, ブリック境界へ切り下げても空にならない
+    // Slabs are at least MIN_SLAB_PLANES thick, so rounding down to a brick boundary never empties one
+    return (int)((long long)ni * slab / this->tile_slabs) / BRICK_PLANES * BRICK_PLANES;
+}
+
+void CAEngineBase::setBrickSkipping(bool enabled) {
+    this->brick_skipping = enabled;
+    std::fill(this->brick_changed.begin(), this->brick_changed.end(), 1);
+    this->active_fraction = 1.0;
+}
+
+void CAEngineBase::setStatsCollection(bool enabled) {
+    this->stats_enabled = enabled;
+    this->stats_generation = -1;
+    // 集めていない間のブリックの統計は古いので, 次の世代ですべて数え直させる
+    // Brick statistics went stale while collection was off, so have every brick recounted next generation
+    std::fill(this->brick_changed.begin(), this->brick_changed.end(), 1);
+}
+
+void CAEngineBase::setNeighborHistogram(bool enabled) {
+    this->histogram_enabled = enabled;
+    this->stats_generation = -1;
+}
+
+void CAEngineBase::setKernelIsa(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        throw std::invalid_argument(std::string("kernel not supported on this CPU: ") + kernelIsaName(isa));
+    }
+    this->kernel_isa = isa;
+    this->step_tile = selectStepTile(isa, this->dim, this->neighborhood);
+}
+
+StepTile CAEngineBase::makeTile(int i_begin, int i_end, int j_begin, int j_end, int worker) {
+    StepTile tile;
+    tile.src = this->field.row(0, 0);
+    tile.dst = this->next_field.row(0, 0);
+    tile.row_stride = this->field.rowWords();
+    tile.plane_stride = this->field.planeWords();
+    tile.row_words = this->field.rowWords();
+    tile.mask = this->interior_mask.data();
+    tile.i_begin = i_begin;
+    tile.i_end = i_end;
+    tile.j_begin = j_begin;
+    tile.j_end = j_end;
+    tile.word_begin = 0;
+    tile.word_end = this->field.rowWords();
+    tile.birth_mask = this->rule.birthMask();
+    tile.survival_mask = this->rule.survivalMask();
+    tile.scratch = this->scratch.data() + worker * this->scratch_words;
+    if (this->stats_enabled) {
+        tile.brick_or = this->brick_or.data();
+        tile.bricks_j = this->bricks_j;
+        tile.worker_stats = &this->worker_stats[worker];
+        tile.histogram = this->histogram_enabled;
+    }
+    return tile;
+}
+
+void CAEngineBase::stepTiles(bool isTorus) {
+    if (this->stats_enabled) {
+        // 個体数は前の世代から引き継ぐので, 前の世代の統計が無ければ数え直す
+        // The population carries over from the previous generation, so recount it when that one has no statistics
+        if (this->stats_generation != this->generation) this->population = this->scanField().population;
+        std::fill(this->worker_stats.begin(), this->worker_stats.end(), WorkerStats{});
+    }
+    const bool histogram = this->stats_enabled && this->histogram_enabled;
+    this->active_fraction = this->brick_skipping ? this->spreadChanges(isTorus) : 1.0;
+    if (this->brick_skipping && this->active_fraction <= DENSE_ACTIVE_FRACTION && !histogram) {
+        auto column = [this](int c, int worker) { this->stepActiveColumn(c, worker); };
+        this->pool->parallelFor(this->bricks_j * this->bricks_k, column);
+        return;
+    }
+
+    // 各セルは同じ入力から同じ順に計算されるので, 分割の仕方は結果に影響しない
+    // Every cell is computed from the same inputs in the same way, so the split never changes the result
+    const int nj = this->field.sizeJ();
+    auto task = [this, nj](int t, int worker) {
+        const int band = t % this->tile_bands;
+        const int slab = t / this->tile_bands;
+        const int j = band * STEP_TILE_ROWS;
+        const int j_end = j + STEP_TILE_ROWS < nj ? j + STEP_TILE_ROWS : nj;
+        const int i = this->slabBegin(slab);
+        const int i_end = this->slabBegin(slab + 1);
+        const auto start = std::chrono::steady_clock::now();
+        this->step_tile(this->makeTile(i, i_end, j, j_end, worker));
+        if (this->brick_skipping) this->markChanged(i, i_end, j, j_end, 0, this->field.rowWords());
+        this->tile_cost[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    this->pool->parallelFor(this->tile_bands * this->tile_slabs, task, this->tile_cost.data());
+    this->adaptTiles();
+}
+
+void CAEngineBase::adaptTiles() {
+    if (this->pool->threadCount() == 1) return;
+    const int tiles = this->tile_bands * this->tile_slabs;
+    double total = 0;
+    double largest = 0;
+    for (int t = 0; t < tiles; t++) {
+        total += this->tile_cost[t];
+        largest = std::max(largest, this->tile_cost[t]);
+    }
+    const double share = total / this->pool->threadCount();
+
+    // 最大のタイルが1スレッド分の1/4を超えると盗んでもならしきれないので細かくし,
+    // すべてのタイルが1/32未満なら分割の無駄を減らすため粗くする.
+    // 厚板数は倍々で変えるので, コストは半分ずつ分けるか2つ足して引き継ぐ
+    // A tile above a quarter of one thread's share cannot be evened out by stealing, so split finer;
+    // when every tile is under 1/32 of a share, coarsen to cut the per-slab overhead.
+    // The slab count changes by factors of two, so costs carry over halved or summed in pairs
+    const int bands = this->tile_bands;
+    if (largest > share / 4 && this->tile_slabs * 2 <= this->maxSlabs()) {
+        for (int slab = this->tile_slabs * 2 - 1; slab >= 0; slab--) {
+            for (int band = 0; band < bands; band++) {
+                this->tile_cost[slab * bands + band] = this->tile_cost[slab / 2 * bands + band] / 2;
+            }
+        }
+        this->tile_slabs *= 2;
+    } else if (largest < share / 32 && this->tile_slabs % 2 == 0) {
+        for (int slab = 0; slab < this->tile_slabs / 2; slab++) {
+            for (int band = 0; band < bands; band++) {
+                this->tile_cost[slab * bands + band] =
+                    this->tile_cost[2 * slab * bands + band] + this->tile_cost[(2 * slab + 1) * bands + band];
+            }
+        }
+        this->tile_slabs /= 2;
+    }
+}
+
+double CAEngineBase::spreadChanges(bool isTorus) {
+    const int ni = this->bricks_i;
+    const int nj = this->bricks_j;
+    const int nk = this->bricks_k;
+    const uint8_t* changed = this->brick_changed.data();
+    uint8_t* active = this->brick_active.data();
+    uint8_t* spread = this->brick_spread.data();
+    auto neighbor = [isTorus](int x, int d, int n) { return isTorus ? (x + d + n) % n : x + d; };
+
+    // トーラスのk方向では, 先頭の袖ビットが最後のセルを, 末尾の袖ビットが最初のセルを写す
+    // Along k on a torus the leading ghost bit mirrors the last cell and the trailing one the first cell
+    const int cells = this->field.sizeK();
+    const int last_cell_brick = (cells - 1 + BitField::HALO) / BitField::WORD_BITS / BRICK_WORDS;
+    const int high_ghost_brick = (cells + BitField::HALO) / BitField::WORD_BITS / BRICK_WORDS;
+
+    // 26近傍はk, j, iの順に1方向ずつ広げる
+    // The 26-neighborhood is spread one axis at a time: k, then j, then i
+    for (int bi = 0; bi < ni; bi++) {
+        for (int bj = 0; bj < nj; bj++) {
+            const uint8_t* c = changed + this->brickIndex(bi, bj, 0);
+            uint8_t* a = active + this->brickIndex(bi, bj, 0);
+            for (int bk = 0; bk < nk; bk++) {
+                a[bk] = c[bk] | (bk > 0 ? c[bk - 1] : 0) | (bk + 1 < nk ? c[bk + 1] : 0);
+            }
+            if (isTorus) {
+                a[0] |= c[last_cell_brick];
+                a[high_ghost_brick] |= c[0];
+            }
+        }
+    }
+    for (int bi = 0; bi < ni; bi++) {
+        for (int bj = 0; bj < nj; bj++) {
+            const int lo = neighbor(bj, -1, nj);
+            const int hi = neighbor(bj, 1, nj);
+            for (int bk = 0; bk < nk; bk++) {
+                uint8_t v = active[this->brickIndex(bi, bj, bk)];
+                if (lo >= 0) v |= active[this->brickIndex(bi, lo, bk)];
+                if (hi < nj) v |= active[this->brickIndex(bi, hi, bk)];
+                spread[this->brickIndex(bi, bj, bk)] = v;
+            }
+        }
+    }
+    std::size_t count = 0;
+    for (int bi = 0; bi < ni; bi++) {
+        const int lo = neighbor(bi, -1, ni);
+        const int hi = neighbor(bi, 1, ni);
+        for (int bj = 0; bj < nj; bj++) {
+            for (int bk = 0; bk < nk; bk++) {
+                uint8_t v = spread[this->brickIndex(bi, bj, bk)];
+                if (lo >= 0) v |= spread[this->brickIndex(lo, bj, bk)];
+                if (hi < ni) v |= spread[this->brickIndex(hi, bj, bk)];
+                active[this->brickIndex(bi, bj, bk)] = v;
+                count += v;
+            }
+        }
+    }
+    return (double)count / this->brick_active.size();
+}
+
+void CAEngineBase::markChanged(int i_begin, int i_end, int j_begin, int j_end, int w_begin, int w_end) {
+    const uint64_t* mask = this->interior_mask.data();
+    const int bk_begin = w_begin / BRICK_WORDS;
+    const int bk_end = w_end / BRICK_WORDS;
+    for (int i = i_begin; i < i_end; i++) {
+        for (int j = j_begin; j < j_end; j++) {
+            const uint64_t* before = this->field.row(i, j);
+            const uint64_t* after = this->next_field.row(i, j);
+            uint8_t* changed = this->brick_changed.data() + this->brickIndex(i / BRICK_PLANES, j / BRICK_ROWS, 0);
+            // 範囲はブリック境界から始まるので, ブリックの最初の行で印を付け直し以降の行で重ねていく
+            // Ranges start on brick boundaries, so a brick's first row resets its flags and later rows accumulate
+            const bool first = i % BRICK_PLANES == 0 && j % BRICK_ROWS == 0;
+            for (int bk = bk_begin; bk < bk_end; bk++) {
+                uint64_t diff = 0;
+                for (int w = bk * BRICK_WORDS; w < (bk + 1) * BRICK_WORDS; w++) {
+                    diff |= (before[w] ^ after[w]) & mask[w];
+                }
+                changed[bk] = (first ? 0 : changed[bk]) | (diff != 0);
+            }
+        }
+    }
+}
+
+void CAEngineBase::stepActiveColumn(int column, int worker) {
+    const int ni = this->field.sizeI();
+    const int nj = this->field.sizeJ();
+    const int bj = column / this->bricks_k;
+    const int bk = column % this->bricks_k;
+    const int j = bj * BRICK_ROWS;
+    const int j_end = std::min(nj, j + BRICK_ROWS);
+    const int w = bk * BRICK_WORDS;
+
+    int bi = 0;
+    while (bi < this->bricks_i) {
+        if (!this->brick_active[this->brickIndex(bi, bj, bk)]) {
+            this->brick_changed[this->brickIndex(bi, bj, bk)] = 0;
+            bi++;
+            continue;
+        }
+        int run_end = bi;
+        while (run_end < this->bricks_i && this->brick_active[this->brickIndex(run_end, bj, bk)]) run_end++;
+
+        const int i = bi * BRICK_PLANES;
+        const int i_end = std::min(ni, run_end * BRICK_PLANES);
+        StepTile tile = this->makeTile(i, i_end, j, j_end, worker);
+        tile.word_begin = w;
+        tile.word_end = w + BRICK_WORDS;
+        this->step_tile(tile);
+        this->markChanged(i, i_end, j, j_end, w, w + BRICK_WORDS);
+        bi = run_end;
+    }
+}
+
+void CAEngineBase::progressBlocked(int generations, bool isTorus) {
+    const int blocks_i = this->dim == 3 ? (this->field.sizeI() + this->block_edge - 1) / this->block_edge : 1;
+    const int blocks_j = (this->field.sizeJ() + this->block_edge - 1) / this->block_edge;
+    while (generations > 0) {
+        const int steps = generations < BLOCK_STEPS ? generations : BLOCK_STEPS;
+        this->field.fillHalo(isTorus);
+        auto task = [this, steps, isTorus](int block, int worker) {
+            this->stepBlock(block, worker, steps, isTorus);
+        };
+        this->pool->parallelFor(blocks_i * blocks_j, task);
+        std::swap(this->field, this->next_field);
+        this->generation += steps;
+        generations -= steps;
+    }
+    // ブロック単位の更新は変化を追わないので, 次の世代はすべてのブリックを更新させる
+    // Blocked stepping does not track changes, so every brick is stepped next generation
+    std::fill(this->brick_changed.begin(), this->brick_changed.end(), 1);
+    this->active_fraction = 1.0;
+}
+
+void CAEngineBase::stepBlock(int block, int worker, int steps, bool isTorus) {
+    const int ni = this->field.sizeI();
+    const int nj = this->field.sizeJ();
+    const int nk = this->field.sizeK();
+    const int rw = this->field.rowWords();
+    const bool planar = this->dim == 2;
+    const int blocks_j = (nj + this->block_edge - 1) / this->block_edge;
+
+    // 中心部の原点と大きさ, 袖の幅, 局所バッファの大きさ
+    // Origin and size of the core, halo widths, and local buffer size
+    const int gi0 = planar ? 0 : block / blocks_j * this->block_edge;
+    const int gj0 = block % blocks_j * this->block_edge;
+    const int ci = planar ? 1 : std::min(this->block_edge, ni - gi0);
+    const int cj = std::min(this->block_edge, nj - gj0);
+    const int hi = planar ? 0 : steps;
+    const int hj = steps;
+    const int li_n = ci + 2 * hi;
+    const int lj_n = cj + 2 * hj;
+    const std::size_t plane = (std::size_t)lj_n * rw;
+
+    uint64_t* buffers[2] = {
+        this->block_buffers.data() + 2 * worker * this->block_words + BitField::GUARD_WORDS,
+        this->block_buffers.data() + (2 * worker + 1) * this->block_words + BitField::GUARD_WORDS,
+    };
+    auto local = [&](uint64_t* b, int li, int lj) { return b + li * plane + (std::size_t)lj * rw; };
+    auto wrap = [](int x, int n) { return (x % n + n) % n; };
+    auto inside = [&](int li, int lj) {
+        const int gi = gi0 + li - hi;
+        const int gj = gj0 + lj - hj;
+        return (planar || (gi >= 0 && gi < ni)) && gj >= 0 && gj < nj;
+    };
+
+    // トーラスでは袖を反対側から, 有界では領域外を0で読み込む
+    // Load the halo from the opposite side on a torus, and as zeros outside a bounded field
+    for (int li = 0; li < li_n; li++) {
+        for (int lj = 0; lj < lj_n; lj++) {
+            uint64_t* dst = local(buffers[0], li, lj);
+            if (isTorus || inside(li, lj)) {
+                const uint64_t* src = this->field.row(planar ? 0 : wrap(gi0 + li - hi, ni), wrap(gj0 + lj - hj, nj));
+                std::copy(src, src + rw, dst);
+            } else {
+                std::fill(dst, dst + rw, 0);
+            }
+        }
+    }
+
+    for (int s = 1; s <= steps; s++) {
+        uint64_t* src = buffers[(s - 1) & 1];
+        uint64_t* dst = buffers[s & 1];
+        const int i_begin = planar ? 0 : s;
+        const int i_end = li_n - (planar ? 0 : s);
+        for (int j = s; j < lj_n - s; j += STEP_TILE_ROWS) {
+            StepTile tile = this->makeTile(i_begin, i_end, j, std::min(j + STEP_TILE_ROWS, lj_n - s), worker);
+            tile.src = src;
+            tile.dst = dst;
+            tile.plane_stride = plane;
+            // 局所バッファの行はブリックにそろっていないので統計は取らない
+            // Local buffer rows are not aligned to bricks, so no statistics here
+            tile.brick_or = nullptr;
+            tile.histogram = false;
+            this->step_tile(tile);
+        }
+
+        for (int li = i_begin; li < i_end; li++) {
+            for (int lj = s; lj < lj_n - s; lj++) {
+                uint64_t* r = local(dst, li, lj);
+                if (isTorus) BitField::fillRowHalo(r, nk, true);
+                else if (!inside(li, lj)) std::fill(r, r + rw, 0);
+            }
+        }
+    }
+
+    uint64_t* result = buffers[steps & 1];
+    for (int li = hi; li < hi + ci; li++) {
+        for (int lj = hj; lj < hj + cj; lj++) {
+            const uint64_t* r = local(result, li, lj);
+            std::copy(r, r + rw, this->next_field.row(gi0 + li - hi, gj0 + lj - hj));
+        }
+    }
+}
+
+void CAEngineBase::copyStateFrom(const CAEngineBase& other) {
+    this->field = other.field;
+    this->generation = other.generation;
+    this->edited = true;
+    this->stats_generation = -1;
+    this->hash_generation = -1;
+    std::fill(this->brick_changed.begin(), this->brick_changed.end(), 1);
+}
+
+void CAEngineBase::reset(const Rule& rule) {
+    this->rule = rule;
+    this->field.clear();
+    this->next_field.clear();
+    this->generation = 0;
+    this->edited = true;
+    this->stats_generation = -1;
+    this->hash_generation = -1;
+    this->cycles.reset();
+    std::fill(this->brick_changed.begin(), this->brick_changed.end(), 1);
+}
+
+FieldView CAEngineBase::getFieldView() const {
+    return FieldView(this->field.row(0, 0), this->field.sizeI(), this->field.sizeJ(), this->field.sizeK(),
+        this->field.rowWords(), this->field.planeWords(), BitField::HALO, this->generation);
+}
+
+GenerationStats CAEngineBase::scanField() const {
+    GenerationStats stats;
+    stats.generation = this->generation;
+    const uint64_t* mask = this->interior_mask.data();
+    for (int i = 0; i < this->field.sizeI(); i++) {
+        for (int j = 0; j < this->field.sizeJ(); j++) {
+            const uint64_t* row = this->field.row(i, j);
+            for (int w = 0; w < this->field.rowWords(); w++) {
+                const uint64_t x = row[w] & mask[w];
+                if (x == 0) continue;
+                const int k_first = w * BitField::WORD_BITS + __builtin_ctzll(x) - BitField::HALO;
+                const int k_last = w * BitField::WORD_BITS + 63 - __builtin_clzll(x) - BitField::HALO;
+                if (stats.population == 0) {
+                    stats.i_min = i;
+                    stats.j_min = j;
+                    stats.k_min = k_first;
+                    stats.k_max = k_last;
+                }
+                stats.population += __builtin_popcountll(x);
+                stats.i_max = i;
+                stats.j_min = std::min(stats.j_min, j);
+                stats.j_max = std::max(stats.j_max, j);
+                stats.k_min = std::min(stats.k_min, k_first);
+                stats.k_max = std::max(stats.k_max, k_last);
+            }
+        }
+    }
+    return stats;
+}
+
+GenerationStats CAEngineBase::getGenerationStats() const {
+    if (!this->stats_enabled || this->stats_generation != this->generation) return this->scanField();
+
+    GenerationStats stats;
+    stats.generation = this->generation;
+    stats.population = this->population;
+    stats.has_changes = true;
+    stats.has_histogram = this->histogram_enabled;
+    for (const WorkerStats& w: this->worker_stats) {
+        stats.births += w.births;
+        stats.deaths += w.deaths;
+        for (int c = 0; c < 27; c++) stats.histogram[c] += w.histogram[c];
+    }
+    if (stats.population == 0) return stats;
+
+    // ブリックの論理和から, i と j はブリック単位の範囲を, k はセル単位の範囲を得る
+    // The brick ORs give the i and j extents in bricks and the k extent in cells
+    const int rw = this->field.rowWords();
+    int bi_min = this->bricks_i, bi_max = -1, bj_min = this->bricks_j, bj_max = -1;
+    stats.k_min = this->field.sizeK();
+    for (int bi = 0; bi < this->bricks_i; bi++) {
+        for (int bj = 0; bj < this->bricks_j; bj++) {
+            const uint64_t* ors = this->brick_or.data() + ((std::size_t)bi * this->bricks_j + bj) * rw;
+            for (int w = 0; w < rw; w++) {
+                if (ors[w] == 0) continue;
+                bi_min = std::min(bi_min, bi);
+                bi_max = std::max(bi_max, bi);
+                bj_min = std::min(bj_min, bj);
+                bj_max = std::max(bj_max, bj);
+                stats.k_min = std::min(stats.k_min, w * BitField::WORD_BITS + __builtin_ctzll(ors[w]) - BitField::HALO);
+                stats.k_max = std::max(stats.k_max, w * BitField::WORD_BITS + 63 - __builtin_clzll(ors[w]) - BitField::HALO);
+            }
+        }
+    }
+
+    // 平面と行の範囲は, 端のブリックの中だけを場から探して詰める
+    // Narrow the plane and row extents by searching the field inside the edge bricks only
+    const uint64_t* mask = this->interior_mask.data();
+    auto rowLive = [&](int i, int j) {
+        const uint64_t* row = this->field.row(i, j);
+        for (int w = 0; w < rw; w++) {
+            if (row[w] & mask[w]) return true;
+        }
+        return false;
+    };
+    const int j_begin = bj_min * BRICK_ROWS;
+    const int j_end = std::min(this->field.sizeJ(), (bj_max + 1) * BRICK_ROWS);
+    auto planeLive = [&](int i) {
+        for (int j = j_begin; j < j_end; j++) {
+            if (rowLive(i, j)) return true;
+        }
+        return false;
+    };
+    stats.i_min = bi_min * BRICK_PLANES;
+    while (!planeLive(stats.i_min)) stats.i_min++;
+    stats.i_max = std::min(this->field.sizeI(), (bi_max + 1) * BRICK_PLANES) - 1;
+    while (!planeLive(stats.i_max)) stats.i_max--;
+    auto rowsLive = [&](int j) {
+        for (int i = stats.i_min; i <= stats.i_max; i++) {
+            if (rowLive(i, j)) return true;
+        }
+        return false;
+    };
+    stats.j_min = j_begin;
+    while (!rowsLive(stats.j_min)) stats.j_min++;
+    stats.j_max = j_end - 1;
+    while (!rowsLive(stats.j_max)) stats.j_max--;
+    return stats;
+}
+
+void CAEngineBase::setCycleDetection(bool enabled) {
+    this->cycle_detection = enabled;
+    this->hash_generation = -1;
+    this->cycles.reset();
+}
+
+void CAEngineBase::setCycleHistory(std::size_t generations) {
+    this->cycles.setCapacity(generations);
+    this->hash_generation = -1;
+}
+
+FieldHash CAEngineBase::hashBrickRow(int bi, int bj, bool changed_only) const {
+    const uint64_t* mask = this->interior_mask.data();
+    const int rw = this->field.rowWords();
+    const int i_end = std::min(this->field.sizeI(), (bi + 1) * BRICK_PLANES);
+    const int j_end = std::min(this->field.sizeJ(), (bj + 1) * BRICK_ROWS);
+    const uint8_t* changed = this->brick_changed.data() + this->brickIndex(bi, bj, 0);
+    FieldHash hash;
+    for (int i = bi * BRICK_PLANES; i < i_end; i++) {
+        for (int j = bj * BRICK_ROWS; j < j_end; j++) {
+            const uint64_t* after = this->field.row(i, j);
+            const uint64_t* before = this->next_field.row(i, j);
+            const std::size_t row_index = ((std::size_t)i * this->field.sizeJ() + j) * rw;
+            for (int bk = 0; bk < this->bricks_k; bk++) {
+                if (changed_only && !changed[bk]) continue;
+                for (int w = bk * BRICK_WORDS; w < (bk + 1) * BRICK_WORDS; w++) {
+                    const uint64_t now = after[w] & mask[w];
+                    const uint64_t was = changed_only ? before[w] & mask[w] : 0;
+                    if (was == now) continue;
+                    hash ^= FieldHash::ofWord(row_index + w, was);
+                    hash ^= FieldHash::ofWord(row_index + w, now);
+                }
+            }
+        }
+    }
+    return hash;
+}
+
+void CAEngineBase::hashBricks(bool changed_only) {
+    std::fill(this->worker_hash.begin(), this->worker_hash.end(), FieldHash());
+    auto task = [this, changed_only](int t, int worker) {
+        this->worker_hash[worker] ^= this->hashBrickRow(t / this->bricks_j, t % this->bricks_j, changed_only);
+    };
+    this->pool->parallelFor(this->bricks_i * this->bricks_j, task);
+    if (!changed_only) this->field_hash = FieldHash();
+    for (const FieldHash& h: this->worker_hash) this->field_hash ^= h;
+    this->hash_generation = this->generation;
+}
+
+FieldHash CAEngineBase::getFieldHash() const {
+    if (this->cycle_detection && this->hash_generation == this->generation) return this->field_hash;
+    FieldHash hash;
+    for (int bi = 0; bi < this->bricks_i; bi++) {
+        for (int bj = 0; bj < this->bricks_j; bj++) hash ^= this->hashBrickRow(bi, bj, false);
+    }
+    return hash;
+}
+
+void CAEngineBase::observeHash() {
+    if (!this->cycle_detection) return;
+    if (this->hash_generation != this->generation) this->hashBricks(false);
+    this->cycles.observe(this->generation, this->field_hash);
+}
+
+int CAEngineBase::applyCycleAction(int generations) {
+    if (!this->cycle_detection) return generations;
+    if (this->hash_generation != this->generation) {
+        this->cycles.reset();
+        this->observeHash();
+    }
+    const CycleInfo& cycle = this->cycles.getCycle();
+    if (!cycle.found || this->cycle_action == CycleAction::Continue) return generations;
+    if (this->cycle_action == CycleAction::Stop) return 0;
+
+    // 周期に入った後は, 直前の世代も補助データ (変化の印, 統計, 評価待ちのセル) も周期の倍数前と同じ
+    // Inside the cycle the previous generation, and with it the bookkeeping (changed flags, statistics,
+    // queued cells), equals the one whole periods earlier
+    const long long skipped = generations / cycle.period * cycle.period;
+    if (this->stats_generation == this->generation) this->stats_generation += skipped;
+    this->hash_generation += skipped;
+    this->generation += skipped;
+    return (int)(generations - skipped);
+}
+
+void CAEngineBase::progressStepwise(int generations) {
+    while ((generations = this->applyCycleAction(generations)) > 0) {
+        this->progressField();
+        generations--;
+    }
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+CAEngine<Dim, N, B>::CAEngine(const Rule& rule, int length, int thread_count)
+    : CAEngineBase(rule, Dim == 2 ? BitField(length, length) : BitField(length, length, length), Dim, N, thread_count) {}
+
+template <int Dim, Neighborhood N, Boundary B>
+void CAEngine<Dim, N, B>::progressField() {
+    if (this->applyCycleAction(1) == 0) return;
+    this->field.fillHalo(B == Boundary::Torus);
+
+    // 64セルずつビットスライスで数える. j方向をL2に収まる行数で区切り, 各区切りでi方向に流す
+    // Count 64 cells at a time with bit-sliced adders. j is cut into L2-sized bands, each streamed along i
+    this->stepTiles(B == Boundary::Torus);
+
+    std::swap(this->field, this->next_field);
+    this->generation++;
+    this->stats_generation = -1;
+    if (this->stats_enabled) {
+        for (const WorkerStats& w: this->worker_stats) this->population += w.births - w.deaths;
+        this->stats_generation = this->generation;
+    }
+    if (this->cycle_detection) {
+        // 前の世代のハッシュと正しい変化の印があれば, 変わったワードの分だけ更新する
+        // Given the previous generation's hash and exact changed flags, update by the changed words only
+        if (this->hash_generation == this->generation - 1 && this->brick_skipping) this->hashBricks(true);
+        this->observeHash();
+    }
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void CAEngine<Dim, N, B>::progressField(int generations) {
+    if (this->cycle_detection) {
+        this->progressStepwise(generations);
+        return;
+    }
+    // 統計を集めるときは最後の1世代を通常の更新で進め, その世代の統計を得る.
+    // 1世代だけなら袖の重複計算が無い通常の更新の方が速い
+    // When collecting statistics the last generation takes the normal path so its statistics are counted.
+    // A single generation is faster without the redundant halo work
+    const int last = this->stats_enabled && generations > 0 ? 1 : 0;
+    const int blocked = generations - last;
+    if (blocked == 1) this->progressField();
+    else if (blocked > 1) this->progressBlocked(blocked, B == Boundary::Torus);
+    if (last == 1) this->progressField();
+}
+
+template class CAEngine<2, Neighborhood::Moore, Boundary::Torus>;
+template class CAEngine<2, Neighborhood::Moore, Boundary::Bounded>;
+template class CAEngine<2, Neighborhood::Neumann, Boundary::Torus>;
+template class CAEngine<2, Neighborhood::Neumann, Boundary::Bounded>;
+template class CAEngine<3, Neighborhood::Moore, Boundary::Torus>;
+template class CAEngine<3, Neighborhood::Moore, Boundary::Bounded>;
+template class CAEngine<3, Neighborhood::Neumann, Boundary::Torus>;
+template class CAEngine<3, Neighborhood::Neumann, Boundary::Bounded>;
+
+namespace {
+
+template <template <int, Neighborhood, Boundary> class Engine, int Dim>
+std::unique_ptr<CAEngineBase> makeEngineForDim(int length, const Rule& rule,
+    bool isNeumannNeighborhood, bool isTorus, int thread_count) {
+    if (isNeumannNeighborhood) {
+        if (isTorus) return std::make_unique<Engine<Dim, Neighborhood::Neumann, Boundary::Torus>>(rule, length, thread_count);
+        return std::make_unique<Engine<Dim, Neighborhood::Neumann, Boundary::Bounded>>(rule, length, thread_count);
+    }
+    if (isTorus) return std::make_unique<Engine<Dim, Neighborhood::Moore, Boundary::Torus>>(rule, length, thread_count);
+    return std::make_unique<Engine<Dim, Neighborhood::Moore, Boundary::Bounded>>(rule, length, thread_count);
+}
+
+template <template <int, Neighborhood, Boundary> class Engine>
+std::unique_ptr<CAEngineBase> makeEngine(int dim, int length, const Rule& rule,
+    bool isNeumannNeighborhood, bool isTorus, int thread_count) {
+    if (dim == 2) return makeEngineForDim<Engine, 2>(length, rule, isNeumannNeighborhood, isTorus, thread_count);
+    return makeEngineForDim<Engine, 3>(length, rule, isNeumannNeighborhood, isTorus, thread_count);
+}
+
+}
+
+std::unique_ptr<CAEngineBase> makeCAEngine(int dim, int length, const Rule& rule,
+    bool isNeumannNeighborhood, bool isTorus, EngineKind kind, int thread_count) {
+    if (kind == EngineKind::EventDriven) {
+        return makeEngine<EventEngine>(dim, length, rule, isNeumannNeighborhood, isTorus, thread_count);
+    }
+    return makeEngine<CAEngine>(dim, length, rule, isNeumannNeighborhood, isTorus, thread_count);
+}
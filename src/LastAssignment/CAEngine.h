@@ -0,0 +1,294 @@
+#ifndef CA_ENGINE_H_
+#define CA_ENGINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BitField.h"
+#include "CycleDetector.h"
+#include "FieldView.h"
+#include "GenerationStats.h"
+#include "KernelDispatch.h"
+#include "Rule.h"
+#include "ThreadPool.h"
+
+// 世代を進めるエンジンの共通部分. フィールドの二重バッファと規則を持つ
+// Common part of the stepping engines. Owns the double-buffered field and the rule
+class CAEngineBase
+{
+protected:
+    // 変化の有無を追うブリック. 8平面 × 8行 × 4ワード (256セル), 平面のフィールドでは1平面
+    // Bricks whose changes are tracked: 8 planes x 8 rows x 4 words (256 cells), one plane when planar
+    static const int BRICK_PLANES = STATS_BRICK_PLANES;
+    static const int BRICK_ROWS = STATS_BRICK_ROWS;
+    static const int BRICK_WORDS = 4;
+    // 更新が必要なブリックがこの割合を超えたらブリックを飛ばさず全体を更新する
+    // Above this fraction of active bricks the whole field is stepped without skipping
+    static constexpr double DENSE_ACTIVE_FRACTION = 0.5;
+    // 厚板の最小の厚さ. 薄いほどリングを詰め直す割合が増える. ブリックの境目にそろえる
+    // Thinnest slab. Thinner slabs spend more of their time re-priming the rings. Aligned to bricks
+    static const int MIN_SLAB_PLANES = BRICK_PLANES;
+    // progressField(n) で1回の読み書きの間に進める世代数の上限
+    // Most generations progressField(n) advances per pass over memory
+    static const int BLOCK_STEPS = 4;
+
+    Rule rule;
+    BitField field;
+    BitField next_field;
+    std::vector<uint64_t> interior_mask;
+    long long generation;
+    int dim;
+    Neighborhood neighborhood;
+    KernelIsa kernel_isa;
+    StepTileFn step_tile;
+    // 世代をカーネルで進めるか. 偽なら派生エンジンが自前で進めるので, 次の場, カーネルの作業領域と
+    // 時間方向ブロックのバッファを持たず, プールは1スレッド. thread_count は指定された数を覚えておく
+    // Whether generations are stepped by the kernels. When false a derived engine steps them on its own,
+    // so there is no next field, kernel work area or temporal-blocking buffers, and the pool has one
+    // thread. thread_count remembers the requested count either way
+    bool kernel_stepping;
+    int thread_count;
+    std::unique_ptr<ThreadPool> pool;
+    // ワーカーごとに scratch_words ずつ区切った作業領域
+    // Work area cut into scratch_words per worker
+    std::vector<uint64_t> scratch;
+    std::size_t scratch_words;
+    int tile_bands;
+    int tile_slabs;
+    ThreadPool::Schedule tile_schedule;
+    // 前の世代で測ったタイルごとの実行時間(秒). 最大のタイル数分を確保しておく
+    // Per-tile run time (seconds) measured last generation, sized for the finest tiling
+    std::vector<double> tile_cost;
+    // 時間方向ブロックの辺の長さ (3次元ではiとj, 平面ではj) と, ワーカーごとに2枚ずつの局所バッファ
+    // Edge of a temporal block (i and j in 3D, j when planar) and two local buffers per worker
+    int block_edge;
+    std::size_t block_words;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> block_buffers;
+    // ブリックごとの「前の世代で変化した」印と, 自身か26近傍が変化した「要更新」の印.
+    // 変化していないブリックは next_field にも同じ内容が残っているので, 更新を飛ばせる
+    // Per-brick "changed last generation" flags, and "active" flags for bricks whose own or
+    // 26 neighbors' flags are set. An unchanged brick still holds the same contents in
+    // next_field, so an inactive brick can be skipped outright
+    bool brick_skipping;
+    int bricks_i;
+    int bricks_j;
+    int bricks_k;
+    std::vector<uint8_t> brick_changed;
+    std::vector<uint8_t> brick_active;
+    std::vector<uint8_t> brick_spread;
+    double active_fraction;
+    // 世代の統計. ブリックごとのワードの論理和は最後に更新したときの値で, 飛ばしたブリックは中身も
+    // 変わっていないのでそのまま使える. 個体数は前の世代の値に誕生数と死亡数を足し引きして保つ.
+    // stats_generation は統計が今の場を表すときの世代番号で, そうでなければ -1
+    // Generation statistics. The per-brick word ORs hold the values from each brick's last step, which
+    // stay valid for skipped bricks because their contents did not change either. The population is
+    // carried over from the previous generation with births added and deaths taken away.
+    // stats_generation is the generation number while the statistics describe the current field, -1 otherwise
+    bool stats_enabled;
+    bool histogram_enabled;
+    long long stats_generation;
+    uint64_t population;
+    std::vector<uint64_t> brick_or;
+    std::vector<WorkerStats> worker_stats;
+    // 周期の検出. field_hash は hash_generation 世代の場のハッシュで, 場が変わってまだ更新していなければ
+    // hash_generation は今の世代と違う. ワーカーごとに部分のハッシュを足し込んでから1つにまとめる
+    // Cycle detection. field_hash is the hash of the field at hash_generation, which differs from the
+    // current generation while the field has changed without the hash being updated. Workers XOR partial
+    // hashes into their own slot, merged into one afterwards
+    bool cycle_detection;
+    CycleAction cycle_action;
+    CycleDetector cycles;
+    FieldHash field_hash;
+    long long hash_generation;
+    std::vector<FieldHash> worker_hash;
+    // set() で外から書き換えられたら立つ. 派生エンジンが自前の補助データを作り直すのに使う
+    // Raised when set() edits the field from outside. Derived engines rebuild their own bookkeeping from it
+    bool edited;
+
+    StepTile makeTile(int i_begin, int i_end, int j_begin, int j_end, int worker);
+    // j方向の帯とi方向の厚板に分けたタイルをスレッドプールで更新する
+    // Steps every tile (j bands times i slabs) on the thread pool
+    void stepTiles(bool isTorus);
+    int maxSlabs() const;
+    int slabBegin(int slab) const;
+    std::size_t brickIndex(int bi, int bj, int bk) const {
+        return ((std::size_t)bi * this->bricks_j + bj) * this->bricks_k + bk;
+    }
+    // 変化の印を近傍ブリックへ広げて要更新の印を作り, その割合を返す
+    // Spreads the changed flags to neighboring bricks to get the active flags, and returns their fraction
+    double spreadChanges(bool isTorus);
+    // 範囲内のブリックについて, 新旧のフィールドを比べて変化の印を付け直す
+    // Re-marks the changed flags of the bricks in range by comparing the old and new fields
+    void markChanged(int i_begin, int i_end, int j_begin, int j_end, int w_begin, int w_end);
+    // 要更新のブリックが i 方向に連続する区間ごとにカーネルを呼ぶ
+    // Calls the kernel on each run of active bricks along i
+    void stepActiveColumn(int column, int worker);
+    // 測ったコストから次の世代の厚板数を決める
+    // Picks next generation's slab count from the measured costs
+    void adaptTiles();
+    // 袖を付けたブロックを局所バッファに写し, steps 世代進めて中心部だけを書き戻す.
+    // 世代ごとに有効な範囲が1セルずつ縮む台形の分割なので, 1世代ずつ進めた結果と一致する
+    // Copies a block with its halo into a local buffer, advances it steps generations and
+    // writes back only its core. The valid region shrinks by one cell per generation
+    // (trapezoidal tiling), so the result matches stepping one generation at a time
+    void progressBlocked(int generations, bool isTorus);
+    void stepBlock(int block, int worker, int steps, bool isTorus);
+    // ブリックの行 (bi, bj) に含まれるワードのハッシュ. changed_only なら変化の印が付いたブリックで
+    // next_field (前の世代) と値の違うワードについて, 新旧の寄与の排他的論理和を返す
+    // Hash of the words in the row of bricks (bi, bj). With changed_only, returns the XOR of the old and
+    // new contributions of the words that differ from next_field (the previous generation) in flagged bricks
+    FieldHash hashBrickRow(int bi, int bj, bool changed_only) const;
+    // すべてのブリックで field_hash を計算し直すか, 変化の印が付いたブリックの分だけ更新する
+    // Recomputes field_hash over every brick, or updates it for the flagged bricks only
+    void hashBricks(bool changed_only);
+    // 世代を進めた後に呼ぶ. ハッシュが古ければ計算し直してから記録し, 周期を探す
+    // Called after a generation is advanced. Recomputes the hash if stale, then records it to look for a cycle
+    void observeHash();
+    // 進める世代数を周期の動作に従って減らす. 止めるなら0, 早送りなら周期の倍数を計算せずに世代番号へ足し,
+    // 残りを返す. ハッシュが古い (場が外から書き換えられた) ときは履歴を捨てて今の場から記録し直す
+    // Cuts the generations to advance according to the cycle action: 0 when stopping, and when
+    // fast-forwarding whole periods are added to the generation number without computing them and the
+    // rest is returned. With a stale hash (the field was edited from outside) the history is dropped and
+    // recording restarts from the current field
+    int applyCycleAction(int generations);
+    // 1世代ずつ進め, その都度ハッシュを記録して周期の動作を当てはめる
+    // Advances one generation at a time, recording each hash and applying the cycle action
+    void progressStepwise(int generations);
+    // 今の場だけから個体数と範囲を数える
+    // Counts the population and bounding box from the current field alone
+    GenerationStats scanField() const;
+    CAEngineBase(const Rule& rule, const BitField& shape, int dim, Neighborhood neighborhood, int thread_count,
+        bool kernel_stepping);
+
+public:
+    // thread_count は setThreadCount と同じく, 0 ならハードウェアのスレッド数
+    // thread_count is as in setThreadCount: 0 means the hardware thread count
+    CAEngineBase(const Rule& rule, const BitField& shape, int dim, Neighborhood neighborhood, int thread_count)
+        : CAEngineBase(rule, shape, dim, neighborhood, thread_count, true) {}
+    virtual ~CAEngineBase() {}
+
+    virtual void progressField() = 0;
+    // n回の progressField() と同じ結果を, 数世代ずつキャッシュ内で進めて得る
+    // Same result as n calls to progressField(), advancing several generations per cache-sized block
+    virtual void progressField(int generations) = 0;
+
+    bool get(int i, int j, int k) const { return this->field.get(i, j, k); }
+    void set(int i, int j, int k, bool alive) {
+        this->field.set(i, j, k, alive);
+        this->edited = true;
+        this->stats_generation = -1;
+        this->hash_generation = -1;
+        this->brick_changed[this->brickIndex(i / BRICK_PLANES, j / BRICK_ROWS,
+            (k + BitField::HALO) / BitField::WORD_BITS / BRICK_WORDS)] = 1;
+    }
+    const Rule& getRule() const { return this->rule; }
+    FieldView getFieldView() const;
+    long long getGeneration() const { return this->generation; }
+    // 同じ大きさの別のエンジンからセルと世代番号を引き継ぐ
+    // Takes over the cells and generation number from another engine of the same size
+    void copyStateFrom(const CAEngineBase& other);
+    // 場を空にして世代を0に戻し, 規則を差し替える. 周期の履歴も消すが, スレッドなどの設定はそのまま
+    // Empties the field, sets the generation back to 0 and switches to rule. The cycle history is
+    // cleared too, but threads and other settings are kept
+    void reset(const Rule& rule);
+
+    KernelIsa getKernelIsa() const { return this->kernel_isa; }
+    // CPUが対応しない命令セットを指定すると std::invalid_argument
+    // Throws std::invalid_argument if the CPU does not support the instruction set
+    void setKernelIsa(KernelIsa isa);
+
+    int getThreadCount() const { return this->thread_count; }
+    // 呼び出し元を含むスレッド数. 0 ならハードウェアのスレッド数. 結果はスレッド数によらず同じ
+    // Thread count including the caller; 0 means the hardware thread count.
+    // Results are identical for every thread count
+    void setThreadCount(int thread_count);
+    // スレッドごとのタスク実行時間(秒). 偏りを見るためのもの
+    // Seconds each thread spent stepping tiles, for spotting load imbalance
+    std::vector<double> getThreadBusySeconds() const { return this->pool->busySeconds(); }
+    void resetThreadStats() { this->pool->resetBusyTime(); }
+    // 既定は Stealing. Static は比較用の個数による等分割
+    // Stealing by default. Static splits by tile count, for comparison
+    ThreadPool::Schedule getTileSchedule() const { return this->tile_schedule; }
+    void setTileSchedule(ThreadPool::Schedule schedule);
+    // 直前の世代の最大スレッド実行時間 / 平均. 1 なら完全に均等
+    // Max over mean thread busy time in the last generation. 1 means perfectly even
+    double getLoadImbalance() const { return this->pool->lastImbalance(); }
+
+    // 既定で有効. 無効にすると毎世代すべてのセルを更新する
+    // On by default. When off, every cell is stepped every generation
+    bool getBrickSkipping() const { return this->brick_skipping; }
+    void setBrickSkipping(bool enabled);
+    // 直前の世代で更新が必要だったブリックの割合
+    // Fraction of bricks that needed stepping in the last generation
+    double getActiveBrickFraction() const { return this->active_fraction; }
+
+    // 既定で無効. 世代を進めるカーネルが書いたベクトルからその場で数えるので場を読み直さない.
+    // AVX-512 VPOPCNTDQ のある3次元では1世代が5%ほどしか遅くならないが, 1ベクトルあたりの仕事が少ない
+    // 2次元や, 誕生と死亡をビットスライスで数える命令セットでは2-7割ほど遅くなる. 無効なら統計の無いカーネルを使う
+    // Off by default. Counted by the stepping kernel from the vectors it just wrote, without re-reading
+    // the field. In 3D with AVX-512 VPOPCNTDQ steps get at most about 5% slower; in 2D, where each
+    // vector carries little work, or on instruction sets that count births and deaths with bit-sliced
+    // adders, roughly 20-70% slower. When off, the kernels without statistics run
+    bool getStatsCollection() const { return this->stats_enabled; }
+    void setStatsCollection(bool enabled);
+    // 既定で無効で, 統計を集めているときだけ数える. 変化の無いブリックも数えるためブリック飛ばしを止め,
+    // 1ベクトルごとに数え分けるので大幅に遅くなる
+    // Off by default, and counted only while statistics are collected. Bricks without changes must be
+    // counted too, so brick skipping is suspended, and every vector is sorted by count: much slower
+    bool getNeighborHistogram() const { return this->histogram_enabled; }
+    void setNeighborHistogram(bool enabled);
+    // 今の世代の統計. 直前の更新で集めていなければ場を数え直す (誕生数と死亡数は無し)
+    // Statistics of the current generation. Recounted from the field (without births and deaths)
+    // when the last step did not collect them
+    virtual GenerationStats getGenerationStats() const;
+
+    // 既定で無効. 有効なら世代ごとに場のハッシュを更新して直近の履歴と照らし, 場が前の世代に戻ったら
+    // 周期として報告する. ハッシュは変化したブリックの違うワードだけで更新するが, ブリック飛ばしが
+    // 無効なら毎世代場全体を読む. progressField(n) は時間方向ブロックを使わず1世代ずつ進める
+    // Off by default. When on, the field hash is updated every generation and checked against the recent
+    // history, and a return to an earlier field is reported as a cycle. The hash is updated from the
+    // differing words of changed bricks only, but the whole field is read every generation without brick
+    // skipping. progressField(n) then advances one generation at a time instead of temporal blocking
+    bool getCycleDetection() const { return this->cycle_detection; }
+    void setCycleDetection(bool enabled);
+    // 既定は Continue
+    // Continue by default
+    CycleAction getCycleAction() const { return this->cycle_action; }
+    void setCycleAction(CycleAction action) { this->cycle_action = action; }
+    // 見つけられる最長の周期 (覚えておく世代数). 既定は1024. 変えると履歴を消す
+    // Longest period that can be found (generations remembered). 1024 by default. Changing it clears the history
+    std::size_t getCycleHistory() const { return this->cycles.getCapacity(); }
+    void setCycleHistory(std::size_t generations);
+    // 見つかった周期. 場を書き換えると, 次に世代を進めるときに消える
+    // The cycle found. Forgotten the next time a generation is advanced after the field was edited
+    const CycleInfo& getCycle() const { return this->cycles.getCycle(); }
+    // 今の場のハッシュ. 検出が無効か古ければ場全体から計算する
+    // Hash of the current field, computed from the whole field when detection is off or the hash is stale
+    FieldHash getFieldHash() const;
+};
+
+// 近傍と境界条件をコンパイル時に固定したエンジン. Dim は 2 (平面) か 3
+// Engine with the neighborhood and boundary fixed at compile time. Dim is 2 (planar) or 3
+template <int Dim, Neighborhood N, Boundary B>
+class CAEngine : public CAEngineBase
+{
+public:
+    CAEngine(const Rule& rule, int length, int thread_count);
+    void progressField() override;
+    void progressField(int generations) override;
+};
+
+// Bitwise: 64セルずつのビットスライスで全体 (または変化のあるブリック) を更新する
+// EventDriven: 近傍数を保持し, 変化したセルの周りだけを評価する. ごく疎な場向け
+// Bitwise: steps the whole field (or the changing bricks) 64 cells at a time with bit-sliced adders.
+// EventDriven: keeps neighbor counts and evaluates only around changed cells. For very sparse fields
+enum class EngineKind { Bitwise, EventDriven };
+
+// コンストラクタ引数から一度だけ特殊化を選ぶ. thread_count は setThreadCount と同じで,
+// 多数のエンジンを並べて回すときは1にすると使わないスレッドを作らずに済む
+// Chooses the specialization once from the constructor arguments. thread_count is as in setThreadCount;
+// pass 1 when running many engines side by side, so no unused threads get created
+std::unique_ptr<CAEngineBase> makeCAEngine(int dim, int length, const Rule& rule,
+    bool isNeumannNeighborhood, bool isTorus, EngineKind kind = EngineKind::Bitwise, int thread_count = 0);
+
+#endif // CA_ENGINE_H_
@@ -1,8 +1,81 @@
 #include "CA.h"
+#include "BrickMap.h"
+#include "CA2D.h"
+#include "EnsembleEngine.h"
+#include "Fft.h"
+#include "GenerationsEngine.h"
+#include "HashLife.h"
+#include "LargerThanLife.h"
+#include "LeniaEngine.h"
+#include "MortonEngine.h"
+#include "RuleSweep.h"
+#include "SparseEngine.h"
 #include <vector>
 #include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <utility>
+
+// progressField中のヒープ確保を数えるためにグローバルなnewを置き換える
+// Replace global operator new so that heap allocations during progressField can be counted
+static long long allocation_count = 0;
+
+void* operator new(std::size_t size) {
+    allocation_count++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// MinGWにはaligned_allocが無いので, 元のポインタを直前に保存して自前で揃える
+// MinGW lacks aligned_alloc, so align by hand and stash the raw pointer just before the block
+void* operator new(std::size_t size, std::align_val_t align) {
+    allocation_count++;
+    std::size_t a = static_cast<std::size_t>(align);
+    if (void* raw = std::malloc(size + a + sizeof(void*))) {
+        std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + a - 1) / a * a;
+        reinterpret_cast<void**>(p)[-1] = raw;
+        return reinterpret_cast<void*>(p);
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (p) std::free(reinterpret_cast<void**>(p)[-1]);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    if (p) std::free(reinterpret_cast<void**>(p)[-1]);
+}
 
 void print(const std::vector<std::vector<std::vector<bool>>>& v);
+bool checkNoAllocation();
+bool checkFieldView();
+bool checkRuleParse();
+bool checkThreadCountInvariance();
+bool checkTemporalBlocking();
+bool checkBrickSkipping();
+bool checkKernelIsaAgreement();
+bool checkEventEngine();
+bool checkSparseEngine();
+bool checkHashLife();
+bool checkBrickMap();
+bool checkMortonLayout();
+bool checkGenerationStats();
+bool checkCycleDetection();
+bool checkEnsembleEngine();
+bool checkRuleSweep();
+bool checkLargerThanLife();
+bool checkGenerationsEngine();
+bool checkFft();
+bool checkLeniaEngine();
 
 int main() {
     std::vector<int> birth_condition{1, 2};
@@ -19,8 +92,1235 @@ int main() {
     std::cout << "\nNEXT\n";
     ca2.progressField();
     print(ca2.getField());
+
+    if (!checkNoAllocation()) return EXIT_FAILURE;
+    if (!checkFieldView()) return EXIT_FAILURE;
+    if (!checkRuleParse()) return EXIT_FAILURE;
+    if (!checkThreadCountInvariance()) return EXIT_FAILURE;
+    if (!checkTemporalBlocking()) return EXIT_FAILURE;
+    if (!checkBrickSkipping()) return EXIT_FAILURE;
+    if (!checkKernelIsaAgreement()) return EXIT_FAILURE;
+    if (!checkEventEngine()) return EXIT_FAILURE;
+    if (!checkSparseEngine()) return EXIT_FAILURE;
+    if (!checkHashLife()) return EXIT_FAILURE;
+    if (!checkBrickMap()) return EXIT_FAILURE;
+    if (!checkMortonLayout()) return EXIT_FAILURE;
+    if (!checkGenerationStats()) return EXIT_FAILURE;
+    if (!checkCycleDetection()) return EXIT_FAILURE;
+    if (!checkEnsembleEngine()) return EXIT_FAILURE;
+    if (!checkRuleSweep()) return EXIT_FAILURE;
+    if (!checkLargerThanLife()) return EXIT_FAILURE;
+    if (!checkGenerationsEngine()) return EXIT_FAILURE;
+    if (!checkFft()) return EXIT_FAILURE;
+    if (!checkLeniaEngine()) return EXIT_FAILURE;
+}
+
+// 構築後のprogressFieldがヒープ確保を行わないことを確認する
+// Check that progressField performs no heap allocation after construction
+bool checkNoAllocation() {
+    CA ca = CA(20, {4}, {2}, 0.1, false, false);
+    CA2D ca2d = CA2D(20, {3}, {2, 3}, 0.3, false, true);
+
+    long long before = allocation_count;
+    for (int t = 0; t < 10; t++) {
+        ca.progressField();
+        ca2d.progressField();
+    }
+    ca.progressField(7);
+    ca2d.progressField(7);
+    long long allocated = allocation_count - before;
+
+    std::cout << "\nallocations during progressField: " << allocated << '\n';
+    return allocated == 0;
+}
+
+// ビューがgetField()のコピーと同じ内容を指し, 世代番号を持つことを確認する
+// Check that the view sees the same cells as the getField() copy and carries the generation
+bool checkFieldView() {
+    CA ca = CA(70, {4}, {2}, 0.2, false, true);
+    ca.progressField();
+    auto copied = ca.getField();
+    const FieldView view = ca.getFieldView();
+
+    bool ok = view.generation() == 1;
+    for (int i = 0; i < 70; i++) {
+        for (int j = 0; j < 70; j++) {
+            for (int k = 0; k < 70; k++) {
+                if (view.at(i, j, k) != copied[i][j][k]) ok = false;
+            }
+        }
+    }
+
+    CA2D ca2d = CA2D(70, {3}, {2, 3}, 0.3, false, true);
+    auto copied2d = ca2d.getField();
+    const FieldView view2d = ca2d.getFieldView();
+    for (int i = 0; i < 70; i++) {
+        for (int j = 0; j < 70; j++) {
+            if (view2d.at(i, j) != copied2d[i][j]) ok = false;
+        }
+    }
+
+    std::cout << "field view matches getField: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+// B/S表記の解釈が条件リストからのコンパイルと一致することを確認する
+// Check that parsed B/S notations match rules compiled from condition lists
+bool checkRuleParse() {
+    bool ok = true;
+    ok = ok && Rule::parse("B4/S2").birthMask() == Rule({4}, {2}).birthMask();
+    ok = ok && Rule::parse("B4/S2").survivalMask() == Rule({4}, {2}).survivalMask();
+    ok = ok && Rule::parse("s23/b3").survivalMask() == Rule({3}, {2, 3}).survivalMask();
+    ok = ok && Rule::parse("B5,7,9/S4-6,26").birthMask() == Rule({5, 7, 9}, {}).birthMask();
+    ok = ok && Rule::parse("B5,7,9/S4-6,26").survivalMask() == Rule({}, {4, 5, 6, 26}).survivalMask();
+    ok = ok && Rule::parse("B4/S2,6").toString() == "B4/S2,6";
+    ok = ok && Rule({4}, {2}).isNextAlive(false, 4) && !Rule({4}, {2}).isNextAlive(true, 4);
+
+    for (const char* invalid: { "B4S2", "B4/S2,27", "B4/X2", "B4/S2/S3", "B4/Sa", "B3-1/S2" }) {
+        try {
+            Rule::parse(invalid);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+
+    CA ca = CA(10, "B4/S2", 0.1, false, false);
+    ca.progressField();
+
+    std::cout << "rule notation parsing: " << (ok ? "ok" : "broken") << '\n';
+    return ok;
+}
+
+// スレッド数を変えても同じ初期状態から同じ世代が得られることを確認する
+// Check that every thread count produces the same generations from the same initial state
+bool checkThreadCountInvariance() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        const int length = 75;
+        std::vector<std::unique_ptr<CAEngineBase>> engines;
+        for (int threads: { 1, 2, 5, 3 }) {
+            engines.push_back(makeCAEngine(dim, length, Rule::parse("B4/S2,3"), false, true));
+            engines.back()->setThreadCount(threads);
+        }
+        engines.back()->setTileSchedule(ThreadPool::Schedule::Static);
+        std::mt19937 eng(dim);
+        for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+            for (int j = 0; j < length; j++) {
+                for (int k = 0; k < length; k++) {
+                    const bool alive = eng() % 4 == 0;
+                    for (auto& e: engines) e->set(i, j, k, alive);
+                }
+            }
+        }
+        for (int t = 0; t < 12; t++) {
+            for (auto& e: engines) e->progressField();
+        }
+        for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+            for (int j = 0; j < length; j++) {
+                for (int k = 0; k < length; k++) {
+                    for (auto& e: engines) {
+                        if (e->get(i, j, k) != engines[0]->get(i, j, k)) ok = false;
+                    }
+                }
+            }
+        }
+        if (engines[2]->getThreadBusySeconds().size() != 5) ok = false;
+    }
+
+    std::cout << "results independent of thread count and schedule: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// progressField(n) が n回の progressField() と一致することを, 近傍・境界・次元の全組み合わせで確認する
+// Check that progressField(n) matches n calls to progressField() for every neighborhood, boundary and dimension
+bool checkTemporalBlocking() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isNeumann: { false, true }) {
+            for (bool isTorus: { false, true }) {
+                const int length = dim == 3 ? 70 : 300;
+                auto single = makeCAEngine(dim, length, Rule::parse("B3,4/S2,3,5"), isNeumann, isTorus);
+                auto blocked = makeCAEngine(dim, length, Rule::parse("B3,4/S2,3,5"), isNeumann, isTorus);
+                blocked->setThreadCount(3);
+                std::mt19937 eng(dim * 4 + isNeumann * 2 + isTorus);
+                for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                    for (int j = 0; j < length; j++) {
+                        for (int k = 0; k < length; k++) {
+                            const bool alive = eng() % 3 == 0;
+                            single->set(i, j, k, alive);
+                            blocked->set(i, j, k, alive);
+                        }
+                    }
+                }
+                for (int t = 0; t < 11; t++) single->progressField();
+                blocked->progressField(11);
+
+                if (blocked->getGeneration() != 11) ok = false;
+                for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                    for (int j = 0; j < length; j++) {
+                        for (int k = 0; k < length; k++) {
+                            if (single->get(i, j, k) != blocked->get(i, j, k)) ok = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "progressField(n) matches n single steps: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 変化の無いブリックを飛ばしても毎世代の結果が変わらず, 静まった場では更新が減ることを確認する
+// Check that skipping unchanged bricks never changes a generation, and that a quiet field steps fewer bricks
+bool checkBrickSkipping() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isTorus: { false, true }) {
+            const int length = dim == 3 ? 70 : 300;
+            const Rule rule = Rule::parse(dim == 3 ? "B6/S5,6,7" : "B3/S2,3");
+            auto full = makeCAEngine(dim, length, rule, false, isTorus);
+            auto skipping = makeCAEngine(dim, length, rule, false, isTorus);
+            full->setBrickSkipping(false);
+            std::mt19937 eng(dim * 2 + isTorus);
+            for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                for (int j = 0; j < length; j++) {
+                    for (int k = 0; k < length; k++) {
+                        const bool alive = eng() % (dim == 3 ? 10 : 100) == 0;
+                        full->set(i, j, k, alive);
+                        skipping->set(i, j, k, alive);
+                    }
+                }
+            }
+            for (int t = 0; t < 30; t++) {
+                full->progressField();
+                skipping->progressField();
+                for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                    for (int j = 0; j < length; j++) {
+                        for (int k = 0; k < length; k++) {
+                            if (full->get(i, j, k) != skipping->get(i, j, k)) ok = false;
+                        }
+                    }
+                }
+            }
+            if (skipping->getActiveBrickFraction() >= 0.5) ok = false;
+        }
+    }
+
+    std::cout << "brick skipping matches full stepping: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// このCPUで使える命令セットのカーネルがどれもスカラー版と同じ世代を作ることを, 1世代ずつと
+// progressField(5) の両方で, 次元・近傍・境界・ベクトル幅に揃わない大きさを含めて確認する
+// Check that every kernel ISA this CPU supports produces the same generations as the scalar kernel,
+// both one step at a time and through progressField(5), over dimensions, neighborhoods, boundaries and
+// sizes that do not line up with the vector width
+bool checkKernelIsaAgreement() {
+    bool ok = true;
+    for (KernelIsa isa: { KernelIsa::AVX2, KernelIsa::AVX512 }) {
+        if (!isKernelIsaSupported(isa)) continue;
+        for (int dim: { 2, 3 }) {
+            for (bool isNeumann: { false, true }) {
+                for (bool isTorus: { false, true }) {
+                    for (int length: { 5, 37, 64, 70, 130 }) {
+                        const int ni = dim == 3 ? length : 1;
+                        const Rule rule = Rule::parse(dim == 3 ? "B5,6,7/S4,5,6" : "B3/S2,3");
+                        auto scalar = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                        auto vector = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                        scalar->setKernelIsa(KernelIsa::Scalar);
+                        vector->setKernelIsa(isa);
+                        std::mt19937 eng(length * 8 + dim * 4 + isNeumann * 2 + isTorus);
+                        for (int i = 0; i < ni; i++) {
+                            for (int j = 0; j < length; j++) {
+                                for (int k = 0; k < length; k++) {
+                                    const bool alive = eng() % 3 == 0;
+                                    scalar->set(i, j, k, alive);
+                                    vector->set(i, j, k, alive);
+                                }
+                            }
+                        }
+                        for (int step = 0; step < 3; step++) {
+                            // 2回は1世代ずつ, 最後は5世代まとめて進める
+                            // Two single steps, then five generations at once
+                            if (step < 2) {
+                                scalar->progressField();
+                                vector->progressField();
+                            } else {
+                                scalar->progressField(5);
+                                vector->progressField(5);
+                            }
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) {
+                                        ok = ok && scalar->get(i, j, k) == vector->get(i, j, k);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "kernel ISAs match the scalar kernel: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 近傍数を差分で保つエンジンがビット版と同じ世代を作り, 途中で引き継いでも一致することを確認する
+// Check that the incremental neighbor-count engine matches the bitwise engine, including after a hand-over
+bool checkEventEngine() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isNeumann: { false, true }) {
+            for (bool isTorus: { false, true }) {
+                for (const char* notation: { "B3/S2,3", "B0,5/S1,4" }) {
+                    const int length = dim == 3 ? 21 : 45;
+                    const Rule rule = Rule::parse(notation);
+                    auto bitwise = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                    auto events = makeCAEngine(dim, length, rule, isNeumann, isTorus, EngineKind::EventDriven);
+                    std::mt19937 eng(dim * 4 + isNeumann * 2 + isTorus);
+                    for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                        for (int j = 0; j < length; j++) {
+                            for (int k = 0; k < length; k++) {
+                                const bool alive = eng() % 8 == 0;
+                                bitwise->set(i, j, k, alive);
+                                events->set(i, j, k, alive);
+                            }
+                        }
+                    }
+                    for (int t = 0; t < 12; t++) {
+                        if (t == 6) {
+                            auto handed_over = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                            handed_over->copyStateFrom(*events);
+                            bitwise = std::move(handed_over);
+                        }
+                        if (t == 9) {
+                            auto handed_over = makeCAEngine(dim, length, rule, isNeumann, isTorus, EngineKind::EventDriven);
+                            handed_over->copyStateFrom(*bitwise);
+                            events = std::move(handed_over);
+                        }
+                        bitwise->progressField();
+                        events->progressField();
+                        for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                            for (int j = 0; j < length; j++) {
+                                for (int k = 0; k < length; k++) {
+                                    if (bitwise->get(i, j, k) != events->get(i, j, k)) ok = false;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 更新方式を切り替えても, スレッド数とカーネルの設定は残る
+    // Switching the engine keeps the thread count and kernel settings
+    CA ca = CA(20, "B3/S2,3", 0.3, false, true);
+    CA2D ca2d = CA2D(20, {3}, {2, 3}, 0.3, false, true);
+    ca.setThreadCount(3);
+    ca2d.setThreadCount(3);
+    ca.setKernelIsa(KernelIsa::Scalar);
+    ca2d.setKernelIsa(KernelIsa::Scalar);
+    for (EngineKind kind: { EngineKind::EventDriven, EngineKind::Bitwise }) {
+        ca.setEngineKind(kind);
+        ca2d.setEngineKind(kind);
+        ok = ok && ca.getThreadCount() == 3 && ca.getKernelIsa() == KernelIsa::Scalar;
+        ok = ok && ca2d.getThreadCount() == 3 && ca2d.getKernelIsa() == KernelIsa::Scalar;
+    }
+
+    // セル番号が32ビットに収まらない大きさは, 場を確保する前に拒まれる
+    // Sizes whose cell ids overflow 32 bits are rejected before the field is allocated
+    try {
+        makeCAEngine(3, 1626, Rule::parse("B3/S2,3"), false, true, EngineKind::EventDriven);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    std::cout << "event-driven engine matches bitwise engine: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// ハッシュ集合のエンジンがビット版と一致し, 1辺2万の平面でもグライダーを運べることを確認する
+// Check that the hash-set engine matches the bitwise engine and carries a glider across a 20000-wide plane
+bool checkSparseEngine() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isNeumann: { false, true }) {
+            for (bool isTorus: { false, true }) {
+                for (const char* notation: { "B3/S2,3", "B2,5/S0,4" }) {
+                    const int length = dim == 3 ? 19 : 40;
+                    const Rule rule = Rule::parse(notation);
+                    auto bitwise = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                    SparseEngine sparse(dim, length, rule, isNeumann, isTorus);
+                    std::mt19937 eng(dim * 4 + isNeumann * 2 + isTorus);
+                    for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                        for (int j = 0; j < length; j++) {
+                            for (int k = 0; k < length; k++) {
+                                const bool alive = eng() % 8 == 0;
+                                bitwise->set(i, j, k, alive);
+                                sparse.set(i, j, k, alive);
+                            }
+                        }
+                    }
+                    for (int t = 0; t < 10; t++) {
+                        bitwise->progressField();
+                        sparse.progressField();
+                        for (int i = 0; i < (dim == 3 ? length : 1); i++) {
+                            for (int j = 0; j < length; j++) {
+                                for (int k = 0; k < length; k++) {
+                                    if (bitwise->get(i, j, k) != sparse.get(i, j, k)) ok = false;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // グライダーは4世代で斜めに1セル進む
+    // A glider moves one cell diagonally every four generations
+    SparseEngine plane(2, 20000, Rule::parse("B3/S2,3"), false, true);
+    const int glider[5][2] = { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 1 }, { 2, 2 } };
+    for (const auto& c: glider) plane.set(0, 19990 + c[0], 19990 + c[1], true);
+    plane.progressField(400);
+    ok = ok && plane.getPopulation() == 5;
+    for (const auto& c: glider) ok = ok && plane.get(0, (19990 + c[0] + 100) % 20000, (19990 + c[1] + 100) % 20000);
+
+    // 集団が一度大きくなっても, 減った後の表は小さく戻る
+    // Once a large population dies down, the tables shrink back
+    SparseEngine burst(2, 4096, Rule::parse("B3/S2,3"), false, true);
+    for (int j = 0; j < 4096; j += 4) {
+        for (int k = 0; k < 4096; k += 4) burst.set(0, j, k, true);
+    }
+    burst.progressField(3);
+    ok = ok && burst.getPopulation() == 0;
+    CellTable table;
+    for (uint64_t key = 0; key < 100000; key++) table[key] = 1;
+    table.clear();
+    for (uint64_t key = 0; key < 10; key++) table[key] = 1;
+    table.clear();
+    ok = ok && table.size() == 0 && table.capacity() <= 64;
+
+    try {
+        SparseEngine(3, 10, Rule::parse("B0/S2"), false, true);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    // 場の外の座標は別のセルや空きの印に重ならずに拒まれる
+    // Coordinates outside the field are rejected instead of aliasing another cell or the empty marker
+    SparseEngine small(3, 100, Rule::parse("B3/S2,3"), false, true);
+    SparseEngine flat(2, 100, Rule::parse("B3/S2,3"), false, true);
+    const int outside[][3] = { { -1, -1, -1 }, { 200, 0, 0 }, { 0, 100, 0 }, { 0, 0, -5 } };
+    for (const auto& c: outside) {
+        try {
+            small.set(c[0], c[1], c[2], true);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+        try {
+            small.get(c[0], c[1], c[2]);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    try {
+        flat.set(1, 0, 0, true);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+    ok = ok && small.getPopulation() == 0 && flat.getPopulation() == 0;
+
+    std::cout << "sparse engine matches bitwise engine: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// HashLife がハッシュ集合のエンジンと密な場に一致し, 静止パターンを10億世代先まで進められることを確認する
+// Check that HashLife matches the hash-set engine and the dense field, and jumps a still life a billion generations
+bool checkHashLife() {
+    bool ok = true;
+    for (bool isNeumann: { false, true }) {
+        for (const char* notation: { "B5,6,7/S4,5,6", "B2,5/S0,4" }) {
+            const Rule rule = Rule::parse(notation);
+            HashLife hashlife(rule, isNeumann);
+            // Neumann近傍では上限を小さくして, 世代を進めるたびに掃除が走るようにする
+            // With the von Neumann neighborhood, a tiny limit makes collection run before every jump
+            if (isNeumann) hashlife.setMemoryLimit(1 << 16);
+            SparseEngine sparse(3, 4096, rule, isNeumann, false);
+            std::mt19937 eng(isNeumann);
+            for (int i = -6; i < 6; i++) {
+                for (int j = -6; j < 6; j++) {
+                    for (int k = -6; k < 6; k++) {
+                        const bool alive = eng() % 3 == 0;
+                        hashlife.set(i, j, k, alive);
+                        sparse.set(2048 + i, 2048 + j, 2048 + k, alive);
+                    }
+                }
+            }
+            hashlife.advance(37);
+            sparse.progressField(37);
+            ok = ok && hashlife.getGeneration() == 37 && hashlife.getPopulation() == sparse.getPopulation();
+            for (const auto& c: sparse.getLiveCells()) ok = ok && hashlife.get(c[0] - 2048, c[1] - 2048, c[2] - 2048);
+        }
+    }
+
+    // 場の端から離れた塊なら, 密な場を読み込んで進めて書き戻した結果が密な場での計算と一致する
+    // For a blob far from the edges, loading a dense field, advancing and storing back matches the dense run
+    CA dense = CA(60, "B5,6,7/S4,5,6", 0, false, false);
+    std::mt19937 eng(7);
+    for (int i = 27; i < 33; i++) {
+        for (int j = 27; j < 33; j++) {
+            for (int k = 27; k < 33; k++) dense.setCell(i, j, k, eng() % 2 == 0);
+        }
+    }
+    HashLife loaded(Rule::parse("B5,6,7/S4,5,6"), false);
+    loaded.loadField(dense.getFieldView());
+    loaded.advance(10);
+    dense.progressField(10);
+    CA stored = CA(60, "B5,6,7/S4,5,6", 0.5, false, false);
+    loaded.storeField(stored);
+    const FieldView expected = dense.getFieldView();
+    const FieldView actual = stored.getFieldView();
+    for (int i = 0; i < 60; i++) {
+        for (int j = 0; j < 60; j++) {
+            for (int k = 0; k < 60; k++) ok = ok && expected.at(i, j, k) == actual.at(i, j, k);
+        }
+    }
+
+    // B5/S7 では 2x2x2 の立方体が静止する
+    // A 2x2x2 cube is a still life under B5/S7
+    HashLife cube(Rule::parse("B5/S7"), false);
+    for (int c = 0; c < 8; c++) cube.set(c >> 2, (c >> 1) & 1, c & 1, true);
+    cube.advance(1000000000ULL);
+    ok = ok && cube.getGeneration() == 1000000000ULL && cube.getPopulation() == 8 && cube.get(1, 1, 1);
+    // 跳躍は 2^60 世代未満まで. それ以上と範囲外の座標は受け付けない
+    // Jumps stop short of 2^60 generations; more than that, and out-of-range coordinates, are rejected
+    cube.advance((1ULL << 60) - 1);
+    ok = ok && cube.getPopulation() == 8 && cube.get(0, 0, 0);
+    for (unsigned long long n: { 1ULL << 60, ~0ULL }) {
+        try {
+            cube.advance(n);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    try {
+        cube.set(1LL << 62, 0, 0, true);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    try {
+        HashLife(Rule::parse("B0/S2"), false);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    std::cout << "hashlife matches sparse and dense engines: " << (ok ? "yes" : "no") << '\n';
+    return ok;
 }
 
+// ブリックの表がハッシュ集合のエンジンと一致し, 負の座標へも広がり, 空のブリックを捨てることを確認する
+// Check that the brick map matches the hash-set engine, grows into negative coordinates and frees empty bricks
+bool checkBrickMap() {
+    bool ok = true;
+    for (bool isNeumann: { false, true }) {
+        for (const char* notation: { "B5,6,7/S4,5,6", "B2,5/S0,4" }) {
+            const Rule rule = Rule::parse(notation);
+            BrickMap bricks(rule, isNeumann);
+            SparseEngine sparse(3, 4096, rule, isNeumann, false);
+            std::mt19937 eng(isNeumann);
+            // ブリックの角 (0, 0, 0) と k 方向のワード境界をまたぐ塊
+            // A blob straddling the brick corner at (0, 0, 0) and a word boundary along k
+            for (int i = -6; i < 6; i++) {
+                for (int j = -6; j < 6; j++) {
+                    for (int k = -6; k < 6; k++) {
+                        const bool alive = eng() % 3 == 0;
+                        bricks.set(i, j, 64 + k, alive);
+                        sparse.set(2048 + i, 2048 + j, 2048 + 64 + k, alive);
+                    }
+                }
+            }
+            for (int t = 0; t < 20; t++) {
+                bricks.progressField();
+                sparse.progressField();
+            }
+            ok = ok && bricks.getGeneration() == 20 && bricks.getPopulation() == sparse.getPopulation();
+            for (const auto& c: sparse.getLiveCells()) ok = ok && bricks.get(c[0] - 2048, c[1] - 2048, c[2] - 2048);
+        }
+    }
+
+    // 孤立したセルは B3/S2,3 では1世代で消え, ブリックも残らない
+    // A lone cell dies in one generation under B3/S2,3, and no brick is left behind
+    BrickMap lonely(Rule::parse("B3/S2,3"), false);
+    lonely.set(-100, 5, 1000000, true);
+    ok = ok && lonely.getBrickCount() == 1 && lonely.get(-100, 5, 1000000);
+    lonely.progressField();
+    ok = ok && lonely.getBrickCount() == 0 && lonely.getPopulation() == 0;
+
+    try {
+        BrickMap(Rule::parse("B0/S2"), false);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    // 鍵の範囲外の座標は折り返して別のセルと重ならずに拒まれる
+    // Coordinates past the key range are rejected instead of wrapping onto other cells
+    BrickMap edge(Rule::parse("B3/S2,3"), false);
+    try {
+        edge.set(1LL << 24, 0, 0, true);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+    ok = ok && edge.getBrickCount() == 0 && !edge.get(-(1LL << 24), 0, 0) && !edge.get(1LL << 24, 0, 0);
+
+    // 範囲の端で広がる3セルの棒は, 範囲外へ出る世代で止まり場は変わらない
+    // A three-cell blinker on the edge of the range stops at the generation that would leave it, unchanged
+    const long long top = (1LL << 23) - 1;
+    for (int d = -1; d <= 1; d++) edge.set(0, top, d, true);
+    try {
+        edge.progressField();
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+    ok = ok && edge.getGeneration() == 0 && edge.getPopulation() == 3 && edge.get(0, top, 0);
+
+    std::cout << "brick map matches sparse engine: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// Z順のブリック配置のエンジンが行優先の場と一致することを, 端で欠けたブリックのある大きさで確認する
+// Check that the Z-ordered brick engine matches the row-major field, at sizes with partial bricks at the edges
+bool checkMortonLayout() {
+    bool ok = true;
+    for (int length: { 5, 37, 260 }) {
+        for (bool isNeumann: { false, true }) {
+            for (bool isTorus: { false, true }) {
+                if (length == 260 && isNeumann) continue;
+                CA flat = CA(length, "B5,6,7/S4,5,6", 0.2, isNeumann, isTorus);
+                MortonEngine morton(length, Rule::parse("B5,6,7/S4,5,6"), isNeumann, isTorus);
+                morton.loadField(flat.getFieldView());
+                for (int t = 0; t < 3; t++) {
+                    flat.progressField();
+                    morton.progressField();
+                }
+                const FieldView expected = flat.getFieldView();
+                const FieldView actual = morton.getFieldView();
+                ok = ok && actual.layout() == FieldLayout::MortonBricks && actual.generation() == 3;
+                for (int i = 0; i < length; i++) {
+                    for (int j = 0; j < length; j++) {
+                        for (int k = 0; k < length; k++) {
+                            if (expected.at(i, j, k) != actual.at(i, j, k)) ok = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "morton brick layout matches flat layout: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// カーネルが集めた世代の統計が, 前後の場から数え直した値と一致することを命令セットごとに確認する.
+// 疎な場ではブリック飛ばしの経路, 分布を有効にすると全体更新の経路を通る
+// Check for each kernel ISA that the generation statistics gathered by the kernel match a recount from
+// the fields before and after. Sparse fields take the brick-skipping path, and enabling the histogram the dense path
+bool checkGenerationStats() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isNeumann: { false, true }) {
+            for (bool isTorus: { false, true }) {
+                for (EngineKind kind: { EngineKind::Bitwise, EngineKind::EventDriven }) {
+                    for (KernelIsa isa: { KernelIsa::Scalar, KernelIsa::AVX2, KernelIsa::AVX512 }) {
+                        // イベント駆動のエンジンは命令セットを使わないので1度だけ
+                        // The event-driven engine ignores the ISA, so it runs once
+                        if (!isKernelIsaSupported(isa) || (kind == EngineKind::EventDriven && isa != KernelIsa::Scalar)) continue;
+                        for (bool histogram: { false, true }) {
+                            const int length = dim == 3 ? 37 : 100;
+                            const int ni = dim == 3 ? length : 1;
+                            const Rule rule = Rule::parse("B3/S2,3");
+                            auto engine = makeCAEngine(dim, length, rule, isNeumann, isTorus, kind);
+                            auto reference = makeCAEngine(dim, length, rule, isNeumann, isTorus);
+                            engine->setKernelIsa(isa);
+                            engine->setStatsCollection(true);
+                            engine->setNeighborHistogram(histogram);
+                            std::mt19937 eng(dim * 8 + isNeumann * 4 + isTorus * 2 + histogram);
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) {
+                                        // 分布なしでは一角だけに置いてブリックを飛ばさせる
+                                        // Without the histogram seed one corner only, so bricks get skipped
+                                        const bool corner = i < 12 && j > length - 20 && k < 30;
+                                        const bool alive = (histogram || corner) && eng() % 4 == 0;
+                                        engine->set(i, j, k, alive);
+                                        reference->set(i, j, k, alive);
+                                    }
+                                }
+                            }
+
+                            std::vector<uint8_t> before((std::size_t)ni * length * length);
+                            for (int t = 0; t < 8; t++) {
+                                // progressField(n) は最後の1世代だけを統計付きで進める
+                                // progressField(n) steps only its last generation with statistics
+                                const int steps = t == 5 ? 3 : 1;
+                                if (steps > 1) reference->progressField(steps - 1);
+                                for (int i = 0; i < ni; i++) {
+                                    for (int j = 0; j < length; j++) {
+                                        for (int k = 0; k < length; k++) {
+                                            before[((std::size_t)i * length + j) * length + k] = reference->get(i, j, k);
+                                        }
+                                    }
+                                }
+                                reference->progressField();
+                                engine->progressField(steps);
+
+                                GenerationStats expected;
+                                expected.generation = engine->getGeneration();
+                                auto at = [&](int i, int j, int k) -> int {
+                                    if (isTorus) {
+                                        i = (i + ni) % ni;
+                                        j = (j + length) % length;
+                                        k = (k + length) % length;
+                                    } else if (i < 0 || i >= ni || j < 0 || j >= length || k < 0 || k >= length) {
+                                        return 0;
+                                    }
+                                    return before[((std::size_t)i * length + j) * length + k];
+                                };
+                                for (int i = 0; i < ni; i++) {
+                                    for (int j = 0; j < length; j++) {
+                                        for (int k = 0; k < length; k++) {
+                                            const bool was = at(i, j, k);
+                                            const bool alive = engine->get(i, j, k);
+                                            int count = 0;
+                                            for (int di = (dim == 3 ? -1 : 0); di <= (dim == 3 ? 1 : 0); di++) {
+                                                for (int dj = -1; dj <= 1; dj++) {
+                                                    for (int dk = -1; dk <= 1; dk++) {
+                                                        const int distance = (di != 0) + (dj != 0) + (dk != 0);
+                                                        if (distance == 0 || (isNeumann && distance > 1)) continue;
+                                                        count += at(i + di, j + dj, k + dk);
+                                                    }
+                                                }
+                                            }
+                                            expected.histogram[count]++;
+                                            expected.births += alive && !was;
+                                            expected.deaths += was && !alive;
+                                            if (!alive) continue;
+                                            if (expected.population == 0) {
+                                                expected.i_min = expected.j_min = expected.k_min = length;
+                                            }
+                                            expected.population++;
+                                            expected.i_min = std::min(expected.i_min, i);
+                                            expected.i_max = std::max(expected.i_max, i);
+                                            expected.j_min = std::min(expected.j_min, j);
+                                            expected.j_max = std::max(expected.j_max, j);
+                                            expected.k_min = std::min(expected.k_min, k);
+                                            expected.k_max = std::max(expected.k_max, k);
+                                        }
+                                    }
+                                }
+
+                                const GenerationStats actual = engine->getGenerationStats();
+                                ok = ok && actual.generation == expected.generation && actual.has_changes
+                                    && actual.population == expected.population && actual.births == expected.births
+                                    && actual.deaths == expected.deaths && actual.has_histogram == histogram;
+                                if (expected.population > 0) {
+                                    ok = ok && actual.i_min == expected.i_min && actual.i_max == expected.i_max
+                                        && actual.j_min == expected.j_min && actual.j_max == expected.j_max
+                                        && actual.k_min == expected.k_min && actual.k_max == expected.k_max;
+                                }
+                                if (histogram) ok = ok && actual.histogram == expected.histogram;
+                            }
+
+                            // 書き換えた後は場から数え直す
+                            // After an edit the statistics are recounted from the field
+                            engine->set(0, 0, 0, !engine->get(0, 0, 0));
+                            const GenerationStats edited = engine->getGenerationStats();
+                            ok = ok && !edited.has_changes && edited.births == 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "generation statistics match a recount: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 差分で更新した場のハッシュが場全体から計算した値と一致し, 振動子の周期を見つけて止めたり
+// 早送りしたりできることを確認する
+// Check that the incrementally updated field hash matches one computed from the whole field, and that
+// an oscillator's period is found and can be stopped at or fast-forwarded through
+bool checkCycleDetection() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isTorus: { false, true }) {
+            for (EngineKind kind: { EngineKind::Bitwise, EngineKind::EventDriven }) {
+                const int length = dim == 3 ? 37 : 100;
+                const int ni = dim == 3 ? length : 1;
+                const Rule rule = Rule::parse("B3/S2,3");
+                auto engine = makeCAEngine(dim, length, rule, false, isTorus, kind);
+                auto copy = makeCAEngine(dim, length, rule, false, isTorus);
+                engine->setCycleDetection(true);
+                std::mt19937 eng(dim * 4 + isTorus * 2 + (kind == EngineKind::EventDriven));
+                for (int i = 0; i < ni; i++) {
+                    for (int j = 0; j < length; j++) {
+                        for (int k = 0; k < length; k++) {
+                            const bool corner = i < 12 && j > length - 20 && k < 30;
+                            engine->set(i, j, k, corner && eng() % 4 == 0);
+                        }
+                    }
+                }
+                for (int t = 0; t < 8; t++) {
+                    engine->progressField(t == 5 ? 3 : 1);
+                    copy->copyStateFrom(*engine);
+                    ok = ok && engine->getFieldHash() == copy->getFieldHash();
+                }
+            }
+        }
+    }
+
+    // 周期2の棒と周期1のブロック
+    // A period-2 blinker and a period-1 block
+    for (EngineKind kind: { EngineKind::Bitwise, EngineKind::EventDriven }) {
+        const Rule rule = Rule::parse("B3/S2,3");
+        auto engine = makeCAEngine(2, 40, rule, false, true, kind);
+        auto reference = makeCAEngine(2, 40, rule, false, true);
+        for (auto cell: { std::make_pair(5, 10), std::make_pair(5, 11), std::make_pair(5, 12),
+            std::make_pair(20, 20), std::make_pair(20, 21), std::make_pair(21, 20), std::make_pair(21, 21) }) {
+            engine->set(0, cell.first, cell.second, true);
+            reference->set(0, cell.first, cell.second, true);
+        }
+        engine->setCycleDetection(true);
+        engine->progressField(3);
+        const CycleInfo found = engine->getCycle();
+        ok = ok && found.found && found.start == 0 && found.period == 2;
+
+        engine->setCycleAction(CycleAction::FastForward);
+        engine->progressField(1001);
+        reference->progressField(1004);
+        ok = ok && engine->getGeneration() == 1004;
+        for (int j = 0; j < 40; j++) {
+            for (int k = 0; k < 40; k++) ok = ok && engine->get(0, j, k) == reference->get(0, j, k);
+        }
+
+        engine->setCycleAction(CycleAction::Stop);
+        engine->progressField(10);
+        engine->progressField();
+        ok = ok && engine->getGeneration() == 1004;
+
+        // 書き換えると周期を忘れ, また進む
+        // An edit forgets the cycle, and stepping resumes
+        engine->set(0, 30, 30, true);
+        engine->progressField();
+        ok = ok && engine->getGeneration() == 1005 && !engine->getCycle().found;
+    }
+
+    std::cout << "cycle detection finds periods with consistent hashes: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 集団のエンジンで進めた世界が, 同じ初期配置から1つずつ進めた場と一致し, 個体数も合うことを確認する
+// Check that worlds advanced by the ensemble engine match fields stepped one at a time from the same
+// start, and that their populations agree
+bool checkEnsembleEngine() {
+    bool ok = true;
+    for (KernelIsa isa: { KernelIsa::Scalar, KernelIsa::AVX2, KernelIsa::AVX512 }) {
+        if (!isKernelIsaSupported(isa)) continue;
+        for (int dim: { 2, 3 }) {
+            for (bool isNeumann: { false, true }) {
+                for (bool isTorus: { false, true }) {
+                    for (int worlds: { 64, 512 }) {
+                        const int length = dim == 3 ? 13 : 37;
+                        const int ni = dim == 3 ? length : 1;
+                        const Rule rule = Rule::parse(dim == 3 ? "B5,6,7/S4,5,6" : "B3/S2,3");
+                        EnsembleEngine ensemble(dim, length, worlds, rule, isNeumann, isTorus);
+                        ensemble.setKernelIsa(isa);
+                        std::vector<float> ratios(worlds);
+                        for (int w = 0; w < worlds; w++) ratios[w] = 0.05f + 0.5f * w / worlds;
+                        ensemble.randomize(ratios, dim * 4 + isNeumann * 2 + isTorus);
+
+                        std::vector<std::unique_ptr<CAEngineBase>> singles;
+                        const int sampled[] = { 0, 1, 63, worlds - 1, worlds / 2 + 5 };
+                        for (int w: sampled) {
+                            singles.push_back(makeCAEngine(dim, length, rule, isNeumann, isTorus));
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) singles.back()->set(i, j, k, ensemble.get(w, i, j, k));
+                                }
+                            }
+                        }
+                        ensemble.progressField(4);
+                        const std::vector<uint64_t> populations = ensemble.getPopulations();
+                        for (std::size_t s = 0; s < singles.size(); s++) {
+                            singles[s]->progressField(4);
+                            uint64_t population = 0;
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) {
+                                        const bool alive = singles[s]->get(i, j, k);
+                                        ok = ok && ensemble.get(sampled[s], i, j, k) == alive;
+                                        population += alive;
+                                    }
+                                }
+                            }
+                            ok = ok && populations[sampled[s]] == population;
+                        }
+                        ok = ok && ensemble.getGeneration() == 4;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "ensemble worlds match single engines: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 掃引の分類が, 振る舞いの分かっている規則で期待どおりになることを確認する
+// Check that the sweep classifies rules with known behavior as expected
+bool checkRuleSweep() {
+    std::vector<int> all_counts;
+    for (int c = 0; c <= Rule::MAX_COUNT; c++) all_counts.push_back(c);
+    std::vector<int> crowded_counts;
+    for (int c = 8; c <= Rule::MAX_COUNT; c++) crowded_counts.push_back(c);
+    const std::vector<SweepJob> jobs = {
+        { Rule(std::vector<int>{}, std::vector<int>{}), 0.2f, 1 },
+        { Rule(std::vector<int>{}, all_counts), 0.2f, 2 },
+        { Rule(std::vector<int>{ 1 }, all_counts), 0.01f, 3 },
+        { Rule::parse("B4/S2"), 0.3f, 4 },
+        // 初期密度が 0.5 以上でも, 空きセルを埋め尽くせば爆発
+        // Filling the empty cells explodes even when seeded at 0.5 or more
+        { Rule(crowded_counts, all_counts), 0.6f, 5 },
+    };
+    const Behavior expected[] = {
+        Behavior::DiesOut, Behavior::Stabilizes, Behavior::Explodes, Behavior::Chaotic, Behavior::Explodes,
+    };
+    SweepSettings settings;
+    settings.length = 24;
+    settings.generations = 100;
+    const std::vector<SweepResult> results = runSweep(jobs, settings, 2);
+
+    bool ok = results.size() == jobs.size();
+    for (std::size_t r = 0; ok && r < results.size(); r++) {
+        ok = results[r].behavior == expected[r] && results[r].job.seed == jobs[r].seed;
+    }
+    // ワーカーが使い回したエンジンでも, 試行ごとに新しく作ったエンジンと同じ結果になる
+    // Engines reused by the workers give the same results as a fresh engine per job
+    for (std::size_t r = 0; ok && r < results.size(); r++) {
+        const SweepResult fresh = runSweepJob(jobs[r], settings);
+        ok = fresh.behavior == results[r].behavior && fresh.generations == results[r].generations
+            && fresh.final_population == results[r].final_population && fresh.period == results[r].period;
+    }
+    // 何もしない規則は最初の世代で周期1に入る
+    // The do-nothing rule enters a period-1 cycle right away
+    ok = ok && results[1].period == 1 && results[1].generations == 1;
+    std::ostringstream csv;
+    writeSweepCsv(csv, results);
+    ok = ok && csv.str().find("\"B4/S2\",0.3,4,chaotic,100,") != std::string::npos;
+    std::cout << "rule sweep classifies known rules: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// 大きな半径の近傍数を素朴に数えた結果と, 半径1の範囲規則がビット版のエンジンと一致することを確認する
+// Check large-radius counts against a naive count, and radius-1 range rules against the bitwise engine
+bool checkLargerThanLife() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (bool isTorus: { false, true }) {
+            for (int radius: { 1, 2, 5, 10 }) {
+                // 3次元で半径10なら窓が場より長く, トーラスでは同じセルを何度も数える
+                // At radius 10 in 3D the window is longer than the field, so the torus counts cells repeatedly
+                const int length = dim == 3 ? 11 : 70;
+                const int ni = dim == 3 ? length : 1;
+                RangeRule rule;
+                rule.radius = radius;
+                rule.includes_center = radius % 2 == 0;
+                const int side = 2 * radius + 1;
+                const int volume = dim == 3 ? side * side * side : side * side;
+                rule.birth_min = volume / 5;
+                rule.birth_max = volume / 3;
+                rule.survival_min = volume / 6;
+                rule.survival_max = volume / 2;
+                LargerThanLifeEngine engine(dim, length, rule, isTorus);
+                engine.setThreadCount(2);
+                engine.randomize(0.3f, dim * 100 + isTorus * 10 + radius);
+
+                for (int t = 0; t < 2; t++) {
+                    std::vector<std::vector<std::vector<bool>>> expected(ni,
+                        std::vector<std::vector<bool>>(length, std::vector<bool>(length)));
+                    for (int i = 0; i < ni; i++) {
+                        for (int j = 0; j < length; j++) {
+                            for (int k = 0; k < length; k++) {
+                                int count = 0;
+                                const int ri = dim == 3 ? radius : 0;
+                                for (int di = -ri; di <= ri; di++) {
+                                    for (int dj = -radius; dj <= radius; dj++) {
+                                        for (int dk = -radius; dk <= radius; dk++) {
+                                            if (!rule.includes_center && di == 0 && dj == 0 && dk == 0) continue;
+                                            int ii = i + di;
+                                            int jj = j + dj;
+                                            int kk = k + dk;
+                                            if (isTorus) {
+                                                ii = (ii % ni + ni) % ni;
+                                                jj = (jj % length + length) % length;
+                                                kk = (kk % length + length) % length;
+                                            } else if (ii < 0 || ii >= ni || jj < 0 || jj >= length || kk < 0 || kk >= length) {
+                                                continue;
+                                            }
+                                            count += engine.get(ii, jj, kk);
+                                        }
+                                    }
+                                }
+                                expected[i][j][k] = rule.isNextAlive(engine.get(i, j, k), count);
+                            }
+                        }
+                    }
+                    engine.progressField();
+                    for (int i = 0; i < ni; i++) {
+                        for (int j = 0; j < length; j++) {
+                            for (int k = 0; k < length; k++) ok = ok && engine.get(i, j, k) == expected[i][j][k];
+                        }
+                    }
+                }
+            }
+
+            RangeRule life = RangeRule::parse(dim == 3 ? "R1,C0,M0,S4..6,B5..7,NM" : "R1,C0,M0,S2..3,B3..3,NM");
+            LargerThanLifeEngine engine(dim, 20, life, isTorus);
+            engine.randomize(0.3f, dim + isTorus);
+            auto bitwise = makeCAEngine(dim, 20, Rule::parse(dim == 3 ? "B5-7/S4-6" : "B3/S2,3"), false, isTorus);
+            const int ni = dim == 3 ? 20 : 1;
+            for (int i = 0; i < ni; i++) {
+                for (int j = 0; j < 20; j++) {
+                    for (int k = 0; k < 20; k++) bitwise->set(i, j, k, engine.get(i, j, k));
+                }
+            }
+            engine.progressField(5);
+            bitwise->progressField(5);
+            for (int i = 0; i < ni; i++) {
+                for (int j = 0; j < 20; j++) {
+                    for (int k = 0; k < 20; k++) ok = ok && engine.get(i, j, k) == bitwise->get(i, j, k);
+                }
+            }
+        }
+    }
+    ok = ok && RangeRule::parse("R5,C0,M1,S34..58,B34..45,NM").toString() == "R5,C0,M1,S34..58,B34..45,NM";
+    for (const char* bad: { "R11,C0,M1,S1..2,B3..4,NM", "R2,C0,M1,S1..2,NN", "R2,C3,M0,S1..2,B3..4,NM", "R2,S4..1,B1" }) {
+        try {
+            RangeRule::parse(bad);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    std::cout << "larger than life matches naive counts: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// Generations のカーネルを素朴な更新と比べ, 状態数2ならビット版のエンジンと一致することを確認する
+// Check the Generations kernels against a naive update, and against the bitwise engine with two states
+bool checkGenerationsEngine() {
+    bool ok = true;
+    for (KernelIsa isa: { KernelIsa::Scalar, KernelIsa::AVX2 }) {
+        if (!isKernelIsaSupported(isa)) continue;
+        for (int dim: { 2, 3 }) {
+            for (bool isNeumann: { false, true }) {
+                for (bool isTorus: { false, true }) {
+                    for (int states: { 2, 5 }) {
+                        const int length = dim == 3 ? 13 : 37;
+                        const int ni = dim == 3 ? length : 1;
+                        GenerationsRule rule;
+                        rule.rule = Rule::parse(dim == 3 ? (isNeumann ? "B1,2/S1-3" : "B4/S2-5") : (isNeumann ? "B1/S1,2" : "B2/S3,4"));
+                        rule.states = states;
+                        GenerationsEngine engine(dim, length, rule, isNeumann, isTorus);
+                        engine.setKernelIsa(isa);
+                        engine.setThreadCount(2);
+                        engine.randomize(0.3f, dim * 8 + isNeumann * 4 + isTorus * 2 + states);
+
+                        for (int t = 0; t < 4; t++) {
+                            std::vector<uint8_t> expected;
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) {
+                                        int count = 0;
+                                        for (int di = (dim == 3 ? -1 : 0); di <= (dim == 3 ? 1 : 0); di++) {
+                                            for (int dj = -1; dj <= 1; dj++) {
+                                                for (int dk = -1; dk <= 1; dk++) {
+                                                    const int distance = (di != 0) + (dj != 0) + (dk != 0);
+                                                    if (distance == 0 || (isNeumann && distance > 1)) continue;
+                                                    int ii = i + di;
+                                                    int jj = j + dj;
+                                                    int kk = k + dk;
+                                                    if (isTorus) {
+                                                        ii = (ii + ni) % ni;
+                                                        jj = (jj + length) % length;
+                                                        kk = (kk + length) % length;
+                                                    } else if (ii < 0 || ii >= ni || jj < 0 || jj >= length || kk < 0 || kk >= length) {
+                                                        continue;
+                                                    }
+                                                    count += engine.getState(ii, jj, kk) == 1;
+                                                }
+                                            }
+                                        }
+                                        const int state = engine.getState(i, j, k);
+                                        int next = (state + 1) % states;
+                                        if (state == 0) next = rule.rule.isNextAlive(false, count) ? 1 : 0;
+                                        else if (state == 1 && rule.rule.isNextAlive(true, count)) next = 1;
+                                        expected.push_back((uint8_t)next);
+                                    }
+                                }
+                            }
+                            engine.progressField();
+                            std::size_t c = 0;
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) ok = ok && engine.getState(i, j, k) == expected[c++];
+                                }
+                            }
+                        }
+
+                        if (states == 2) {
+                            GenerationsEngine fresh(dim, length, rule, isNeumann, isTorus);
+                            fresh.setKernelIsa(isa);
+                            fresh.randomize(0.3f, 7);
+                            auto bitwise = makeCAEngine(dim, length, rule.rule, isNeumann, isTorus);
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) bitwise->set(i, j, k, fresh.get(i, j, k));
+                                }
+                            }
+                            fresh.progressField(6);
+                            bitwise->progressField(6);
+                            uint64_t population = 0;
+                            for (int i = 0; i < ni; i++) {
+                                for (int j = 0; j < length; j++) {
+                                    for (int k = 0; k < length; k++) {
+                                        ok = ok && fresh.get(i, j, k) == bitwise->get(i, j, k);
+                                        population += bitwise->get(i, j, k);
+                                    }
+                                }
+                            }
+                            ok = ok && fresh.getStateCounts()[1] == population;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    ok = ok && GenerationsRule::parse("B4/S2/C6").toString() == "B4/S2/C6";
+    for (const char* bad: { "B4/S2", "B4/S2/C1", "B4/S2/C256", "B4/S2/Cx" }) {
+        try {
+            GenerationsRule::parse(bad);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    std::cout << "generations kernels match naive update: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// FFT を素朴な離散フーリエ変換と比べ, 逆変換で元に戻ることを確認する. 2の冪でない長さは Bluestein 法を通る
+// Check the FFTs against a naive discrete Fourier transform and that the inverse restores the input.
+// Lengths that are not powers of two go through Bluestein's algorithm
+bool checkFft() {
+    const double PI = 3.14159265358979323846;
+    bool ok = true;
+    std::mt19937 eng(5);
+    std::uniform_real_distribution<float> distr(-1, 1);
+    for (int n: { 1, 2, 7, 8, 12, 31 }) {
+        Fft fft(n);
+        std::vector<Fft::Complex> data(n);
+        for (Fft::Complex& x: data) x = Fft::Complex(distr(eng), distr(eng));
+        std::vector<Fft::Complex> transformed = data;
+        std::vector<Fft::Complex> scratch(fft.scratchSize());
+        fft.transform(transformed.data(), false, scratch.data());
+        for (int k = 0; k < n; k++) {
+            std::complex<double> expected = 0;
+            for (int j = 0; j < n; j++) {
+                expected += std::complex<double>(data[j]) * std::polar(1.0, -2 * PI * ((long long)j * k % n) / n);
+            }
+            ok = ok && std::abs(std::complex<double>(transformed[k]) - expected) < 1e-4 * n;
+        }
+        fft.transform(transformed.data(), true, scratch.data());
+        for (int k = 0; k < n; k++) ok = ok && std::abs(transformed[k] / (float)n - data[k]) < 1e-5f;
+    }
+
+    ThreadPool pool(2);
+    for (int dim: { 2, 3 }) {
+        for (int n: { 6, 8, 9 }) {
+            const int ni = dim == 3 ? n : 1;
+            const int h = n / 2 + 1;
+            RealFft3D fft(dim, n);
+            fft.reserveWorkers(pool.threadCount());
+            std::vector<float> field((std::size_t)ni * n * n);
+            for (float& x: field) x = distr(eng);
+            std::vector<Fft::Complex> spectrum(fft.spectrumSize());
+            fft.forward(field.data(), spectrum.data(), pool);
+            for (int a = 0; a < ni; a++) {
+                for (int b = 0; b < n; b++) {
+                    for (int c = 0; c < h; c++) {
+                        std::complex<double> expected = 0;
+                        for (int i = 0; i < ni; i++) {
+                            for (int j = 0; j < n; j++) {
+                                for (int k = 0; k < n; k++) {
+                                    const double phase = (double)a * i / ni + (double)b * j / n + (double)c * k / n;
+                                    expected += (double)field[((std::size_t)i * n + j) * n + k] * std::polar(1.0, -2 * PI * phase);
+                                }
+                            }
+                        }
+                        const Fft::Complex got = spectrum[((std::size_t)a * n + b) * h + c];
+                        ok = ok && std::abs(std::complex<double>(got) - expected) < 1e-3;
+                    }
+                }
+            }
+            std::vector<float> restored(field.size());
+            fft.inverse(spectrum.data(), restored.data(), pool);
+            for (std::size_t x = 0; x < field.size(); x++) ok = ok && std::abs(restored[x] - field[x]) < 1e-5f;
+        }
+    }
+    std::cout << "fft matches naive transform: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
+
+// Lenia の FFT による畳み込みが直接法と一致し, 自動の選択がどちらかに決まることを確認する
+// Check that Lenia's FFT convolution matches the direct method and that the automatic choice settles
+bool checkLeniaEngine() {
+    bool ok = true;
+    for (int dim: { 2, 3 }) {
+        for (int length: { 16, 18 }) {
+            LeniaParams params;
+            params.radius = dim == 3 ? 4 : 6;
+            params.peaks = { 0.5f, 1.0f };
+            LeniaEngine direct(dim, length, params);
+            LeniaEngine fourier(dim, length, params);
+            direct.setConvolutionMethod(ConvolutionMethod::Direct);
+            fourier.setConvolutionMethod(ConvolutionMethod::Fft);
+            fourier.setThreadCount(2);
+            direct.randomize(length / 2, dim + length);
+            fourier.randomize(length / 2, dim + length);
+            direct.progressField(3);
+            fourier.progressField(3);
+            const int ni = dim == 3 ? length : 1;
+            float difference = 0;
+            for (int i = 0; i < ni; i++) {
+                for (int j = 0; j < length; j++) {
+                    for (int k = 0; k < length; k++) {
+                        difference = std::max(difference, std::abs(direct.get(i, j, k) - fourier.get(i, j, k)));
+                    }
+                }
+            }
+            ok = ok && difference < 1e-3f && direct.getMass() > 0 && fourier.getGeneration() == 3;
+
+            LeniaEngine automatic(dim, length, params);
+            automatic.randomize(length / 2, 1);
+            automatic.progressField();
+            ok = ok && automatic.getConvolutionMethod() != ConvolutionMethod::Auto;
+        }
+    }
+    std::cout << "lenia fft matches direct convolution: " << (ok ? "yes" : "no") << '\n';
+    return ok;
+}
 
 void print(const std::vector<std::vector<std::vector<bool>>>& v) {
     for(const auto ev: v) {
@@ -33,4 +1333,4 @@ void print(const std::vector<std::vector<std::vector<bool>>>& v) {
         }
         std::cout << "=================================\n";
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,90 @@
+#include "CellTable.h"
+#include <algorithm>
+#include <utility>
+
+const uint64_t CellTable::EMPTY;
+
+CellTable::CellTable() {
+    this->keys.assign(16, EMPTY);
+    this->values.assign(16, 0);
+    this->mask = 15;
+    this->count = 0;
+}
+
+void CellTable::clear() {
+    // 直前の要素数に比べて大きすぎる表は作り直し, 空にする手間と走査の手間を要素数に見合わせる
+    // Rebuild a table far larger than its last entry count, so clearing and scanning it cost in
+    // proportion to the entries rather than to the peak
+    std::size_t fit = 16;
+    while (fit < 4 * this->count) fit *= 2;
+    if (this->keys.size() > 4 * fit) {
+        this->keys.assign(fit, EMPTY);
+        this->values.assign(fit, 0);
+        this->mask = fit - 1;
+    } else {
+        std::fill(this->keys.begin(), this->keys.end(), EMPTY);
+    }
+    this->count = 0;
+}
+
+void CellTable::reserve(std::size_t n) {
+    // 埋まりを半分以下に保つ
+    // Keep the table at most half full
+    std::size_t slots = this->keys.size();
+    while (slots < 2 * n) slots *= 2;
+    if (slots == this->keys.size()) return;
+
+    std::vector<uint64_t> old_keys(slots, EMPTY);
+    std::vector<uint8_t> old_values(slots, 0);
+    std::swap(old_keys, this->keys);
+    std::swap(old_values, this->values);
+    this->mask = slots - 1;
+    this->count = 0;
+    for (std::size_t s = 0; s < old_keys.size(); s++) {
+        if (old_keys[s] != EMPTY) (*this)[old_keys[s]] = old_values[s];
+    }
+}
+
+void CellTable::grow() {
+    this->reserve(this->keys.size());
+}
+
+bool CellTable::contains(uint64_t key) const {
+    for (std::size_t s = hash(key) & this->mask;; s = (s + 1) & this->mask) {
+        if (this->keys[s] == key) return true;
+        if (this->keys[s] == EMPTY) return false;
+    }
+}
+
+uint8_t& CellTable::operator[](uint64_t key) {
+    if (2 * (this->count + 1) > this->keys.size()) this->grow();
+    std::size_t s = hash(key) & this->mask;
+    for (; this->keys[s] != EMPTY; s = (s + 1) & this->mask) {
+        if (this->keys[s] == key) return this->values[s];
+    }
+    this->keys[s] = key;
+    this->values[s] = 0;
+    this->count++;
+    return this->values[s];
+}
+
+void CellTable::erase(uint64_t key) {
+    std::size_t s = hash(key) & this->mask;
+    for (; this->keys[s] != key; s = (s + 1) & this->mask) {
+        if (this->keys[s] == EMPTY) return;
+    }
+    // 空いた穴より前に本来の位置がある要素を穴へ詰め直す
+    // Move back every later entry whose home slot lies at or before the hole
+    std::size_t hole = s;
+    for (std::size_t t = (s + 1) & this->mask; this->keys[t] != EMPTY; t = (t + 1) & this->mask) {
+        const std::size_t home = hash(this->keys[t]) & this->mask;
+        const bool movable = hole <= t ? (home <= hole || home > t) : (home <= hole && home > t);
+        if (movable) {
+            this->keys[hole] = this->keys[t];
+            this->values[hole] = this->values[t];
+            hole = t;
+        }
+    }
+    this->keys[hole] = EMPTY;
+    this->count--;
+}
@@ -0,0 +1,60 @@
+#ifndef CELL_TABLE_H_
+#define CELL_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 64ビットに詰めたセル座標をキーにした開番地法のハッシュ表. 値は1バイト.
+// 線形探索で, 削除は後ろの要素を詰め直すので墓標を残さない
+// Open-addressing hash table keyed by cell coordinates packed into 64 bits, with one-byte values.
+// Uses linear probing; erase shifts later entries back, so no tombstones are left
+class CellTable
+{
+private:
+    static const uint64_t EMPTY = ~uint64_t(0);
+
+    std::vector<uint64_t> keys;
+    std::vector<uint8_t> values;
+    std::size_t mask;
+    std::size_t count;
+
+    static std::size_t hash(uint64_t key) {
+        // splitmix64 の仕上げ
+        // splitmix64 finalizer
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return (std::size_t)key;
+    }
+    void grow();
+
+public:
+    CellTable();
+
+    std::size_t size() const { return this->count; }
+    std::size_t capacity() const { return this->keys.size(); }
+    // 空にする. 容量は直前の要素数の数倍までに縮めるので, 一度大きくなった表も小さな集団では小さく保たれる
+    // Empties the table. Capacity shrinks to a few times the previous entry count, so a table that once
+    // grew stays small once the population does
+    void clear();
+    // n 個入れても再配置しない容量を確保する
+    // Reserves room for n entries without rehashing
+    void reserve(std::size_t n);
+
+    bool contains(uint64_t key) const;
+    // key の値への参照. 無ければ値0で追加する
+    // Reference to the value of key, inserted with value 0 when missing
+    uint8_t& operator[](uint64_t key);
+    void erase(uint64_t key);
+
+    // 空きを含むスロット単位の走査. keyAt(s) == emptyKey() なら空き
+    // Slot-wise iteration including empty slots. keyAt(s) == emptyKey() marks an empty one
+    static uint64_t emptyKey() { return EMPTY; }
+    uint64_t keyAt(std::size_t slot) const { return this->keys[slot]; }
+    uint8_t valueAt(std::size_t slot) const { return this->values[slot]; }
+};
+
+#endif // CELL_TABLE_H_
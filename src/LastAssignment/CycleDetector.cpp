@@ -0,0 +1,81 @@
+#include "CycleDetector.h"
+#include <algorithm>
+
+const uint32_t CycleDetector::EMPTY;
+
+CycleDetector::CycleDetector(std::size_t capacity) {
+    this->setCapacity(capacity);
+}
+
+void CycleDetector::setCapacity(std::size_t capacity) {
+    this->capacity = std::max<std::size_t>(1, capacity);
+    this->history.assign(this->capacity, {});
+    // 埋まるのは半分まで
+    // Kept at most half full
+    std::size_t size = 2;
+    while (size < 2 * this->capacity) size *= 2;
+    this->slots.assign(size, EMPTY);
+    this->mask = size - 1;
+    this->reset();
+}
+
+void CycleDetector::reset() {
+    std::fill(this->slots.begin(), this->slots.end(), EMPTY);
+    this->head = 0;
+    this->count = 0;
+    this->cycle = CycleInfo();
+}
+
+std::size_t CycleDetector::find(const FieldHash& hash) const {
+    std::size_t s = hash.low & this->mask;
+    while (this->slots[s] != EMPTY && this->history[this->slots[s]].first != hash) s = (s + 1) & this->mask;
+    return s;
+}
+
+void CycleDetector::erase(std::size_t slot) {
+    // 空いた穴より前に本来の位置がある要素を穴へ詰め直す
+    // Move back every later entry whose home slot lies at or before the hole
+    std::size_t hole = slot;
+    for (std::size_t t = (slot + 1) & this->mask; this->slots[t] != EMPTY; t = (t + 1) & this->mask) {
+        const std::size_t home = this->history[this->slots[t]].first.low & this->mask;
+        const bool movable = hole <= t ? (home <= hole || home > t) : (home <= hole && home > t);
+        if (movable) {
+            this->slots[hole] = this->slots[t];
+            hole = t;
+        }
+    }
+    this->slots[hole] = EMPTY;
+}
+
+bool CycleDetector::observe(long long generation, const FieldHash& hash) {
+    if (this->cycle.found) return false;
+    if (this->count > 0) {
+        const std::size_t newest = (this->head + this->count - 1) % this->capacity;
+        if (this->history[newest].second >= generation) return false;
+    }
+
+    const std::size_t slot = this->find(hash);
+    if (this->slots[slot] != EMPTY) {
+        this->cycle.found = true;
+        this->cycle.start = this->history[this->slots[slot]].second;
+        this->cycle.period = generation - this->cycle.start;
+        return true;
+    }
+
+    // 満杯なら最も古い記録を捨てて, その位置に書く
+    // When full, drop the oldest record and write over its place
+    std::size_t position;
+    if (this->count == this->capacity) {
+        position = this->head;
+        this->erase(this->find(this->history[position].first));
+        this->head = (this->head + 1) % this->capacity;
+    } else {
+        position = (this->head + this->count) % this->capacity;
+        this->count++;
+    }
+    this->history[position] = { hash, generation };
+    // 古い記録を詰め直すと空きの位置が変わりうるので引き直す
+    // Erasing the old record can move the free slot, so look it up again
+    this->slots[this->find(hash)] = (uint32_t)position;
+    return false;
+}
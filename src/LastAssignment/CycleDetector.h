@@ -0,0 +1,108 @@
+#ifndef CYCLE_DETECTOR_H_
+#define CYCLE_DETECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 場の128ビットのハッシュ. 64セルのワードごとに (位置, 値) から引いた乱数の排他的論理和なので
+// (ワード単位の Zobrist ハッシュ), 変わったワードの古い値と新しい値の分を足し込めば更新できる
+// 128-bit hash of a field: the XOR of a pseudo-random value drawn from (position, value) for each
+// 64-cell word (word-level Zobrist hashing), so it is updated by XORing in the old and new values of
+// the words that changed
+struct FieldHash
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    FieldHash& operator^=(const FieldHash& other) {
+        this->low ^= other.low;
+        this->high ^= other.high;
+        return *this;
+    }
+    bool operator==(const FieldHash& other) const { return this->low == other.low && this->high == other.high; }
+    bool operator!=(const FieldHash& other) const { return !(*this == other); }
+
+    // splitmix64 の仕上げ
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // 位置 index のワードの値 word の寄与. 空のワードは0なので, 空の場のハッシュは0
+    // Contribution of value word at word position index. Empty words give 0, so an empty field hashes to 0
+    static FieldHash ofWord(std::size_t index, uint64_t word) {
+        FieldHash h;
+        if (word == 0) return h;
+        const uint64_t key = mix((uint64_t)index * 0x9e3779b97f4a7c15ULL + 0x632be59bd9b4e019ULL);
+        h.low = mix(word ^ key);
+        h.high = mix((word + 0xd1b54a32d192ed03ULL) ^ mix(key));
+        return h;
+    }
+};
+
+// 見つかった周期. start 世代の場が start + period 世代に再び現れた
+// A cycle that was found: the field of generation start appeared again at start + period
+struct CycleInfo
+{
+    bool found = false;
+    long long start = 0;
+    long long period = 0;
+};
+
+// 周期が見つかった後の動作. Continue は報告するだけ, Stop は世代を進めなくなり,
+// FastForward は周期の倍数の世代を計算せずに飛ばす
+// What happens once a cycle is found. Continue only reports it, Stop no longer advances any
+// generation, and FastForward skips whole periods without computing them
+enum class CycleAction { Continue, Stop, FastForward };
+
+// 直近 capacity 世代のハッシュを覚え, 同じハッシュの再来を1世代あたり O(1) で見つける.
+// 128ビットなので, 履歴の中での偶然の一致は無視できる. 記録は確保済みの領域だけを使う
+// Remembers the hashes of the last capacity generations and finds a repeated hash in O(1) per
+// generation. With 128 bits an accidental match within the history is negligible. Recording only
+// uses storage allocated up front
+class CycleDetector
+{
+private:
+    static const uint32_t EMPTY = ~uint32_t(0);
+
+    std::size_t capacity;
+    // 古い順のハッシュと世代番号の環状バッファ. head が最も古い
+    // Ring buffer of hashes and generations, oldest first starting at head
+    std::vector<std::pair<FieldHash, long long>> history;
+    std::size_t head;
+    std::size_t count;
+    // history の位置を引く開番地法の表. 周期が見つかれば記録をやめるので, 同じハッシュは1つしか入らない
+    // Open-addressing index into history. Recording stops once a cycle is found, so each hash is in it once
+    std::vector<uint32_t> slots;
+    std::size_t mask;
+    CycleInfo cycle;
+
+    std::size_t find(const FieldHash& hash) const;
+    void erase(std::size_t slot);
+
+public:
+    explicit CycleDetector(std::size_t capacity = 1024);
+
+    // 見つけられる最長の周期. 変えると履歴を消す
+    // Longest period that can be found. Changing it clears the history
+    std::size_t getCapacity() const { return this->capacity; }
+    void setCapacity(std::size_t capacity);
+    // 場を外から書き換えたときなどに履歴と見つかった周期を消す
+    // Forgets the history and any cycle found, e.g. after the field was edited from outside
+    void reset();
+
+    // generation 世代の場のハッシュを記録し, 周期が初めて見つかったら true. 世代は増える順に渡すこと
+    // Records the hash of the field at generation, returning true when a cycle is first found.
+    // Generations must be passed in increasing order
+    bool observe(long long generation, const FieldHash& hash);
+    const CycleInfo& getCycle() const { return this->cycle; }
+};
+
+#endif // CYCLE_DETECTOR_H_
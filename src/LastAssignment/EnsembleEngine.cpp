@@ -0,0 +1,185 @@
+#include "EnsembleEngine.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+EnsembleEngine::EnsembleEngine(int dim, int length, int worlds, const Rule& rule,
+    bool isNeumannNeighborhood, bool isTorus) {
+    if (worlds <= 0 || worlds % 64 != 0) {
+        throw std::invalid_argument("world count must be a positive multiple of 64: " + std::to_string(worlds));
+    }
+    this->dim = dim;
+    this->length = length;
+    this->worlds = worlds;
+    this->cell_words = worlds / 64;
+    this->rule = rule;
+    this->neighborhood = isNeumannNeighborhood ? Neighborhood::Neumann : Neighborhood::Moore;
+    this->isTorus = isTorus;
+    this->generation = 0;
+
+    // カーネルは内部セルの後ろの余りまで書くので, 東の隣を読んでも行からはみ出さない幅を取る
+    // The kernel also writes the padding after the interior cells, so leave room to read its east neighbors
+    auto roundUp = [](int x) { return (x + ROW_ALIGN_WORDS - 1) / ROW_ALIGN_WORDS * ROW_ALIGN_WORDS; };
+    this->step_words = roundUp(length * this->cell_words);
+    this->row_words = roundUp(this->step_words + 2 * this->cell_words);
+    this->plane_words = (std::size_t)(length + 2) * this->row_words;
+    this->cells.assign(this->plane_words * (dim == 3 ? length + 2 : 1), 0);
+    this->next_cells = this->cells;
+
+    this->setKernelIsa(detectKernelIsa());
+    this->setThreadCount(0);
+}
+
+void EnsembleEngine::setKernelIsa(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        throw std::invalid_argument(std::string("kernel not supported on this CPU: ") + kernelIsaName(isa));
+    }
+    this->kernel_isa = isa;
+    this->step_tile = selectEnsembleTile(isa, this->dim, this->neighborhood);
+}
+
+void EnsembleEngine::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+}
+
+void EnsembleEngine::fillHalo() {
+    const int n = this->length;
+    const int cw = this->cell_words;
+    const int ni = this->dim == 3 ? n : 1;
+    uint64_t* base = this->cells.data();
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < n; j++) {
+            uint64_t* row = base + this->rowOffset(i, j);
+            if (this->isTorus) {
+                std::copy(row + n * cw, row + (n + 1) * cw, row);
+                std::copy(row + cw, row + 2 * cw, row + (n + 1) * cw);
+            } else {
+                std::fill(row + (n + 1) * cw, row + (n + 2) * cw, 0);
+            }
+        }
+    }
+    // 有界な場の袖の行と平面はカーネルが書かないので0のまま
+    // The kernel never writes the ghost rows and planes, so they stay 0 on a bounded field
+    if (!this->isTorus) return;
+    for (int i = 0; i < ni; i++) {
+        std::copy(base + this->rowOffset(i, n - 1), base + this->rowOffset(i, n), base + this->rowOffset(i, -1));
+        std::copy(base + this->rowOffset(i, 0), base + this->rowOffset(i, 1), base + this->rowOffset(i, n));
+    }
+    if (this->dim == 3) {
+        std::copy(base + this->rowOffset(n - 1, -1), base + this->rowOffset(n, -1), base + this->rowOffset(-1, -1));
+        std::copy(base + this->rowOffset(0, -1), base + this->rowOffset(1, -1), base + this->rowOffset(n, -1));
+    }
+}
+
+void EnsembleEngine::progressField() {
+    this->fillHalo();
+    const int ni = this->dim == 3 ? this->length : 1;
+    const int bands = (this->length + TASK_ROWS - 1) / TASK_ROWS;
+    auto task = [this, bands](int t, int) {
+        EnsembleTile tile;
+        tile.src = this->cells.data() + this->rowOffset(0, 0);
+        tile.dst = this->next_cells.data() + this->rowOffset(0, 0);
+        tile.row_stride = this->row_words;
+        tile.plane_stride = this->plane_words;
+        tile.cell_words = this->cell_words;
+        tile.i_begin = t / bands;
+        tile.i_end = tile.i_begin + 1;
+        tile.j_begin = t % bands * TASK_ROWS;
+        tile.j_end = std::min(this->length, tile.j_begin + TASK_ROWS);
+        tile.word_begin = this->cell_words;
+        tile.word_end = this->cell_words + this->step_words;
+        tile.birth_mask = this->rule.birthMask();
+        tile.survival_mask = this->rule.survivalMask();
+        this->step_tile(tile);
+    };
+    this->pool->parallelFor(ni * bands, task);
+    std::swap(this->cells, this->next_cells);
+    this->generation++;
+}
+
+void EnsembleEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void EnsembleEngine::randomize(const std::vector<float>& ratios, uint64_t seed) {
+    if (ratios.size() != 1 && ratios.size() != (std::size_t)this->worlds) {
+        throw std::invalid_argument("expected 1 or " + std::to_string(this->worlds) + " ratios: "
+            + std::to_string(ratios.size()));
+    }
+    // 32ビットの乱数と比べるしきい値
+    // Thresholds compared against 32-bit random numbers
+    std::vector<uint64_t> thresholds(this->worlds);
+    for (int w = 0; w < this->worlds; w++) {
+        const float ratio = std::min(1.0f, std::max(0.0f, ratios[ratios.size() == 1 ? 0 : w]));
+        thresholds[w] = (uint64_t)((double)ratio * 4294967296.0);
+    }
+    std::mt19937 eng((std::mt19937::result_type)seed);
+    const int ni = this->dim == 3 ? this->length : 1;
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < this->length; j++) {
+            for (int k = 0; k < this->length; k++) {
+                uint64_t* words = this->cellWords(i, j, k);
+                for (int l = 0; l < this->cell_words; l++) {
+                    uint64_t word = 0;
+                    for (int b = 0; b < 64; b++) {
+                        if (eng() < thresholds[l * 64 + b]) word |= uint64_t(1) << b;
+                    }
+                    words[l] = word;
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint64_t> EnsembleEngine::getPopulations() const {
+    // 8桁の計数器は255ワードまで溢れない
+    // Eight-digit counters hold up to 255 words without overflowing
+    static const int DIGITS = 8;
+    const int cw = this->cell_words;
+    const int ni = this->dim == 3 ? this->length : 1;
+    std::vector<std::vector<uint64_t>> partial(this->pool->threadCount(), std::vector<uint64_t>(this->worlds, 0));
+    auto task = [this, cw, &partial](int i, int worker) {
+        uint64_t* counts = partial[worker].data();
+        // 世界64個分のワード位置ごとに, 計数器をレジスタに置いて平面を流す
+        // For each word position (64 worlds), stream the plane with the counters kept in registers
+        for (int l = 0; l < cw; l++) {
+            uint64_t digits[DIGITS] = {};
+            auto drain = [&]() {
+                for (int d = 0; d < DIGITS; d++) {
+                    for (uint64_t x = digits[d]; x != 0; x &= x - 1) counts[l * 64 + __builtin_ctzll(x)] += uint64_t(1) << d;
+                    digits[d] = 0;
+                }
+            };
+            int pending = 0;
+            for (int j = 0; j < this->length; j++) {
+                const uint64_t* words = this->cellWords(i, j, 0) + l;
+                for (int k = 0; k < this->length; k++) {
+                    uint64_t x = words[(std::size_t)k * cw];
+                    #pragma GCC unroll 8
+                    for (int d = 0; d < DIGITS; d++) {
+                        const uint64_t carry = digits[d] & x;
+                        digits[d] ^= x;
+                        x = carry;
+                    }
+                    if (++pending == (1 << DIGITS) - 1) {
+                        drain();
+                        pending = 0;
+                    }
+                }
+            }
+            drain();
+        }
+    };
+    this->pool->parallelFor(ni, task);
+
+    std::vector<uint64_t> populations(this->worlds, 0);
+    for (const std::vector<uint64_t>& counts: partial) {
+        for (int w = 0; w < this->worlds; w++) populations[w] += counts[w];
+    }
+    return populations;
+}
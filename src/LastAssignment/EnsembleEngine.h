@@ -0,0 +1,100 @@
+#ifndef ENSEMBLE_ENGINE_H_
+#define ENSEMBLE_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BitField.h"
+#include "KernelDispatch.h"
+#include "Rule.h"
+#include "ThreadPool.h"
+
+// 同じ規則と大きさの世界を64個ずつまとめて進めるエンジン. セル (i, j, k) は worlds / 64 ワードを持ち,
+// ワードのビット b が世界 b のそのセル. 1ワードの論理演算で64個の世界を同時に進めるので,
+// 種や初期密度を変えた小さな世界を数多く回す統計のための実験に向く
+// Engine advancing worlds of the same rule and size 64 at a time. Cell (i, j, k) holds worlds / 64
+// words, and bit b of a word is that cell in world b. One word-wide logic operation advances 64 worlds
+// at once, which suits statistical experiments running many small worlds with varied seeds or densities
+class EnsembleEngine
+{
+private:
+    // 行は内部のワード数をこの倍数に切り上げる (AVX-512 の幅)
+    // Interior words of a row are rounded up to a multiple of this (the AVX-512 width)
+    static const int ROW_ALIGN_WORDS = 8;
+    // j方向にこの行数ずつ区切ってタスクにする
+    // j is cut into tasks of this many rows
+    static const int TASK_ROWS = 8;
+
+    int dim;
+    int length;
+    int worlds;
+    int cell_words;
+    Rule rule;
+    Neighborhood neighborhood;
+    bool isTorus;
+    long long generation;
+    // 行は [西の袖セル][内部セル][東の袖セル][余り] で, 平面は上下に袖の行を, 3次元の場は前後に袖の平面を持つ
+    // A row is [west ghost cell][interior cells][east ghost cell][padding]; planes carry a ghost row above
+    // and below, and 3D fields a ghost plane in front and behind
+    int row_words;
+    int step_words;
+    std::size_t plane_words;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> cells;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> next_cells;
+    KernelIsa kernel_isa;
+    EnsembleTileFn step_tile;
+    std::unique_ptr<ThreadPool> pool;
+
+    std::size_t rowOffset(int i, int j) const {
+        return (std::size_t)(i + (this->dim == 3 ? 1 : 0)) * this->plane_words + (std::size_t)(j + 1) * this->row_words;
+    }
+    uint64_t* cellWords(int i, int j, int k) {
+        return this->cells.data() + this->rowOffset(i, j) + (std::size_t)(k + 1) * this->cell_words;
+    }
+    const uint64_t* cellWords(int i, int j, int k) const {
+        return this->cells.data() + this->rowOffset(i, j) + (std::size_t)(k + 1) * this->cell_words;
+    }
+    // 袖をトーラスなら反対側の写しで埋め, 有界ならカーネルが書いた東の袖セルを0に戻す
+    // Fills the ghosts with wrapped copies on a torus; when bounded, zeroes the east ghost cell the kernel wrote
+    void fillHalo();
+
+public:
+    // dim は 2 (i = 0 の平面) か 3. worlds は64の正の倍数でなければ std::invalid_argument
+    // dim is 2 (the i = 0 plane) or 3. Throws std::invalid_argument unless worlds is a positive multiple of 64
+    EnsembleEngine(int dim, int length, int worlds, const Rule& rule, bool isNeumannNeighborhood, bool isTorus);
+
+    void progressField();
+    void progressField(int generations);
+
+    bool get(int world, int i, int j, int k) const {
+        return (this->cellWords(i, j, k)[world / 64] >> (world % 64)) & 1;
+    }
+    void set(int world, int i, int j, int k, bool alive) {
+        uint64_t& w = this->cellWords(i, j, k)[world / 64];
+        const uint64_t bit = uint64_t(1) << (world % 64);
+        if (alive) w |= bit;
+        else w &= ~bit;
+    }
+    // 世界 w を密度 ratios[w] で乱数から埋める. ratios が1つならすべての世界に使う
+    // Fills world w at random with density ratios[w]. A single ratio applies to every world
+    void randomize(const std::vector<float>& ratios, uint64_t seed);
+    // 世界ごとの個体数. ビット位置ごとの数をビットスライスの計数器に溜めてからまとめて取り出す
+    // Population of every world. Counts per bit position gather in bit-sliced counters and are drained in bulk
+    std::vector<uint64_t> getPopulations() const;
+
+    int getWorldCount() const { return this->worlds; }
+    int getLength() const { return this->length; }
+    long long getGeneration() const { return this->generation; }
+    const Rule& getRule() const { return this->rule; }
+
+    KernelIsa getKernelIsa() const { return this->kernel_isa; }
+    // CPUが対応しない命令セットを指定すると std::invalid_argument
+    // Throws std::invalid_argument if the CPU does not support the instruction set
+    void setKernelIsa(KernelIsa isa);
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count);
+};
+
+#endif // ENSEMBLE_ENGINE_H_
@@ -0,0 +1,202 @@
+#include "EventEngine.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+template <int Dim, Neighborhood N, Boundary B>
+int EventEngine<Dim, N, B>::checkLength(int length) {
+    const uint64_t cells = (uint64_t)length * length * (Dim == 3 ? length : 1);
+    if (length < 1 || cells > UINT32_MAX) {
+        throw std::invalid_argument("event-driven engine length out of range: " + std::to_string(length));
+    }
+    return length;
+}
+
+// 場を確保する前に大きさを確かめる
+// The size is checked before the field is allocated
+template <int Dim, Neighborhood N, Boundary B>
+EventEngine<Dim, N, B>::EventEngine(const Rule& rule, int length, int thread_count)
+    : CAEngineBase(rule, Dim == 2 ? BitField(checkLength(length), length) : BitField(checkLength(length), length, length),
+        Dim, N, thread_count, false) {
+    this->length = length;
+    this->evaluated = 0;
+    this->born = 0;
+    this->histogram.fill(0);
+
+    for (int di = (Dim == 3 ? -1 : 0); di <= (Dim == 3 ? 1 : 0); di++) {
+        for (int dj = -1; dj <= 1; dj++) {
+            for (int dk = -1; dk <= 1; dk++) {
+                const int distance = (di != 0) + (dj != 0) + (dk != 0);
+                if (distance == 0 || (N == Neighborhood::Neumann && distance > 1)) continue;
+                this->offsets.insert(this->offsets.end(), { di, dj, dk });
+            }
+        }
+    }
+
+    this->wrap.resize(length + 2);
+    for (int x = -1; x <= length; x++) {
+        if (B == Boundary::Torus) this->wrap[x + 1] = (x + length) % length;
+        else this->wrap[x + 1] = x >= 0 && x < length ? x : -1;
+    }
+
+    const std::size_t cells = (std::size_t)length * length * (Dim == 3 ? length : 1);
+    this->counts.assign(cells, 0);
+    this->queued.assign((cells + 63) / 64, 0);
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+template <typename F>
+void EventEngine<Dim, N, B>::forEachNeighbor(uint32_t cell, F f) const {
+    const uint32_t n = this->length;
+    const int i = (int)(cell / (n * n));
+    const int j = (int)(cell / n % n);
+    const int k = (int)(cell % n);
+    // 小さなトーラスでは同じセルが複数のずれに現れるが, 袖を写すビット版と同じく重ねて数える
+    // On a small torus one cell can sit at several offsets; it is counted each time, as the bitwise engine does
+    for (std::size_t o = 0; o < this->offsets.size(); o += 3) {
+        const int ii = Dim == 3 ? this->wrap[i + this->offsets[o] + 1] : 0;
+        const int jj = this->wrap[j + this->offsets[o + 1] + 1];
+        const int kk = this->wrap[k + this->offsets[o + 2] + 1];
+        if (ii < 0 || jj < 0 || kk < 0) continue;
+        f(((uint32_t)ii * n + (uint32_t)jj) * n + (uint32_t)kk);
+    }
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void EventEngine<Dim, N, B>::enqueue(uint32_t cell) {
+    uint64_t& word = this->queued[cell / 64];
+    const uint64_t bit = uint64_t(1) << (cell % 64);
+    if (word & bit) return;
+    word |= bit;
+    this->next_candidates.push_back(cell);
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void EventEngine<Dim, N, B>::rebuild() {
+    const uint32_t n = this->length;
+    const uint32_t cells = (uint32_t)this->counts.size();
+    std::fill(this->counts.begin(), this->counts.end(), 0);
+    std::fill(this->queued.begin(), this->queued.end(), 0);
+    this->next_candidates.clear();
+
+    for (uint32_t cell = 0; cell < cells; cell++) {
+        if (!this->field.get(cell / (n * n), cell / n % n, cell % n)) continue;
+        this->forEachNeighbor(cell, [this](uint32_t neighbor) { this->counts[neighbor]++; });
+    }
+    // 0近傍で誕生する規則では空のセルも変わりうるので, すべてのセルから始める
+    // With birth on zero neighbors even empty cells can change, so every cell starts queued
+    const bool birth_on_zero = this->rule.birthMask() & 1;
+    for (uint32_t cell = 0; cell < cells; cell++) {
+        if (birth_on_zero || this->counts[cell] > 0 || this->field.get(cell / (n * n), cell / n % n, cell % n)) {
+            this->enqueue(cell);
+        }
+    }
+    std::swap(this->candidates, this->next_candidates);
+    this->next_candidates.clear();
+    this->edited = false;
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void EventEngine<Dim, N, B>::progressField() {
+    if (this->applyCycleAction(1) == 0) return;
+    if (this->edited) this->rebuild();
+    const uint32_t n = this->length;
+
+    // 評価待ちでないセルは状態も近傍数も前の世代と同じで, 前の世代に変化しなかったので今回も変化しない.
+    // すべて評価してから反映するので, 評価は古い状態と近傍数だけを見る
+    // A cell that is not queued has the same state and count as last generation, when it did not
+    // change, so it cannot change now. Every cell is evaluated before any flip is applied
+    this->flipped.clear();
+    for (uint32_t cell: this->candidates) {
+        this->queued[cell / 64] &= ~(uint64_t(1) << (cell % 64));
+        const bool alive = this->field.get(cell / (n * n), cell / n % n, cell % n);
+        if (this->rule.isNextAlive(alive, this->counts[cell]) != alive) this->flipped.push_back(cell);
+    }
+    this->evaluated = this->candidates.size();
+    // 分布は場全体を見るので, この方式の利点を消す. 有効にしたときだけ数える
+    // The histogram looks at the whole field, which defeats this engine's purpose; count it only when enabled
+    if (this->stats_enabled && this->histogram_enabled) {
+        this->histogram.fill(0);
+        for (uint8_t count: this->counts) this->histogram[count]++;
+    }
+
+    // ハッシュは反転するセルを含むワードの新旧の値から更新する. 並べ替えると同じワードのセルが続く
+    // The hash is updated from the old and new values of the words holding flipped cells. Once sorted,
+    // cells of the same word are adjacent
+    const bool rehash = this->cycle_detection && this->hash_generation == this->generation;
+    if (rehash) this->hashFlips();
+
+    this->next_candidates.clear();
+    this->born = 0;
+    for (uint32_t cell: this->flipped) {
+        const int i = cell / (n * n);
+        const int j = cell / n % n;
+        const int k = cell % n;
+        const bool alive = !this->field.get(i, j, k);
+        this->field.set(i, j, k, alive);
+        this->born += alive;
+        this->enqueue(cell);
+        this->forEachNeighbor(cell, [this, alive](uint32_t neighbor) {
+            this->counts[neighbor] += alive ? 1 : -1;
+            this->enqueue(neighbor);
+        });
+    }
+    std::swap(this->candidates, this->next_candidates);
+    this->generation++;
+    this->stats_generation = this->stats_enabled ? this->generation : -1;
+    if (rehash) this->hash_generation = this->generation;
+    this->observeHash();
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void EventEngine<Dim, N, B>::hashFlips() {
+    std::sort(this->flipped.begin(), this->flipped.end());
+    const uint32_t n = this->length;
+    const int rw = this->field.rowWords();
+    std::size_t f = 0;
+    while (f < this->flipped.size()) {
+        const uint32_t row = this->flipped[f] / n;
+        const int w = (this->flipped[f] % n + BitField::HALO) / BitField::WORD_BITS;
+        uint64_t flips = 0;
+        for (; f < this->flipped.size() && this->flipped[f] / n == row; f++) {
+            const int k = this->flipped[f] % n + BitField::HALO;
+            if (k / BitField::WORD_BITS != w) break;
+            flips |= uint64_t(1) << (k % BitField::WORD_BITS);
+        }
+        // 袖のビットはトーラスの写しなので数えない. 内部のビットだけを取る
+        // Ghost bits mirror the torus and are not hashed; take interior bits only
+        const uint64_t was = this->field.row(row / n, row % n)[w] & this->interior_mask[w];
+        const std::size_t index = (std::size_t)row * rw + w;
+        this->field_hash ^= FieldHash::ofWord(index, was);
+        this->field_hash ^= FieldHash::ofWord(index, was ^ flips);
+    }
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+void EventEngine<Dim, N, B>::progressField(int generations) {
+    this->progressStepwise(generations);
+}
+
+template <int Dim, Neighborhood N, Boundary B>
+GenerationStats EventEngine<Dim, N, B>::getGenerationStats() const {
+    GenerationStats stats = this->scanField();
+    if (!this->stats_enabled || this->stats_generation != this->generation) return stats;
+    stats.has_changes = true;
+    stats.births = this->born;
+    stats.deaths = this->flipped.size() - this->born;
+    if (this->histogram_enabled) {
+        stats.has_histogram = true;
+        stats.histogram = this->histogram;
+    }
+    return stats;
+}
+
+template class EventEngine<2, Neighborhood::Moore, Boundary::Torus>;
+template class EventEngine<2, Neighborhood::Moore, Boundary::Bounded>;
+template class EventEngine<2, Neighborhood::Neumann, Boundary::Torus>;
+template class EventEngine<2, Neighborhood::Neumann, Boundary::Bounded>;
+template class EventEngine<3, Neighborhood::Moore, Boundary::Torus>;
+template class EventEngine<3, Neighborhood::Moore, Boundary::Bounded>;
+template class EventEngine<3, Neighborhood::Neumann, Boundary::Torus>;
+template class EventEngine<3, Neighborhood::Neumann, Boundary::Bounded>;
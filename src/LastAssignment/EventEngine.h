@@ -0,0 +1,69 @@
+#ifndef EVENT_ENGINE_H_
+#define EVENT_ENGINE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CAEngine.h"
+
+// 近傍数の場と評価待ちのセルの列を持ち, 変化したセルの周りだけを評価するエンジン.
+// 1世代の手間は場の大きさではなく変化したセルの数に比例する. 1スレッドで進め, カーネルを使わないので
+// setThreadCount, setKernelIsa, setBrickSkipping と setTileSchedule は値を覚えるだけで効果は無い
+// (setEngineKind で別のエンジンへ引き継ぐため)
+// Engine that keeps a neighbor-count field and a queue of cells to evaluate, looking only around
+// cells that changed. The work per generation scales with the number of changes, not the field size.
+// It runs on one thread without the kernels, so setThreadCount, setKernelIsa, setBrickSkipping and
+// setTileSchedule only record their values (for setEngineKind to hand over) and have no effect
+template <int Dim, Neighborhood N, Boundary B>
+class EventEngine : public CAEngineBase
+{
+private:
+    int length;
+    // 近傍へのずれ (di, dj, dk) を3つずつ並べたもの. Moore は26 (平面は8), von Neumann は6 (平面は4)
+    // Neighbor offsets (di, dj, dk) in triples. 26 for Moore (8 when planar), 6 for von Neumann (4 when planar)
+    std::vector<int> offsets;
+    // 座標 x (-1..length) を折り返した座標へ写す表で, 添字は x + 1. 有界な場の外は -1
+    // Maps a coordinate x (-1..length) to its wrapped coordinate, indexed by x + 1. -1 outside a bounded field
+    std::vector<int> wrap;
+    std::vector<uint8_t> counts;
+    // next_candidates に入っている印 (1セル1ビット)
+    // Membership bits of next_candidates, one bit per cell
+    std::vector<uint64_t> queued;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> next_candidates;
+    std::vector<uint32_t> flipped;
+    std::size_t evaluated;
+    // 直前の世代で生まれたセルの数. 死んだセルは flipped の残り
+    // Cells born in the last generation; the rest of flipped died
+    std::size_t born;
+    std::array<uint64_t, 27> histogram;
+
+    // セル番号は32ビットなので, セル数が収まらない length は std::invalid_argument
+    // Cell ids are 32-bit, so a length whose cell count does not fit throws std::invalid_argument
+    static int checkLength(int length);
+    void rebuild();
+    // flipped を並べ替え, 反転を反映する前の場から field_hash を次の世代の値へ更新する
+    // Sorts flipped and, before the flips are applied, updates field_hash to the next generation's value
+    void hashFlips();
+    void enqueue(uint32_t cell);
+    template <typename F>
+    void forEachNeighbor(uint32_t cell, F f) const;
+
+public:
+    EventEngine(const Rule& rule, int length, int thread_count);
+    void progressField() override;
+    void progressField(int generations) override;
+    // 誕生数と死亡数は変化したセルの列から, 近傍数の分布は更新前に保持している近傍数から得る.
+    // 個体数と範囲は場を数え直す
+    // Births and deaths come from the list of changed cells and the histogram from the neighbor
+    // counts kept before the update; population and bounding box are recounted from the field
+    GenerationStats getGenerationStats() const override;
+
+    // 直前の世代で評価したセルと, 状態が変わったセルの数
+    // Cells evaluated in the last generation, and cells whose state changed
+    std::size_t getEvaluatedCellCount() const { return this->evaluated; }
+    std::size_t getChangedCellCount() const { return this->flipped.size(); }
+};
+
+#endif // EVENT_ENGINE_H_
@@ -0,0 +1,204 @@
+#include "Fft.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using Complex = Fft::Complex;
+
+// std::complex の積は NaN の扱いのために遅い経路を持つので, そのまま掛ける
+// The std::complex product carries a slow path for NaN handling, so multiply directly
+inline Complex mul(Complex a, Complex b) {
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+const double PI = 3.14159265358979323846;
+
+}
+
+Fft::Fft(int n) {
+    if (n < 1) throw std::invalid_argument("FFT length must be positive: " + std::to_string(n));
+    this->n = n;
+    this->bluestein = (n & (n - 1)) != 0;
+    this->m = 1;
+    while (this->m < (this->bluestein ? 2 * n - 1 : n)) this->m <<= 1;
+
+    const int m = this->m;
+    this->twiddles.resize(m / 2);
+    for (int k = 0; k < m / 2; k++) {
+        this->twiddles[k] = Complex((float)std::cos(-2 * PI * k / m), (float)std::sin(-2 * PI * k / m));
+    }
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+    this->reversed.resize(m);
+    for (int k = 0; k < m; k++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++) r |= (uint32_t)((k >> b) & 1) << (bits - 1 - b);
+        this->reversed[k] = r;
+    }
+
+    if (this->bluestein) {
+        // k^2 は 2n で割った余りにしてから角度にし, 大きな k でも精度を落とさない
+        // Reduce k^2 modulo 2n before turning it into an angle, to keep precision for large k
+        this->chirp.resize(n);
+        for (int k = 0; k < n; k++) {
+            const long long q = (long long)k * k % (2LL * n);
+            this->chirp[k] = Complex((float)std::cos(-PI * q / n), (float)std::sin(-PI * q / n));
+        }
+        this->chirp_spectrum.assign(m, Complex(0, 0));
+        this->chirp_spectrum[0] = std::conj(this->chirp[0]);
+        for (int k = 1; k < n; k++) {
+            this->chirp_spectrum[k] = std::conj(this->chirp[k]);
+            this->chirp_spectrum[m - k] = std::conj(this->chirp[k]);
+        }
+        this->radix2(this->chirp_spectrum.data(), false);
+    }
+}
+
+void Fft::radix2(Complex* data, bool inverse) const {
+    const int m = this->m;
+    for (int k = 0; k < m; k++) {
+        const uint32_t r = this->reversed[k];
+        if ((uint32_t)k < r) std::swap(data[k], data[r]);
+    }
+    for (int len = 2; len <= m; len <<= 1) {
+        const int step = m / len;
+        const int half = len / 2;
+        for (int start = 0; start < m; start += len) {
+            for (int j = 0; j < half; j++) {
+                Complex w = this->twiddles[j * step];
+                if (inverse) w = std::conj(w);
+                const Complex u = data[start + j];
+                const Complex v = mul(data[start + j + half], w);
+                data[start + j] = u + v;
+                data[start + j + half] = u - v;
+            }
+        }
+    }
+}
+
+void Fft::transform(Complex* data, bool inverse, Complex* scratch) const {
+    if (!this->bluestein) {
+        this->radix2(data, inverse);
+        return;
+    }
+    // X[k] = chirp[k] * sum_j (x[j] chirp[j]) conj(chirp[k - j]) を長さ m の巡回畳み込みで求める.
+    // 逆変換は共役を取った順変換
+    // X[k] = chirp[k] * sum_j (x[j] chirp[j]) conj(chirp[k - j]), computed as a cyclic convolution of
+    // length m. The inverse is the forward transform of the conjugate
+    const int n = this->n;
+    const int m = this->m;
+    for (int j = 0; j < n; j++) {
+        scratch[j] = mul(inverse ? std::conj(data[j]) : data[j], this->chirp[j]);
+    }
+    for (int j = n; j < m; j++) scratch[j] = Complex(0, 0);
+    this->radix2(scratch, false);
+    for (int j = 0; j < m; j++) scratch[j] = mul(scratch[j], this->chirp_spectrum[j]);
+    this->radix2(scratch, true);
+    const float scale = 1.0f / m;
+    for (int k = 0; k < n; k++) {
+        const Complex x = mul(scratch[k], this->chirp[k]) * scale;
+        data[k] = inverse ? std::conj(x) : x;
+    }
+}
+
+RealFft3D::RealFft3D(int dim, int length) : line(length) {
+    this->dim = dim;
+    this->length = length;
+    this->half = length / 2 + 1;
+}
+
+std::size_t RealFft3D::spectrumSize() const {
+    return (std::size_t)(this->dim == 3 ? this->length : 1) * this->length * this->half;
+}
+
+void RealFft3D::reserveWorkers(int workers) {
+    this->buffers.assign(workers, std::vector<Complex>(this->length));
+    this->scratch.assign(workers, std::vector<Complex>(this->line.scratchSize()));
+}
+
+void RealFft3D::transformColumns(Complex* spectrum, bool inverse, ThreadPool& pool) {
+    const int n = this->length;
+    const int h = this->half;
+    const int ni = this->dim == 3 ? n : 1;
+    // j 方向, 続いて (3次元なら) i 方向に, 列を集めて変換し書き戻す
+    // Along j, then (in 3D) along i: gather each column, transform it and scatter it back
+    auto along_j = [this, spectrum, inverse, n, h](int t, int worker) {
+        Complex* buffer = this->buffers[worker].data();
+        Complex* column = spectrum + (std::size_t)(t / h) * n * h + t % h;
+        for (int j = 0; j < n; j++) buffer[j] = column[(std::size_t)j * h];
+        this->line.transform(buffer, inverse, this->scratch[worker].data());
+        for (int j = 0; j < n; j++) column[(std::size_t)j * h] = buffer[j];
+    };
+    pool.parallelFor(ni * h, along_j);
+    if (this->dim != 3) return;
+    auto along_i = [this, spectrum, inverse, n, h](int t, int worker) {
+        Complex* buffer = this->buffers[worker].data();
+        Complex* column = spectrum + t;
+        const std::size_t stride = (std::size_t)n * h;
+        for (int i = 0; i < n; i++) buffer[i] = column[i * stride];
+        this->line.transform(buffer, inverse, this->scratch[worker].data());
+        for (int i = 0; i < n; i++) column[i * stride] = buffer[i];
+    };
+    pool.parallelFor(n * h, along_i);
+}
+
+void RealFft3D::forward(const float* field, Complex* spectrum, ThreadPool& pool) {
+    const int n = this->length;
+    const int h = this->half;
+    const int rows = (this->dim == 3 ? n : 1) * n;
+    // 実数の2行を z = x + i y にまとめて変換し, X[k] = (Z[k] + conj Z[n - k]) / 2,
+    // Y[k] = (Z[k] - conj Z[n - k]) / 2i で分ける
+    // Two real rows go through one transform as z = x + i y, then split as X[k] = (Z[k] + conj Z[n - k]) / 2
+    // and Y[k] = (Z[k] - conj Z[n - k]) / 2i
+    auto along_k = [this, field, spectrum, n, h, rows](int t, int worker) {
+        Complex* buffer = this->buffers[worker].data();
+        const int r0 = 2 * t;
+        const bool paired = r0 + 1 < rows;
+        const float* x = field + (std::size_t)r0 * n;
+        const float* y = x + n;
+        for (int k = 0; k < n; k++) buffer[k] = Complex(x[k], paired ? y[k] : 0.0f);
+        this->line.transform(buffer, false, this->scratch[worker].data());
+        Complex* out0 = spectrum + (std::size_t)r0 * h;
+        Complex* out1 = out0 + h;
+        for (int k = 0; k < h; k++) {
+            const Complex z = buffer[k];
+            const Complex c = std::conj(buffer[(n - k) % n]);
+            out0[k] = (z + c) * 0.5f;
+            if (paired) out1[k] = mul(z - c, Complex(0, -0.5f));
+        }
+    };
+    pool.parallelFor((rows + 1) / 2, along_k);
+    this->transformColumns(spectrum, false, pool);
+}
+
+void RealFft3D::inverse(Complex* spectrum, float* field, ThreadPool& pool) {
+    const int n = this->length;
+    const int h = this->half;
+    const int rows = (this->dim == 3 ? n : 1) * n;
+    this->transformColumns(spectrum, true, pool);
+    // 負の周波数はエルミート対称から補い, 2行を z = x + i y として逆変換する
+    // Negative frequencies come from Hermitian symmetry; two rows are inverted together as z = x + i y
+    const float scale = 1.0f / ((float)rows * n);
+    auto along_k = [this, field, spectrum, n, h, rows, scale](int t, int worker) {
+        Complex* buffer = this->buffers[worker].data();
+        const int r0 = 2 * t;
+        const bool paired = r0 + 1 < rows;
+        const Complex* in0 = spectrum + (std::size_t)r0 * h;
+        const Complex* in1 = in0 + h;
+        for (int k = 0; k < n; k++) {
+            const Complex x = k < h ? in0[k] : std::conj(in0[n - k]);
+            const Complex y = !paired ? Complex(0, 0) : k < h ? in1[k] : std::conj(in1[n - k]);
+            buffer[k] = x + mul(y, Complex(0, 1));
+        }
+        this->line.transform(buffer, true, this->scratch[worker].data());
+        float* x = field + (std::size_t)r0 * n;
+        float* y = x + n;
+        for (int k = 0; k < n; k++) {
+            x[k] = buffer[k].real() * scale;
+            if (paired) y[k] = buffer[k].imag() * scale;
+        }
+    };
+    pool.parallelFor((rows + 1) / 2, along_k);
+}
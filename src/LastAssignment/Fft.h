@@ -0,0 +1,84 @@
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ThreadPool.h"
+
+// 長さ n の1次元複素FFTの計画. n が2の冪なら基数2, それ以外は Bluestein 法 (2の冪の長さの畳み込み)
+// で計算する. 正規化はしないので, 順変換と逆変換を続けると n 倍になる
+// Plan for a length-n one-dimensional complex FFT. Powers of two use radix 2; other lengths use
+// Bluestein's algorithm (a convolution of power-of-two length). Nothing is normalized, so a forward
+// and an inverse transform in a row scale by n
+class Fft
+{
+public:
+    using Complex = std::complex<float>;
+
+private:
+    int n;
+    // 基数2で変換する長さ. Bluestein なら 2n - 1 以上の2の冪
+    // Length transformed with radix 2; a power of two of at least 2n - 1 with Bluestein
+    int m;
+    bool bluestein;
+    std::vector<Complex> twiddles;
+    std::vector<uint32_t> reversed;
+    // Bluestein 用: chirp[k] = exp(-i pi k^2 / n) と, その共役を長さ m に折り返したもののスペクトル
+    // For Bluestein: chirp[k] = exp(-i pi k^2 / n), and the spectrum of its conjugate wrapped to length m
+    std::vector<Complex> chirp;
+    std::vector<Complex> chirp_spectrum;
+
+    void radix2(Complex* data, bool inverse) const;
+
+public:
+    explicit Fft(int n);
+
+    int size() const { return this->n; }
+    // transform に渡す作業領域の要素数
+    // Number of elements of the work area transform needs
+    std::size_t scratchSize() const { return this->bluestein ? this->m : 0; }
+    // data をその場で変換する. inverse なら指数の符号が正
+    // Transforms data in place. inverse flips the sign of the exponent to positive
+    void transform(Complex* data, bool inverse, Complex* scratch) const;
+};
+
+// 実数の場 (2次元なら i = 0 の平面) の3次元FFT. k 方向は実数2行を1つの複素変換にまとめ,
+// 非負の周波数 length / 2 + 1 個だけを持つ. スペクトルは (i, j, k) の順に並ぶ. 行ごとの変換はスレッドプールで並べる
+// Three-dimensional FFT of a real field (the i = 0 plane in 2D). Along k two real rows share one
+// complex transform, and only the length / 2 + 1 non-negative frequencies are kept. The spectrum is
+// laid out in (i, j, k) order. The per-line transforms run on a thread pool
+class RealFft3D
+{
+public:
+    using Complex = Fft::Complex;
+
+private:
+    int dim;
+    int length;
+    int half;
+    Fft line;
+    // ワーカーごとの1行分の作業領域
+    // Per-worker line buffers
+    std::vector<std::vector<Complex>> buffers;
+    std::vector<std::vector<Complex>> scratch;
+
+    void transformColumns(Complex* spectrum, bool inverse, ThreadPool& pool);
+
+public:
+    RealFft3D(int dim, int length);
+
+    // スペクトルの要素数
+    // Number of spectrum elements
+    std::size_t spectrumSize() const;
+    // pool のワーカー数ぶんの作業領域を用意する. 変換の前に呼ぶこと
+    // Prepares work areas for the pool's workers. Call before transforming
+    void reserveWorkers(int workers);
+    void forward(const float* field, Complex* spectrum, ThreadPool& pool);
+    // spectrum を書き換える. 結果はセル数で割って正規化する
+    // Overwrites spectrum. The result is normalized by dividing by the cell count
+    void inverse(Complex* spectrum, float* field, ThreadPool& pool);
+};
+
+#endif // FFT_H_
@@ -0,0 +1,89 @@
+#ifndef FIELD_VIEW_H_
+#define FIELD_VIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// セルの並べ方. Flat は行を i, j の順に並べた配列. MortonBricks は 8平面 × 8行 × 4ワードのブリックを
+// Z順 (Morton順) に並べ, ブリックの中は行の順
+// How cells are laid out. Flat is an array of rows in (i, j) order. MortonBricks stores bricks of
+// 8 planes x 8 rows x 4 words in Z (Morton) order, with rows in order inside each brick
+enum class FieldLayout { Flat, MortonBricks };
+
+// フィールドを所有しない読み取り専用ビュー. 次のprogressField()まで有効
+// Non-owning, read-only view of a field. Valid until the next progressField()
+class FieldView
+{
+public:
+    static const int BRICK_PLANES = 8;
+    static const int BRICK_ROWS = 8;
+    static const int BRICK_WORDS = 4;
+    static const int BRICK_CELLS_K = BRICK_WORDS * 64;
+
+private:
+    const uint64_t* base;
+    int ni;
+    int nj;
+    int nk;
+    std::size_t row_stride;
+    std::size_t plane_stride;
+    int bit_offset;
+    long long gen;
+    FieldLayout field_layout;
+    // MortonBricks のとき: 各軸のブリック座標をZ順の符号へ散らす表と, 符号から格納順への表
+    // For MortonBricks: per-axis tables spreading brick coordinates into the Z-order code, and code-to-slot ranks
+    const uint32_t* spread_i;
+    const uint32_t* spread_j;
+    const uint32_t* spread_k;
+    const uint32_t* brick_rank;
+
+public:
+    FieldView(const uint64_t* base, int ni, int nj, int nk,
+        std::size_t row_stride, std::size_t plane_stride, int bit_offset, long long gen)
+        : base(base), ni(ni), nj(nj), nk(nk),
+          row_stride(row_stride), plane_stride(plane_stride),
+          bit_offset(bit_offset), gen(gen), field_layout(FieldLayout::Flat),
+          spread_i(nullptr), spread_j(nullptr), spread_k(nullptr), brick_rank(nullptr) {}
+    FieldView(const uint64_t* base, int ni, int nj, int nk, const uint32_t* spread_i, const uint32_t* spread_j,
+        const uint32_t* spread_k, const uint32_t* brick_rank, long long gen)
+        : base(base), ni(ni), nj(nj), nk(nk),
+          row_stride(0), plane_stride(0), bit_offset(0), gen(gen), field_layout(FieldLayout::MortonBricks),
+          spread_i(spread_i), spread_j(spread_j), spread_k(spread_k), brick_rank(brick_rank) {}
+
+    bool at(int i, int j, int k) const {
+        if (this->field_layout == FieldLayout::MortonBricks) {
+            const uint64_t* brick = this->base + (std::size_t)this->brickSlot(i, j, k) * BRICK_PLANES * BRICK_ROWS * BRICK_WORDS;
+            const uint64_t w = brick[((i % BRICK_PLANES) * BRICK_ROWS + j % BRICK_ROWS) * BRICK_WORDS + k % BRICK_CELLS_K / 64];
+            return (w >> (k % 64)) & 1;
+        }
+        const uint64_t* r = this->base + i * this->plane_stride + j * this->row_stride;
+        const int bit = k + this->bit_offset;
+        return (r[bit / 64] >> (bit % 64)) & 1;
+    }
+    // 2次元フィールド用 (i = 0 の平面)
+    // For 2D fields (the i = 0 plane)
+    bool at(int j, int k) const { return this->at(0, j, k); }
+
+    FieldLayout layout() const { return this->field_layout; }
+    // Flat のとき: (i, j) = (0, 0) の行の先頭ワード. セル(i, j, k)は
+    // words()[i * planeStride() + j * rowStride()] の bitOffset() + k ビット目.
+    // MortonBricks のとき: セルは words() + brickSlot(i, j, k) * 256 から始まるブリックにある
+    // Flat: first word of row (0, 0). Cell (i, j, k) is bit bitOffset() + k of
+    // words()[i * planeStride() + j * rowStride()].
+    // MortonBricks: the cell lives in the brick starting at words() + brickSlot(i, j, k) * 256
+    const uint64_t* words() const { return this->base; }
+    std::size_t rowStride() const { return this->row_stride; }
+    std::size_t planeStride() const { return this->plane_stride; }
+    int bitOffset() const { return this->bit_offset; }
+    uint32_t brickSlot(int i, int j, int k) const {
+        return this->brick_rank[this->spread_i[i / BRICK_PLANES] | this->spread_j[j / BRICK_ROWS]
+            | this->spread_k[k / BRICK_CELLS_K]];
+    }
+
+    int sizeI() const { return this->ni; }
+    int sizeJ() const { return this->nj; }
+    int sizeK() const { return this->nk; }
+    long long generation() const { return this->gen; }
+};
+
+#endif // FIELD_VIEW_H_
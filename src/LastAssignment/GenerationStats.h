@@ -0,0 +1,36 @@
+#ifndef GENERATION_STATS_H_
+#define GENERATION_STATS_H_
+
+#include <array>
+#include <cstdint>
+
+// 1世代分の統計. 個体数, 前の世代からの誕生数と死亡数, 生きたセルを囲む範囲 (両端を含む) と,
+// この世代を決めた (前の世代の) 生存近傍数 0..26 ごとのセル数 (有効にしたときだけ)
+// Statistics of one generation: population, births and deaths since the previous generation,
+// the inclusive bounding box of live cells, and the cell count for each live-neighbor count 0..26
+// that decided this generation, i.e. counted on the previous one (only when enabled)
+struct GenerationStats
+{
+    long long generation = 0;
+    uint64_t population = 0;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+    // 前の世代を見ずに場から数え直したとき (統計を集めずに進めた直後など) は false で, 誕生数と死亡数は0
+    // false when counted from the field alone without the previous generation (e.g. right after
+    // stepping without collection); births and deaths are then 0
+    bool has_changes = false;
+    // 生きたセルが無ければ範囲は意味を持たない
+    // The bounding box is meaningless when nothing is alive
+    int i_min = 0;
+    int i_max = -1;
+    int j_min = 0;
+    int j_max = -1;
+    int k_min = 0;
+    int k_max = -1;
+    bool has_histogram = false;
+    std::array<uint64_t, 27> histogram{};
+
+    bool empty() const { return this->population == 0; }
+};
+
+#endif // GENERATION_STATS_H_
@@ -0,0 +1,151 @@
+#include "GenerationsEngine.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+GenerationsRule GenerationsRule::parse(const std::string& notation) {
+    const std::size_t slash = notation.rfind('/');
+    if (slash == std::string::npos || slash + 1 >= notation.size()
+        || (notation[slash + 1] != 'C' && notation[slash + 1] != 'c')) {
+        throw std::invalid_argument("invalid rule: " + notation);
+    }
+    GenerationsRule result;
+    result.rule = Rule::parse(notation.substr(0, slash));
+    const std::string count = notation.substr(slash + 2);
+    try {
+        std::size_t used = 0;
+        result.states = std::stoi(count, &used);
+        if (used != count.size()) throw std::invalid_argument(count);
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument("invalid rule: " + notation);
+    }
+    if (result.states < 2 || result.states > MAX_STATES) throw std::invalid_argument("invalid rule: " + notation);
+    return result;
+}
+
+std::string GenerationsRule::toString() const {
+    return this->rule.toString() + "/C" + std::to_string(this->states);
+}
+
+GenerationsEngine::GenerationsEngine(int dim, int length, const GenerationsRule& rule,
+    bool isNeumannNeighborhood, bool isTorus) {
+    if (rule.states < 2 || rule.states > GenerationsRule::MAX_STATES) {
+        throw std::invalid_argument("state count out of range: " + std::to_string(rule.states));
+    }
+    this->dim = dim;
+    this->length = length;
+    this->rule = rule;
+    this->neighborhood = isNeumannNeighborhood ? Neighborhood::Neumann : Neighborhood::Moore;
+    this->isTorus = isTorus;
+    this->generation = 0;
+
+    // カーネルはベクトル幅に切り上げた内部セルを書き, その東の隣まで読む
+    // The kernel writes the interior rounded up to the vector width and reads one cell past it
+    const int w = GENERATIONS_VECTOR_CELLS;
+    this->row_stride = (length + w - 1) / w * w + w;
+    this->plane_stride = (std::size_t)(length + 2) * this->row_stride;
+    this->cells.assign(this->plane_stride * (dim == 3 ? length + 2 : 1), 0);
+    this->next_cells = this->cells;
+
+    this->setKernelIsa(detectKernelIsa());
+    this->setThreadCount(0);
+}
+
+void GenerationsEngine::setKernelIsa(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        throw std::invalid_argument(std::string("kernel not supported on this CPU: ") + kernelIsaName(isa));
+    }
+    this->kernel_isa = isa;
+    this->step_tile = selectGenerationsTile(isa, this->dim, this->neighborhood);
+}
+
+void GenerationsEngine::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+}
+
+void GenerationsEngine::fillHalo() {
+    const int n = this->length;
+    const int ni = this->dim == 3 ? n : 1;
+    uint8_t* base = this->cells.data();
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < n; j++) {
+            uint8_t* row = base + this->offset(i, j, 0);
+            if (this->isTorus) {
+                row[-1] = row[n - 1];
+                row[n] = row[0];
+            } else {
+                row[n] = 0;
+            }
+        }
+    }
+    // 有界な場の袖の行と平面はカーネルが書かないので0のまま
+    // The kernel never writes the ghost rows and planes, so they stay 0 on a bounded field
+    if (!this->isTorus) return;
+    const std::size_t rs = this->row_stride;
+    for (int i = 0; i < ni; i++) {
+        std::copy_n(base + this->offset(i, n - 1, -1), rs, base + this->offset(i, -1, -1));
+        std::copy_n(base + this->offset(i, 0, -1), rs, base + this->offset(i, n, -1));
+    }
+    if (this->dim == 3) {
+        std::copy_n(base + this->offset(n - 1, -1, -1), this->plane_stride, base + this->offset(-1, -1, -1));
+        std::copy_n(base + this->offset(0, -1, -1), this->plane_stride, base + this->offset(n, -1, -1));
+    }
+}
+
+void GenerationsEngine::progressField() {
+    this->fillHalo();
+    const int n = this->length;
+    const int ni = this->dim == 3 ? n : 1;
+    const int bands = (n + TASK_ROWS - 1) / TASK_ROWS;
+    const int w = GENERATIONS_VECTOR_CELLS;
+    auto task = [this, n, bands, w](int t, int) {
+        GenerationsTile tile;
+        tile.src = this->cells.data() + this->offset(0, 0, 0);
+        tile.dst = this->next_cells.data() + this->offset(0, 0, 0);
+        tile.row_stride = this->row_stride;
+        tile.plane_stride = (std::ptrdiff_t)this->plane_stride;
+        tile.i_begin = t / bands;
+        tile.i_end = tile.i_begin + 1;
+        tile.j_begin = t % bands * TASK_ROWS;
+        tile.j_end = std::min(n, tile.j_begin + TASK_ROWS);
+        tile.k_end = (n + w - 1) / w * w;
+        tile.birth_mask = this->rule.rule.birthMask();
+        tile.survival_mask = this->rule.rule.survivalMask();
+        tile.states = this->rule.states;
+        this->step_tile(tile);
+    };
+    this->pool->parallelFor(ni * bands, task);
+    std::swap(this->cells, this->next_cells);
+    this->generation++;
+}
+
+void GenerationsEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void GenerationsEngine::randomize(float ratio, uint64_t seed) {
+    std::mt19937 eng((std::mt19937::result_type)seed);
+    std::uniform_real_distribution<float> distr(0, 1);
+    const int ni = this->dim == 3 ? this->length : 1;
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < this->length; j++) {
+            for (int k = 0; k < this->length; k++) this->setState(i, j, k, distr(eng) < ratio);
+        }
+    }
+}
+
+std::vector<uint64_t> GenerationsEngine::getStateCounts() const {
+    std::vector<uint64_t> counts(this->rule.states, 0);
+    const int ni = this->dim == 3 ? this->length : 1;
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < this->length; j++) {
+            const uint8_t* row = this->cells.data() + this->offset(i, j, 0);
+            for (int k = 0; k < this->length; k++) counts[row[k]]++;
+        }
+    }
+    return counts;
+}
@@ -0,0 +1,97 @@
+#ifndef GENERATIONS_ENGINE_H_
+#define GENERATIONS_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "KernelDispatch.h"
+#include "Rule.h"
+#include "ThreadPool.h"
+
+// 誕生/生存条件に状態数 C を足した Generations 規則. 生存できなかった生きたセルはすぐには死なず,
+// 2..C-1 の減衰状態を1世代ずつ進んでから0に戻る. 減衰中のセルは近傍として数えず, 誕生もしない
+// Generations rule: birth/survival conditions plus a state count C. A live cell that fails to survive
+// does not die at once but steps through the decaying states 2..C-1 one generation at a time before
+// returning to 0. Decaying cells are not counted as neighbors and cannot be born
+struct GenerationsRule
+{
+    static const int MAX_STATES = 255;
+
+    Rule rule;
+    int states = 2;
+
+    // "B4/S2/C5" のような表記を解釈する. C は 2..MAX_STATES. 不正な表記は std::invalid_argument
+    // Parses notations such as "B4/S2/C5", with C in 2..MAX_STATES. Throws std::invalid_argument when malformed
+    static GenerationsRule parse(const std::string& notation);
+    std::string toString() const;
+};
+
+// 1セル1バイトの状態を持つ Generations 規則のエンジン. 行は [西の袖セル][内部セル][東の袖セル][余り] で,
+// カーネルはベクトル幅ずつ状態1の近傍をバイトの比較で数える
+// Engine for Generations rules holding one byte of state per cell. A row is [west ghost cell][interior
+// cells][east ghost cell][padding], and the kernel counts state-1 neighbors a vector at a time with byte compares
+class GenerationsEngine
+{
+private:
+    // j方向にこの行数ずつ区切ってタスクにする
+    // j is cut into tasks of this many rows
+    static const int TASK_ROWS = 8;
+
+    int dim;
+    int length;
+    GenerationsRule rule;
+    Neighborhood neighborhood;
+    bool isTorus;
+    long long generation;
+    int row_stride;
+    std::size_t plane_stride;
+    std::vector<uint8_t> cells;
+    std::vector<uint8_t> next_cells;
+    KernelIsa kernel_isa;
+    GenerationsTileFn step_tile;
+    std::unique_ptr<ThreadPool> pool;
+
+    std::size_t offset(int i, int j, int k) const {
+        return (std::size_t)(i + (this->dim == 3 ? 1 : 0)) * this->plane_stride
+            + (std::size_t)(j + 1) * this->row_stride + (k + 1);
+    }
+    // 袖をトーラスなら反対側の写しで埋め, 有界ならカーネルが書いた東の袖セルを0に戻す
+    // Fills the ghosts with wrapped copies on a torus; when bounded, zeroes the east ghost cell the kernel wrote
+    void fillHalo();
+
+public:
+    // dim は 2 (i = 0 の平面) か 3. 状態数が 2..MAX_STATES でなければ std::invalid_argument
+    // dim is 2 (the i = 0 plane) or 3. Throws std::invalid_argument unless the state count is 2..MAX_STATES
+    GenerationsEngine(int dim, int length, const GenerationsRule& rule, bool isNeumannNeighborhood, bool isTorus);
+
+    void progressField();
+    void progressField(int generations);
+
+    // 0 が死, 1 が生, 2 以上が減衰中
+    // 0 is dead, 1 alive, 2 and up decaying
+    uint8_t getState(int i, int j, int k) const { return this->cells[this->offset(i, j, k)]; }
+    void setState(int i, int j, int k, uint8_t state) { this->cells[this->offset(i, j, k)] = state; }
+    bool get(int i, int j, int k) const { return this->getState(i, j, k) == 1; }
+    // 各セルを確率 ratio で生きた状態にし, 残りを0にする
+    // Makes each cell alive with probability ratio and the rest 0
+    void randomize(float ratio, uint64_t seed);
+    // 状態ごとのセル数. 添字1が個体数
+    // Cell count per state. Index 1 is the population
+    std::vector<uint64_t> getStateCounts() const;
+
+    int getLength() const { return this->length; }
+    long long getGeneration() const { return this->generation; }
+    const GenerationsRule& getRule() const { return this->rule; }
+
+    KernelIsa getKernelIsa() const { return this->kernel_isa; }
+    // CPUが対応しない命令セットを指定すると std::invalid_argument
+    // Throws std::invalid_argument if the CPU does not support the instruction set
+    void setKernelIsa(KernelIsa isa);
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count);
+};
+
+#endif // GENERATIONS_ENGINE_H_
@@ -0,0 +1,398 @@
+#include "HashLife.h"
+#include "CA.h"
+#include <stdexcept>
+#include <string>
+
+const int HashLife::LEAF_LEVEL;
+const uint32_t HashLife::NONE;
+
+HashLife::HashLife(const Rule& rule, bool isNeumannNeighborhood) {
+    if (rule.birthMask() & 1) {
+        throw std::invalid_argument("HashLife cannot run rules with birth on zero neighbors: " + rule.toString());
+    }
+    this->rule = rule;
+    this->isNeumannNeighborhood = isNeumannNeighborhood;
+    this->index.assign(1024, NONE);
+    this->generation = 0;
+    this->memory_limit = std::size_t(1) << 30;
+    this->root = this->empty(3);
+}
+
+std::size_t HashLife::hashNode(const Node& n) {
+    uint64_t h = n.level == LEAF_LEVEL ? n.bits : (uint64_t)n.level;
+    if (n.level != LEAF_LEVEL) {
+        for (int c = 0; c < 8; c++) h = (h ^ n.child[c]) * 0x9E3779B97F4A7C15ULL;
+    }
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return (std::size_t)h;
+}
+
+bool HashLife::sameContents(const Node& a, const Node& b) const {
+    if (a.level != b.level) return false;
+    if (a.level == LEAF_LEVEL) return a.bits == b.bits;
+    for (int c = 0; c < 8; c++) {
+        if (a.child[c] != b.child[c]) return false;
+    }
+    return true;
+}
+
+void HashLife::growIndex() {
+    this->index.assign(this->index.size() * 2, NONE);
+    const std::size_t mask = this->index.size() - 1;
+    for (uint32_t id = 0; id < this->nodes.size(); id++) {
+        std::size_t s = hashNode(this->nodes[id]) & mask;
+        while (this->index[s] != NONE) s = (s + 1) & mask;
+        this->index[s] = id;
+    }
+}
+
+uint32_t HashLife::intern(const Node& n) {
+    if (2 * (this->nodes.size() + 1) > this->index.size()) this->growIndex();
+    const std::size_t mask = this->index.size() - 1;
+    std::size_t s = hashNode(n) & mask;
+    for (; this->index[s] != NONE; s = (s + 1) & mask) {
+        if (this->sameContents(this->nodes[this->index[s]], n)) return this->index[s];
+    }
+    const uint32_t id = (uint32_t)this->nodes.size();
+    this->nodes.push_back(n);
+    this->index[s] = id;
+    return id;
+}
+
+uint32_t HashLife::leaf(uint64_t bits) {
+    Node n = {};
+    n.bits = bits;
+    n.population = __builtin_popcountll(bits);
+    n.level = LEAF_LEVEL;
+    return this->intern(n);
+}
+
+uint32_t HashLife::branch(const uint32_t (&child)[8]) {
+    Node n = {};
+    n.level = this->nodes[child[0]].level + 1;
+    for (int c = 0; c < 8; c++) {
+        n.child[c] = child[c];
+        n.population += this->nodes[child[c]].population;
+    }
+    return this->intern(n);
+}
+
+uint32_t HashLife::empty(int level) {
+    if ((int)this->empty_nodes.size() <= level) this->empty_nodes.resize(level + 1, NONE);
+    if (this->empty_nodes[level] == NONE) {
+        uint32_t id;
+        if (level == LEAF_LEVEL) {
+            id = this->leaf(0);
+        } else {
+            const uint32_t e = this->empty(level - 1);
+            const uint32_t child[8] = { e, e, e, e, e, e, e, e };
+            id = this->branch(child);
+        }
+        this->empty_nodes[level] = id;
+    }
+    return this->empty_nodes[level];
+}
+
+uint32_t HashLife::expand(uint32_t node) {
+    // 各子を, 1段大きな空の立方体の中心側の角へ置く
+    // Put every child in the center-facing corner of an empty cube one level larger
+    const Node n = this->nodes[node];
+    const uint32_t e = this->empty(n.level - 1);
+    uint32_t child[8];
+    for (int c = 0; c < 8; c++) {
+        uint32_t grand[8] = { e, e, e, e, e, e, e, e };
+        grand[7 - c] = n.child[c];
+        child[c] = this->branch(grand);
+    }
+    return this->branch(child);
+}
+
+bool HashLife::isPadded(uint32_t node) const {
+    // パターンが中心の 1/4 の立方体に収まっているか
+    // Whether the pattern lies inside the central cube of a quarter of the side
+    const Node& n = this->nodes[node];
+    if (n.level < 5) return false;
+    for (int c = 0; c < 8; c++) {
+        const Node& child = this->nodes[n.child[c]];
+        const Node& inner = this->nodes[this->nodes[child.child[7 - c]].child[7 - c]];
+        if (child.population != inner.population) return false;
+    }
+    return true;
+}
+
+uint32_t HashLife::centerOf(uint32_t node) {
+    const Node n = this->nodes[node];
+    if (n.level == LEAF_LEVEL + 1) {
+        uint64_t bits = 0;
+        for (int x = 0; x < 4; x++) {
+            for (int y = 0; y < 4; y++) {
+                for (int z = 0; z < 4; z++) {
+                    if (this->getCell(node, x + 2, y + 2, z + 2)) bits |= uint64_t(1) << (x * 16 + y * 4 + z);
+                }
+            }
+        }
+        return this->leaf(bits);
+    }
+    uint32_t child[8];
+    for (int c = 0; c < 8; c++) child[c] = this->nodes[n.child[c]].child[7 - c];
+    return this->branch(child);
+}
+
+uint32_t HashLife::successorBase(uint32_t node, int j) {
+    // 8x8x8 のセルを直接 1 か 2 世代進め, 中心の 4x4x4 を葉にする
+    // Step the 8x8x8 cells directly by one or two generations and keep the central 4x4x4 as a leaf
+    uint8_t cells[2][8][8][8];
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            for (int z = 0; z < 8; z++) cells[0][x][y][z] = this->getCell(node, x, y, z);
+        }
+    }
+    const int steps = j == 1 ? 2 : 1;
+    for (int s = 1; s <= steps; s++) {
+        const auto& src = cells[(s - 1) & 1];
+        auto& dst = cells[s & 1];
+        for (int x = s; x < 8 - s; x++) {
+            for (int y = s; y < 8 - s; y++) {
+                for (int z = s; z < 8 - s; z++) {
+                    int count = 0;
+                    for (int dx = -1; dx <= 1; dx++) {
+                        for (int dy = -1; dy <= 1; dy++) {
+                            for (int dz = -1; dz <= 1; dz++) {
+                                const int distance = (dx != 0) + (dy != 0) + (dz != 0);
+                                if (distance == 0 || (this->isNeumannNeighborhood && distance > 1)) continue;
+                                count += src[x + dx][y + dy][z + dz];
+                            }
+                        }
+                    }
+                    dst[x][y][z] = this->rule.isNextAlive(src[x][y][z], count);
+                }
+            }
+        }
+    }
+    uint64_t bits = 0;
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            for (int z = 0; z < 4; z++) {
+                if (cells[steps & 1][x + 2][y + 2][z + 2]) bits |= uint64_t(1) << (x * 16 + y * 4 + z);
+            }
+        }
+    }
+    return this->leaf(bits);
+}
+
+uint32_t HashLife::successor(uint32_t node, int j) {
+    const int level = this->nodes[node].level;
+    if (this->nodes[node].population == 0) return this->empty(level - 1);
+    const uint64_t key = ((uint64_t)node << 6) | (uint64_t)j;
+    const auto found = this->results.find(key);
+    if (found != this->results.end()) return found->second;
+
+    uint32_t result;
+    if (level == LEAF_LEVEL + 1) {
+        result = this->successorBase(node, j);
+    } else {
+        // 孫の 4x4x4 から半分ずつずらした 27 個の立方体を作り, まず中心を (全速なら 2^(level-3) 世代進めて)
+        // 取り出し, それを 2x2x2 ずつ組み直して残りを進める.
+        // 節点の配列は再帰中に伸びるので, 参照ではなく番号を写してから再帰する
+        // Build the 27 half-offset cubes from the 4x4x4 grandchildren, take their centers (advanced
+        // 2^(level-3) generations at full speed), then regroup them 2x2x2 and advance the rest.
+        // The node array grows during recursion, so ids are copied out before recursing
+        uint32_t grand[4][4][4];
+        for (int a = 0; a < 4; a++) {
+            for (int b = 0; b < 4; b++) {
+                for (int c = 0; c < 4; c++) {
+                    const uint32_t child = this->nodes[node].child[((a >> 1) << 2) | ((b >> 1) << 1) | (c >> 1)];
+                    grand[a][b][c] = this->nodes[child].child[((a & 1) << 2) | ((b & 1) << 1) | (c & 1)];
+                }
+            }
+        }
+        const bool full_speed = j == level - 2;
+        uint32_t part[3][3][3];
+        for (int x = 0; x < 3; x++) {
+            for (int y = 0; y < 3; y++) {
+                for (int z = 0; z < 3; z++) {
+                    uint32_t child[8];
+                    for (int d = 0; d < 8; d++) child[d] = grand[x + (d >> 2)][y + ((d >> 1) & 1)][z + (d & 1)];
+                    const uint32_t cube = this->branch(child);
+                    part[x][y][z] = full_speed ? this->successor(cube, level - 3) : this->centerOf(cube);
+                }
+            }
+        }
+        uint32_t out[8];
+        for (int d = 0; d < 8; d++) {
+            uint32_t child[8];
+            for (int e = 0; e < 8; e++) {
+                child[e] = part[(d >> 2) + (e >> 2)][((d >> 1) & 1) + ((e >> 1) & 1)][(d & 1) + (e & 1)];
+            }
+            out[d] = this->successor(this->branch(child), full_speed ? level - 3 : j);
+        }
+        result = this->branch(out);
+    }
+    this->results[key] = result;
+    return result;
+}
+
+bool HashLife::getCell(uint32_t node, long long i, long long j, long long k) const {
+    for (;;) {
+        const Node& n = this->nodes[node];
+        if (n.population == 0) return false;
+        if (n.level == LEAF_LEVEL) return (n.bits >> (i * 16 + j * 4 + k)) & 1;
+        const long long half = 1LL << (n.level - 1);
+        node = n.child[((i >= half) << 2) | ((j >= half) << 1) | (k >= half)];
+        i %= half;
+        j %= half;
+        k %= half;
+    }
+}
+
+uint32_t HashLife::setCell(uint32_t node, long long i, long long j, long long k, bool alive) {
+    const Node n = this->nodes[node];
+    if (n.level == LEAF_LEVEL) {
+        const uint64_t bit = uint64_t(1) << (i * 16 + j * 4 + k);
+        return this->leaf(alive ? n.bits | bit : n.bits & ~bit);
+    }
+    const long long half = 1LL << (n.level - 1);
+    const int c = ((i >= half) << 2) | ((j >= half) << 1) | (k >= half);
+    uint32_t child[8];
+    for (int d = 0; d < 8; d++) child[d] = n.child[d];
+    child[c] = this->setCell(n.child[c], i % half, j % half, k % half, alive);
+    return this->branch(child);
+}
+
+void HashLife::cover(long long i, long long j, long long k) {
+    for (;;) {
+        const long long half = 1LL << (this->nodes[this->root].level - 1);
+        if (i >= -half && i < half && j >= -half && j < half && k >= -half && k < half) return;
+        if (this->nodes[this->root].level >= MAX_LEVEL) {
+            throw std::invalid_argument("hashlife coordinate out of range: (" + std::to_string(i) + ", "
+                + std::to_string(j) + ", " + std::to_string(k) + ")");
+        }
+        this->root = this->expand(this->root);
+    }
+}
+
+bool HashLife::get(long long i, long long j, long long k) const {
+    const long long half = 1LL << (this->nodes[this->root].level - 1);
+    if (i < -half || i >= half || j < -half || j >= half || k < -half || k >= half) return false;
+    return this->getCell(this->root, i + half, j + half, k + half);
+}
+
+void HashLife::set(long long i, long long j, long long k, bool alive) {
+    this->cover(i, j, k);
+    const long long half = 1LL << (this->nodes[this->root].level - 1);
+    this->root = this->setCell(this->root, i + half, j + half, k + half, alive);
+}
+
+void HashLife::advance(unsigned long long n) {
+    if (n >> (MAX_LEVEL - 2)) throw std::invalid_argument("hashlife cannot advance 2^60 or more generations: " + std::to_string(n));
+    for (int j = 0; j < MAX_LEVEL - 2; j++) {
+        if (!((n >> j) & 1)) continue;
+        if (this->getMemoryUsage() > this->memory_limit) {
+            this->collectGarbage(true);
+            if (this->getMemoryUsage() > this->memory_limit) this->collectGarbage(false);
+        }
+        // 2^j 世代で広がりうる分だけ余白をとる: 中心の 1/4 に収まり, 段数が j + 3 以上
+        // Leave room for 2^j generations of growth: the pattern in the central quarter and level >= j + 3
+        while (this->nodes[this->root].level < j + 3 || !this->isPadded(this->root)) {
+            if (this->nodes[this->root].level >= MAX_LEVEL) {
+                throw std::invalid_argument("hashlife pattern outgrew the coordinate range at generation "
+                    + std::to_string(this->generation));
+            }
+            this->root = this->expand(this->root);
+        }
+        this->root = this->successor(this->root, j);
+        this->generation += 1ULL << j;
+    }
+}
+
+std::size_t HashLife::getMemoryUsage() const {
+    const std::size_t memo_entry = sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void*);
+    return this->nodes.capacity() * sizeof(Node) + this->index.size() * sizeof(uint32_t)
+        + this->results.size() * memo_entry + this->results.bucket_count() * sizeof(void*);
+}
+
+void HashLife::collectGarbage(bool keep_results) {
+    // 根と空の節点から (覚え書きを残すならその結果からも) 届く節点に印を付ける
+    // Mark the nodes reachable from the root and the empty nodes (and from kept memo results)
+    std::vector<uint8_t> marked(this->nodes.size(), 0);
+    std::vector<uint32_t> stack;
+    auto mark = [&](uint32_t start) {
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const uint32_t id = stack.back();
+            stack.pop_back();
+            if (marked[id]) continue;
+            marked[id] = 1;
+            if (this->nodes[id].level == LEAF_LEVEL) continue;
+            for (int c = 0; c < 8; c++) stack.push_back(this->nodes[id].child[c]);
+        }
+    };
+    mark(this->root);
+    for (uint32_t e: this->empty_nodes) {
+        if (e != NONE) mark(e);
+    }
+    if (keep_results) {
+        for (const auto& entry: this->results) {
+            if (marked[entry.first >> 6]) mark(entry.second);
+        }
+    }
+
+    // 子は親より先に作られるので, 番号順に詰めれば子の新しい番号は先に決まっている
+    // Children are created before their parents, so compacting in id order assigns child ids first
+    std::vector<uint32_t> remap(this->nodes.size(), NONE);
+    std::vector<Node> kept;
+    for (uint32_t id = 0; id < this->nodes.size(); id++) {
+        if (!marked[id]) continue;
+        Node n = this->nodes[id];
+        if (n.level != LEAF_LEVEL) {
+            for (int c = 0; c < 8; c++) n.child[c] = remap[n.child[c]];
+        }
+        remap[id] = (uint32_t)kept.size();
+        kept.push_back(n);
+    }
+    this->nodes.swap(kept);
+    this->nodes.shrink_to_fit();
+
+    std::size_t slots = 1024;
+    while (slots < 2 * this->nodes.size()) slots *= 2;
+    this->index.assign(slots / 2, NONE);
+    this->growIndex();
+
+    std::unordered_map<uint64_t, uint32_t> results;
+    if (keep_results) {
+        for (const auto& entry: this->results) {
+            const uint32_t node = remap[entry.first >> 6];
+            const uint32_t result = remap[entry.second];
+            if (node != NONE && result != NONE) results[((uint64_t)node << 6) | (entry.first & 63)] = result;
+        }
+    }
+    this->results.swap(results);
+
+    this->root = remap[this->root];
+    for (uint32_t& e: this->empty_nodes) {
+        if (e != NONE) e = remap[e];
+    }
+}
+
+void HashLife::loadField(const FieldView& field) {
+    this->root = this->empty(3);
+    for (int i = 0; i < field.sizeI(); i++) {
+        for (int j = 0; j < field.sizeJ(); j++) {
+            for (int k = 0; k < field.sizeK(); k++) {
+                if (field.at(i, j, k)) this->set(i, j, k, true);
+            }
+        }
+    }
+    this->generation = field.generation();
+}
+
+void HashLife::storeField(CA& ca) const {
+    const FieldView field = ca.getFieldView();
+    for (int i = 0; i < field.sizeI(); i++) {
+        for (int j = 0; j < field.sizeJ(); j++) {
+            for (int k = 0; k < field.sizeK(); k++) ca.setCell(i, j, k, this->get(i, j, k));
+        }
+    }
+}
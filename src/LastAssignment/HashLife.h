@@ -0,0 +1,116 @@
+#ifndef HASH_LIFE_H_
+#define HASH_LIFE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "FieldView.h"
+#include "Rule.h"
+
+class CA;
+
+// 3次元のHashLife. 同じ内容の部分空間を1つの節点にまとめた八分木で場を表し,
+// 節点ごとに「中心を 2^j 世代進めた結果」を覚えておくことで, 周期的または疎なパターンを
+// 指数的に先の世代まで進める. 場は全方向に無限で, 外側はすべて死んだセル.
+// 0近傍で誕生する規則は無限に誕生が起きるので扱わない
+// 3D HashLife. The field is an octree in which identical subcubes share one canonical node, and each
+// node remembers its center advanced by 2^j generations, so periodic or sparse patterns can be advanced
+// exponentially far. The field is unbounded, with dead cells everywhere outside the pattern.
+// Rules with birth on zero neighbors would give births everywhere and are rejected
+class HashLife
+{
+private:
+    // 4x4x4 の葉はセルを1ワードに持つ. ビット (x * 16 + y * 4 + z)
+    // A 4x4x4 leaf stores its cells in one word, at bit (x * 16 + y * 4 + z)
+    static const int LEAF_LEVEL = 2;
+    static const uint32_t NONE = ~uint32_t(0);
+    // 根の段数の上限. 座標に根の半分 2^(level - 1) を足しても long long に収まる
+    // Upper bound on the root level, so adding half the root side 2^(level - 1) to a coordinate fits in a long long
+    static const int MAX_LEVEL = 62;
+
+    // 1辺 2^level の立方体. 子 c = (x << 2) | (y << 1) | z は各軸の下半分(0)か上半分(1)
+    // Cube of side 2^level. Child c = (x << 2) | (y << 1) | z picks the lower (0) or upper (1) half of each axis
+    struct Node
+    {
+        uint32_t child[8];
+        uint64_t bits;
+        uint64_t population;
+        int level;
+    };
+
+    Rule rule;
+    bool isNeumannNeighborhood;
+    std::vector<Node> nodes;
+    // 内容から節点番号を引く開番地法の表
+    // Open-addressing table from node contents to node index
+    std::vector<uint32_t> index;
+    std::vector<uint32_t> empty_nodes;
+    // (節点, j) から 2^j 世代後の中心への覚え書き
+    // Memo from (node, j) to its center 2^j generations later
+    std::unordered_map<uint64_t, uint32_t> results;
+    // 根は [-2^(level-1), 2^(level-1)) の立方体
+    // The root covers the cube [-2^(level-1), 2^(level-1))
+    uint32_t root;
+    unsigned long long generation;
+    std::size_t memory_limit;
+
+    static std::size_t hashNode(const Node& n);
+    bool sameContents(const Node& a, const Node& b) const;
+    uint32_t intern(const Node& n);
+    void growIndex();
+    uint32_t leaf(uint64_t bits);
+    uint32_t branch(const uint32_t (&child)[8]);
+    uint32_t empty(int level);
+
+    uint32_t expand(uint32_t node);
+    bool isPadded(uint32_t node) const;
+    uint32_t centerOf(uint32_t node);
+    uint32_t successor(uint32_t node, int j);
+    uint32_t successorBase(uint32_t node, int j);
+
+    bool getCell(uint32_t node, long long i, long long j, long long k) const;
+    uint32_t setCell(uint32_t node, long long i, long long j, long long k, bool alive);
+    // 根の範囲に (i, j, k) が入るまで根を広げる
+    // Expands the root until (i, j, k) lies inside it
+    void cover(long long i, long long j, long long k);
+
+    void collectGarbage(bool keep_results);
+
+public:
+    // 規則が0近傍での誕生を含むと std::invalid_argument
+    // Throws std::invalid_argument for rules with birth on zero neighbors
+    HashLife(const Rule& rule, bool isNeumannNeighborhood);
+
+    bool get(long long i, long long j, long long k) const;
+    // 座標は [-2^61, 2^61) の範囲. 外れると std::invalid_argument
+    // Coordinates lie in [-2^61, 2^61); anything outside throws std::invalid_argument
+    void set(long long i, long long j, long long k, bool alive);
+    // n 世代進める. n の2進表現の各ビットごとに, 覚え書きを使って 2^j 世代ずつ進める.
+    // 2^j 世代の跳躍には段数 j + 3 の根が要るので, n は 2^60 未満に限り, それ以上は std::invalid_argument.
+    // 模様が座標の範囲を超えて広がる場合も, その跳躍の前に std::invalid_argument
+    // Advances n generations, one memoized 2^j jump for every set bit of n. A 2^j jump needs a root of
+    // level j + 3, so n must be below 2^60; larger values throw std::invalid_argument. A pattern that
+    // would grow past the coordinate range also throws std::invalid_argument, before that jump
+    void advance(unsigned long long n);
+
+    unsigned long long getGeneration() const { return this->generation; }
+    uint64_t getPopulation() const { return this->nodes[this->root].population; }
+    std::size_t getNodeCount() const { return this->nodes.size(); }
+
+    // 節点と覚え書きの概算バイト数. 世代を進める前にこれが上限を超えていたら,
+    // 根から届かない節点を捨て, それでも超えるなら覚え書きも捨てる
+    // Approximate bytes used by nodes and memos. When this exceeds the limit before a jump,
+    // nodes unreachable from the root are dropped, and the memos as well if that is not enough
+    std::size_t getMemoryUsage() const;
+    void setMemoryLimit(std::size_t bytes) { this->memory_limit = bytes; }
+
+    // 密な場のセル (i, j, k) を同じ座標に読み込む. それまでのセルは消え, 世代番号は場のものになる
+    // Loads the cells of a dense field at the same coordinates, replacing all cells and taking its generation
+    void loadField(const FieldView& field);
+    // [0, length)^3 の範囲を密な場へ書き出す. 範囲外のセルは書き出されない
+    // Writes the cube [0, length)^3 into a dense field. Cells outside that cube are not written
+    void storeField(CA& ca) const;
+};
+
+#endif // HASH_LIFE_H_
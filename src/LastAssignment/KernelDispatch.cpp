@@ -0,0 +1,125 @@
+#include "KernelDispatch.h"
+#include "BitKernel.h"
+#include "ByteKernel.h"
+
+namespace {
+
+template <int Dim, Neighborhood N>
+struct ScalarTile
+{
+    static void run(const StepTile& tile) {
+        bitkernel::stepTile<uint64_t, Dim, N>(tile);
+    }
+};
+
+template <int Dim, Neighborhood N>
+struct ScalarEnsembleTile
+{
+    static void run(const EnsembleTile& tile) {
+        bitkernel::stepEnsembleTile<uint64_t, Dim, N>(tile);
+    }
+};
+
+template <int Dim, Neighborhood N>
+struct ScalarGenerationsTile
+{
+    static void run(const GenerationsTile& tile) {
+        bytekernel::stepGenerationsTile<uint8_t, Dim, N>(tile);
+    }
+};
+
+}
+
+StepTileFn stepTileScalar(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<ScalarTile>(dim, neighborhood);
+}
+
+EnsembleTileFn ensembleTileScalar(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<ScalarEnsembleTile>(dim, neighborhood);
+}
+
+GenerationsTileFn generationsTileScalar(int dim, Neighborhood neighborhood) {
+    return bitkernel::stepTileTable<ScalarGenerationsTile>(dim, neighborhood);
+}
+
+#if !(defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+// x86以外ではSIMD版を持たない
+// No SIMD versions outside x86
+StepTileFn stepTileAVX2(int, Neighborhood) { return nullptr; }
+StepTileFn stepTileAVX512(int, Neighborhood) { return nullptr; }
+StepTileFn stepTileAVX512Popcount(int, Neighborhood) { return nullptr; }
+EnsembleTileFn ensembleTileAVX2(int, Neighborhood) { return nullptr; }
+EnsembleTileFn ensembleTileAVX512(int, Neighborhood) { return nullptr; }
+GenerationsTileFn generationsTileAVX2(int, Neighborhood) { return nullptr; }
+#endif
+
+std::size_t stepTileScratchWords(int row_words, int tile_rows) {
+    // 行和3行 (2桁) + 平面和3平面 (4桁)
+    // Three rows of row sums (two digits) + three planes of plane sums (four digits)
+    return (std::size_t)row_words * (3 * 2 + 3 * 4 * (std::size_t)tile_rows);
+}
+
+bool isKernelIsaSupported(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::Scalar:
+        return true;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    case KernelIsa::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case KernelIsa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+KernelIsa detectKernelIsa() {
+    if (isKernelIsaSupported(KernelIsa::AVX512)) return KernelIsa::AVX512;
+    if (isKernelIsaSupported(KernelIsa::AVX2)) return KernelIsa::AVX2;
+    return KernelIsa::Scalar;
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::AVX2: return "avx2";
+    case KernelIsa::AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+StepTileFn selectStepTile(KernelIsa isa, int dim, Neighborhood neighborhood) {
+    switch (isa) {
+    case KernelIsa::AVX2: return stepTileAVX2(dim, neighborhood);
+    case KernelIsa::AVX512:
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        // VPOPCNTDQ と VL があれば, 統計の誕生と死亡をレーンごとの popcount で数える版を使う
+        // With VPOPCNTDQ and VL, use the build that counts births and deaths with per-lane popcounts
+        if (__builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("avx512vl")) {
+            return stepTileAVX512Popcount(dim, neighborhood);
+        }
+#endif
+        return stepTileAVX512(dim, neighborhood);
+    default: return stepTileScalar(dim, neighborhood);
+    }
+}
+
+EnsembleTileFn selectEnsembleTile(KernelIsa isa, int dim, Neighborhood neighborhood) {
+    switch (isa) {
+    case KernelIsa::AVX2: return ensembleTileAVX2(dim, neighborhood);
+    case KernelIsa::AVX512: return ensembleTileAVX512(dim, neighborhood);
+    default: return ensembleTileScalar(dim, neighborhood);
+    }
+}
+
+GenerationsTileFn selectGenerationsTile(KernelIsa isa, int dim, Neighborhood neighborhood) {
+    // バイト単位の比較は AVX-512F に無い (AVX-512BW が要る) ので, AVX-512 でも AVX2 版を使う
+    // Byte compares are not in AVX-512F (they need AVX-512BW), so AVX-512 uses the AVX2 version too
+    switch (isa) {
+    case KernelIsa::AVX2:
+    case KernelIsa::AVX512:
+        return generationsTileAVX2(dim, neighborhood);
+    default:
+        return generationsTileScalar(dim, neighborhood);
+    }
+}
@@ -0,0 +1,148 @@
+#ifndef KERNEL_DISPATCH_H_
+#define KERNEL_DISPATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Neighborhood { Moore, Neumann };
+enum class Boundary { Torus, Bounded };
+
+// 世代計算カーネルの命令セット. 起動時にCPUIDで選ぶが, 比較のため固定もできる
+// Instruction set of the stepping kernel. Chosen from CPUID at startup, but can be forced for A/B tests
+enum class KernelIsa { Scalar, AVX2, AVX512 };
+
+// 統計でワードごとの論理和を取るブリック (CAEngine が変化を追うブリックと同じ) の平面数と行数
+// Planes and rows of the bricks whose per-word ORs the statistics keep (the same bricks CAEngine tracks changes in)
+static const int STATS_BRICK_PLANES = 8;
+static const int STATS_BRICK_ROWS = 8;
+
+// ワーカーごとの誕生数, 死亡数と, 生存近傍数 0..26 ごとのセル数
+// Per-worker births, deaths and cell counts for each live-neighbor count 0..26
+struct alignas(64) WorkerStats
+{
+    uint64_t births;
+    uint64_t deaths;
+    uint64_t histogram[27];
+};
+
+// カーネルに渡す1タイル分の仕事. 平面 [i_begin, i_end) × 行 [j_begin, j_end) × ワード [word_begin, word_end)
+// を次世代へ進める. ワードの範囲は4の倍数で区切る.
+// src/dst は内部行 (0, 0) の先頭で, 袖の行は負の添字で参照する
+// One tile of work for a kernel: steps planes [i_begin, i_end) x rows [j_begin, j_end) x words
+// [word_begin, word_end). Word ranges are cut at multiples of four.
+// src/dst point at interior row (0, 0); ghost rows are reached with negative offsets
+struct StepTile
+{
+    const uint64_t* src;
+    uint64_t* dst;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t plane_stride;
+    int row_words;
+    const uint64_t* mask;
+    int i_begin;
+    int i_end;
+    int j_begin;
+    int j_end;
+    int word_begin;
+    int word_end;
+    uint32_t birth_mask;
+    uint32_t survival_mask;
+    // stepTileScratchWords() ワード以上の作業領域
+    // Work area of at least stepTileScratchWords() words
+    uint64_t* scratch;
+    // 統計を集めるときの書き込み先で, 集めないときは nullptr. brick_or はブリックごとに row_words
+    // ワード分の論理和を (i ブリック, j ブリック) の順に並べたもの. タイルはブリックの境目から始めること.
+    // histogram が立っていれば近傍数の分布も数える
+    // Where statistics go when they are collected, nullptr otherwise. brick_or holds row_words words
+    // of ORs per row of bricks, in (i brick, j brick) order. Tiles must start on brick boundaries.
+    // The neighbor-count histogram is counted too when histogram is set
+    uint64_t* brick_or = nullptr;
+    int bricks_j = 0;
+    WorkerStats* worker_stats = nullptr;
+    bool histogram = false;
+};
+
+using StepTileFn = void (*)(const StepTile& tile);
+
+// 集団 (EnsembleEngine) のカーネルに渡す1タイル分の仕事. 各セルは cell_words ワードで, ワードのビット b が
+// 世界 b のセル. k方向の隣のセルは cell_words ワード離れているだけなので, 行をワードの列として扱い,
+// 平面 [i_begin, i_end) × 行 [j_begin, j_end) × ワード [word_begin, word_end) を進める.
+// ワードの範囲は8の倍数で区切る. src/dst は内部行 (0, 0) の先頭
+// One tile of work for the ensemble (EnsembleEngine) kernels. Each cell takes cell_words words, and bit
+// b of a word is the cell of world b. The k neighbors are just cell_words words away, so rows are treated
+// as runs of words: steps planes [i_begin, i_end) x rows [j_begin, j_end) x words [word_begin, word_end).
+// Word ranges are cut at multiples of eight. src/dst point at interior row (0, 0)
+struct EnsembleTile
+{
+    const uint64_t* src;
+    uint64_t* dst;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t plane_stride;
+    int cell_words;
+    int i_begin;
+    int i_end;
+    int j_begin;
+    int j_end;
+    int word_begin;
+    int word_end;
+    uint32_t birth_mask;
+    uint32_t survival_mask;
+};
+
+using EnsembleTileFn = void (*)(const EnsembleTile& tile);
+
+// 多状態の Generations 規則 (GenerationsEngine) のカーネルに渡す1タイル分の仕事. セルは1バイトの状態で,
+// 0 が死, 1 が生, 2..states-1 が減衰中. 平面 [i_begin, i_end) × 行 [j_begin, j_end) × セル [0, k_end) を進める.
+// k_end はベクトル幅の倍数で, 行は k_end + 1 セルまで読み書きできること. src/dst は内部のセル (0, 0, 0)
+// One tile of work for the multi-state Generations (GenerationsEngine) kernels. Cells are one-byte states:
+// 0 is dead, 1 alive and 2..states-1 decaying. Steps planes [i_begin, i_end) x rows [j_begin, j_end) x
+// cells [0, k_end). k_end is a multiple of the vector width, and rows must be readable and writable up to
+// cell k_end + 1. src/dst point at interior cell (0, 0, 0)
+struct GenerationsTile
+{
+    const uint8_t* src;
+    uint8_t* dst;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t plane_stride;
+    int i_begin;
+    int i_end;
+    int j_begin;
+    int j_end;
+    int k_end;
+    uint32_t birth_mask;
+    uint32_t survival_mask;
+    int states;
+};
+
+using GenerationsTileFn = void (*)(const GenerationsTile& tile);
+
+// Generations のカーネルが一度に進めるセル数の最大. 行の余白はこれに合わせる
+// Most cells a Generations kernel steps at once; row padding is sized for it
+static const int GENERATIONS_VECTOR_CELLS = 32;
+
+// j方向にこの行数ずつ区切ると, 3平面分の作業領域がL2に収まる
+// Splitting j into this many rows keeps the three planes of work area inside L2
+static const int STEP_TILE_ROWS = 32;
+
+std::size_t stepTileScratchWords(int row_words, int tile_rows);
+
+KernelIsa detectKernelIsa();
+bool isKernelIsaSupported(KernelIsa isa);
+const char* kernelIsaName(KernelIsa isa);
+StepTileFn selectStepTile(KernelIsa isa, int dim, Neighborhood neighborhood);
+EnsembleTileFn selectEnsembleTile(KernelIsa isa, int dim, Neighborhood neighborhood);
+GenerationsTileFn selectGenerationsTile(KernelIsa isa, int dim, Neighborhood neighborhood);
+
+// 命令セットごとの翻訳単位が提供する表
+// Tables provided by the per-instruction-set translation units
+StepTileFn stepTileScalar(int dim, Neighborhood neighborhood);
+StepTileFn stepTileAVX2(int dim, Neighborhood neighborhood);
+StepTileFn stepTileAVX512(int dim, Neighborhood neighborhood);
+StepTileFn stepTileAVX512Popcount(int dim, Neighborhood neighborhood);
+EnsembleTileFn ensembleTileScalar(int dim, Neighborhood neighborhood);
+EnsembleTileFn ensembleTileAVX2(int dim, Neighborhood neighborhood);
+EnsembleTileFn ensembleTileAVX512(int dim, Neighborhood neighborhood);
+GenerationsTileFn generationsTileScalar(int dim, Neighborhood neighborhood);
+GenerationsTileFn generationsTileAVX2(int dim, Neighborhood neighborhood);
+
+#endif // KERNEL_DISPATCH_H_
@@ -0,0 +1,236 @@
+#include "LargerThanLife.h"
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// k 方向の累積和でまとめる行数と, j 方向の累積和でまとめる列数
+// Rows per task of the k prefix sums, and columns per task of the j prefix sums
+const int TASK_ROWS = 8;
+const int TASK_COLUMNS = 64;
+
+int floorDiv(int x, int n) {
+    return x >= 0 ? x / n : -((n - 1 - x) / n);
+}
+
+// "34..58" または "34" を解釈する
+// Parses "34..58" or "34"
+void parseRange(const std::string& notation, const std::string& item, int& lo, int& hi) {
+    const std::size_t dots = item.find("..");
+    try {
+        std::size_t used = 0;
+        lo = std::stoi(item.substr(0, dots), &used);
+        if (used != (dots == std::string::npos ? item.size() : dots)) throw std::invalid_argument(item);
+        hi = lo;
+        if (dots != std::string::npos) {
+            hi = std::stoi(item.substr(dots + 2), &used);
+            if (used != item.size() - dots - 2) throw std::invalid_argument(item);
+        }
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument("invalid rule: " + notation);
+    }
+    if (lo < 0 || lo > hi) throw std::invalid_argument("invalid rule: " + notation);
+}
+
+}
+
+RangeRule RangeRule::parse(const std::string& notation) {
+    RangeRule rule;
+    bool hasRadius = false;
+    bool hasBirth = false;
+    bool hasSurvival = false;
+    std::size_t pos = 0;
+    while (pos <= notation.size()) {
+        std::size_t end = notation.find(',', pos);
+        if (end == std::string::npos) end = notation.size();
+        const std::string item = notation.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) throw std::invalid_argument("invalid rule: " + notation);
+        const char key = (char)std::toupper((unsigned char)item[0]);
+        const std::string value = item.substr(1);
+        int lo = 0;
+        int hi = 0;
+        if (key == 'N') {
+            if (value != "M" && value != "m") throw std::invalid_argument("only the box neighborhood (NM) is supported: " + notation);
+            continue;
+        }
+        parseRange(notation, value, lo, hi);
+        if (key == 'R' && lo == hi) {
+            rule.radius = lo;
+            hasRadius = true;
+        } else if (key == 'C' && lo == hi) {
+            if (lo > 2) throw std::invalid_argument("only two states are supported: " + notation);
+        } else if (key == 'M' && lo == hi && lo <= 1) {
+            rule.includes_center = lo == 1;
+        } else if (key == 'S') {
+            rule.survival_min = lo;
+            rule.survival_max = hi;
+            hasSurvival = true;
+        } else if (key == 'B') {
+            rule.birth_min = lo;
+            rule.birth_max = hi;
+            hasBirth = true;
+        } else {
+            throw std::invalid_argument("invalid rule: " + notation);
+        }
+    }
+    if (!hasRadius || !hasBirth || !hasSurvival || rule.radius < 1 || rule.radius > MAX_RADIUS) {
+        throw std::invalid_argument("invalid rule: " + notation);
+    }
+    return rule;
+}
+
+std::string RangeRule::toString() const {
+    return "R" + std::to_string(this->radius) + ",C0,M" + (this->includes_center ? "1" : "0")
+        + ",S" + std::to_string(this->survival_min) + ".." + std::to_string(this->survival_max)
+        + ",B" + std::to_string(this->birth_min) + ".." + std::to_string(this->birth_max) + ",NM";
+}
+
+LargerThanLifeEngine::LargerThanLifeEngine(int dim, int length, const RangeRule& rule, bool isTorus) {
+    if (rule.radius < 1 || rule.radius > RangeRule::MAX_RADIUS) {
+        throw std::invalid_argument("radius out of range: " + std::to_string(rule.radius));
+    }
+    this->dim = dim;
+    this->length = length;
+    this->rule = rule;
+    this->isTorus = isTorus;
+    this->generation = 0;
+    const std::size_t size = (std::size_t)(dim == 3 ? length : 1) * length * length;
+    this->cells.assign(size, 0);
+    this->next_cells.assign(size, 0);
+    this->row_sums.assign(size, 0);
+    this->plane_sums.assign(size, 0);
+    this->setThreadCount(0);
+}
+
+void LargerThanLifeEngine::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+    // 累積和 (length + 1) 行と, 窓和を書く1行
+    // The (length + 1) prefix rows plus one row the window sums are written to
+    const int n = this->length;
+    this->scratch.assign(thread_count, std::vector<uint32_t>((std::size_t)(n + 2) * std::max(n, TASK_COLUMNS)));
+}
+
+template <typename T>
+void LargerThanLifeEngine::windowSums(const uint32_t* prefix, int stride, int width, int c, T* out) const {
+    const int n = this->length;
+    const int r = this->rule.radius;
+    // 和は F(c + r + 1) - F(c - r). トーラスでは F(x) = floor(x / n) * 全体 + prefix[x mod n] で,
+    // 有界なら端で切った区間の差
+    // The sum is F(c + r + 1) - F(c - r). On a torus F(x) = floor(x / n) * total + prefix[x mod n];
+    // when bounded it is the difference over the clipped range
+    int lo = c - r;
+    int hi = c + r + 1;
+    uint32_t wraps = 0;
+    if (this->isTorus) {
+        const int qlo = floorDiv(lo, n);
+        const int qhi = floorDiv(hi, n);
+        wraps = (uint32_t)(qhi - qlo);
+        lo -= qlo * n;
+        hi -= qhi * n;
+    } else {
+        lo = std::max(lo, 0);
+        hi = std::min(hi, n);
+    }
+    const uint32_t* plo = prefix + (std::size_t)lo * stride;
+    const uint32_t* phi = prefix + (std::size_t)hi * stride;
+    const uint32_t* total = prefix + (std::size_t)n * stride;
+    // 差は負になりうるが, 符号なしの剰余演算で最後の和は正しい
+    // The difference can go negative, but unsigned modular arithmetic still gives the right sum
+    for (int x = 0; x < width; x++) out[x] = (T)(wraps * total[x] + phi[x] - plo[x]);
+}
+
+void LargerThanLifeEngine::progressField() {
+    const int n = this->length;
+    const int ni = this->dim == 3 ? n : 1;
+    const int bands = (n + TASK_ROWS - 1) / TASK_ROWS;
+    const int column_blocks = (n + TASK_COLUMNS - 1) / TASK_COLUMNS;
+
+    // k 方向: 行ごとの累積和から窓和を row_sums へ
+    // Along k: window sums of each row from its prefix sums, into row_sums
+    auto along_k = [this, n, bands](int t, int worker) {
+        uint32_t* prefix = this->scratch[worker].data();
+        const int i = t / bands;
+        const int j_end = std::min(n, t % bands * TASK_ROWS + TASK_ROWS);
+        for (int j = t % bands * TASK_ROWS; j < j_end; j++) {
+            const uint8_t* row = &this->cells[this->index(i, j, 0)];
+            prefix[0] = 0;
+            for (int k = 0; k < n; k++) prefix[k + 1] = prefix[k] + row[k];
+            uint16_t* out = &this->row_sums[this->index(i, j, 0)];
+            for (int k = 0; k < n; k++) this->windowSums(prefix, 1, 1, k, out + k);
+        }
+    };
+    this->pool->parallelFor(ni * bands, along_k);
+
+    // j 方向: 列の塊ごとに行を重ねた累積和から窓和を plane_sums へ
+    // Along j: window sums from prefix sums over whole rows, one block of columns per task, into plane_sums
+    auto along_j = [this, n, column_blocks](int t, int worker) {
+        uint32_t* prefix = this->scratch[worker].data();
+        const int i = t / column_blocks;
+        const int k0 = t % column_blocks * TASK_COLUMNS;
+        const int width = std::min(n - k0, TASK_COLUMNS);
+        std::fill(prefix, prefix + width, 0);
+        for (int j = 0; j < n; j++) {
+            const uint16_t* row = &this->row_sums[this->index(i, j, k0)];
+            uint32_t* dst = prefix + (std::size_t)(j + 1) * TASK_COLUMNS;
+            const uint32_t* src = dst - TASK_COLUMNS;
+            for (int x = 0; x < width; x++) dst[x] = src[x] + row[x];
+        }
+        for (int j = 0; j < n; j++) {
+            this->windowSums(prefix, TASK_COLUMNS, width, j, &this->plane_sums[this->index(i, j, k0)]);
+        }
+    };
+    this->pool->parallelFor(ni * column_blocks, along_j);
+
+    // i 方向 (3次元のみ) の窓和を作りつつ規則を当てる. 平面では plane_sums がそのまま近傍数
+    // Window sums along i (3D only), applying the rule as they come. On a plane, plane_sums already holds the counts
+    auto along_i = [this, n, ni](int j, int worker) {
+        uint32_t* prefix = this->scratch[worker].data();
+        uint32_t* counts = prefix + (std::size_t)(n + 1) * n;
+        if (this->dim == 3) {
+            std::fill(prefix, prefix + n, 0);
+            for (int i = 0; i < n; i++) {
+                const uint16_t* row = &this->plane_sums[this->index(i, j, 0)];
+                uint32_t* dst = prefix + (std::size_t)(i + 1) * n;
+                const uint32_t* src = dst - n;
+                for (int k = 0; k < n; k++) dst[k] = src[k] + row[k];
+            }
+        }
+        const int center = this->rule.includes_center ? 0 : 1;
+        for (int i = 0; i < ni; i++) {
+            if (this->dim == 3) this->windowSums(prefix, n, n, i, counts);
+            else std::copy_n(&this->plane_sums[this->index(0, j, 0)], n, counts);
+            const uint8_t* row = &this->cells[this->index(i, j, 0)];
+            uint8_t* out = &this->next_cells[this->index(i, j, 0)];
+            for (int k = 0; k < n; k++) {
+                out[k] = this->rule.isNextAlive(row[k] != 0, (int)counts[k] - center * row[k]);
+            }
+        }
+    };
+    this->pool->parallelFor(n, along_i);
+
+    std::swap(this->cells, this->next_cells);
+    this->generation++;
+}
+
+void LargerThanLifeEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void LargerThanLifeEngine::randomize(float ratio, uint64_t seed) {
+    std::mt19937 eng((std::mt19937::result_type)seed);
+    std::uniform_real_distribution<float> distr(0, 1);
+    for (uint8_t& cell: this->cells) cell = distr(eng) < ratio;
+}
+
+uint64_t LargerThanLifeEngine::getPopulation() const {
+    uint64_t population = 0;
+    for (uint8_t cell: this->cells) population += cell;
+    return population;
+}
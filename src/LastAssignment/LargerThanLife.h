@@ -0,0 +1,90 @@
+#ifndef LARGER_THAN_LIFE_H_
+#define LARGER_THAN_LIFE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+// 半径 r の立方体 (平面では正方形) 近傍で, 誕生と生存を近傍数の区間で決める規則 (Larger than Life).
+// includes_center なら中心のセル自身も数える
+// Rule on the radius-r box neighborhood (a square when planar) where birth and survival are ranges of
+// the neighbor count (Larger than Life). With includes_center the cell itself is counted too
+struct RangeRule
+{
+    static const int MAX_RADIUS = 10;
+
+    int radius = 1;
+    bool includes_center = false;
+    int birth_min = 1;
+    int birth_max = 0;
+    int survival_min = 1;
+    int survival_max = 0;
+
+    bool isNextAlive(bool alive, int count) const {
+        return alive ? survival_min <= count && count <= survival_max : birth_min <= count && count <= birth_max;
+    }
+    // Golly の "R5,C0,M1,S34..58,B34..45,NM" 形式を解釈する. 状態数は 0 か 2, 近傍は M (立方体) のみ.
+    // 不正な表記は std::invalid_argument
+    // Parses Golly's "R5,C0,M1,S34..58,B34..45,NM" notation. Only 0 or 2 states and the M (box)
+    // neighborhood are accepted. Throws std::invalid_argument when malformed
+    static RangeRule parse(const std::string& notation);
+    std::string toString() const;
+};
+
+// 半径 r の近傍数を, 軸ごとの累積和の差で求めるエンジン. k, j, i の順に1次元の窓和を重ねるので,
+// 1セルあたりの手間は r に依らない. トーラスでは窓が場より長くても周回の回数ぶん全体の和を足す
+// Engine computing radius-r neighbor counts as differences of per-axis prefix sums. One-dimensional
+// window sums are stacked along k, j, then i, so the work per cell does not depend on r. On a torus a
+// window longer than the field adds the line total once per wrap
+class LargerThanLifeEngine
+{
+private:
+    int dim;
+    int length;
+    RangeRule rule;
+    bool isTorus;
+    long long generation;
+    std::vector<uint8_t> cells;
+    std::vector<uint8_t> next_cells;
+    // k 方向と j 方向の窓和. 半径10でも 21 * 21 = 441 までなので16ビットで足りる
+    // Window sums along k and along j. At most 21 * 21 = 441 even at radius 10, so 16 bits suffice
+    std::vector<uint16_t> row_sums;
+    std::vector<uint16_t> plane_sums;
+    // ワーカーごとの累積和の作業領域
+    // Per-worker prefix-sum scratch
+    std::vector<std::vector<uint32_t>> scratch;
+    std::unique_ptr<ThreadPool> pool;
+
+    std::size_t index(int i, int j, int k) const {
+        return ((std::size_t)i * this->length + j) * this->length + k;
+    }
+    // 累積和 prefix (length + 1 行, 各行は width 列で行の間隔は stride) から, 窓 [c - r, c + r] の和を列ごとに out に書く
+    // Writes the per-column window sums over [c - r, c + r] to out, from prefix (length + 1 rows of
+    // width columns, stride apart)
+    template <typename T>
+    void windowSums(const uint32_t* prefix, int stride, int width, int c, T* out) const;
+
+public:
+    // dim は 2 (i = 0 の平面) か 3. 半径が 1..MAX_RADIUS でなければ std::invalid_argument
+    // dim is 2 (the i = 0 plane) or 3. Throws std::invalid_argument unless the radius is 1..MAX_RADIUS
+    LargerThanLifeEngine(int dim, int length, const RangeRule& rule, bool isTorus);
+
+    void progressField();
+    void progressField(int generations);
+
+    bool get(int i, int j, int k) const { return this->cells[this->index(i, j, k)] != 0; }
+    void set(int i, int j, int k, bool alive) { this->cells[this->index(i, j, k)] = alive; }
+    void randomize(float ratio, uint64_t seed);
+    uint64_t getPopulation() const;
+
+    int getLength() const { return this->length; }
+    long long getGeneration() const { return this->generation; }
+    const RangeRule& getRule() const { return this->rule; }
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count);
+};
+
+#endif // LARGER_THAN_LIFE_H_
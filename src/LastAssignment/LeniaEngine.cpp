@@ -0,0 +1,187 @@
+#include "LeniaEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+LeniaEngine::LeniaEngine(int dim, int length, const LeniaParams& params) : fft(dim, length) {
+    if (params.radius < 1) throw std::invalid_argument("radius out of range: " + std::to_string(params.radius));
+    if (params.peaks.empty()) throw std::invalid_argument("kernel needs at least one peak");
+    this->dim = dim;
+    this->length = length;
+    this->params = params;
+    this->generation = 0;
+    const std::size_t size = (std::size_t)(dim == 3 ? length : 1) * length * length;
+    this->cells.assign(size, 0.0f);
+    this->potential.assign(size, 0.0f);
+    this->method = ConvolutionMethod::Auto;
+    this->chosen_method = ConvolutionMethod::Auto;
+    this->buildKernel();
+    this->setThreadCount(0);
+}
+
+void LeniaEngine::setThreadCount(int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    this->pool = std::make_unique<ThreadPool>(thread_count);
+    this->fft.reserveWorkers(thread_count);
+}
+
+void LeniaEngine::setConvolutionMethod(ConvolutionMethod method) {
+    this->method = method;
+    this->chosen_method = method;
+}
+
+void LeniaEngine::buildKernel() {
+    // 殻の形は exp(4 - 1 / (x (1 - x))) (x は殻の中の位置) で, 重みの和を1にする
+    // Each shell is shaped exp(4 - 1 / (x (1 - x))) (x being the position inside the shell); weights sum to 1
+    const int r = this->params.radius;
+    const int shells = (int)this->params.peaks.size();
+    const int ri = this->dim == 3 ? r : 0;
+    double total = 0;
+    for (int di = -ri; di <= ri; di++) {
+        for (int dj = -r; dj <= r; dj++) {
+            for (int dk = -r; dk <= r; dk++) {
+                const double distance = std::sqrt((double)di * di + dj * dj + dk * dk) / r;
+                if (distance >= 1) continue;
+                const double scaled = distance * shells;
+                const int shell = std::min((int)scaled, shells - 1);
+                const double x = scaled - shell;
+                if (x <= 0 || x >= 1) continue;
+                const double weight = this->params.peaks[shell] * std::exp(4 - 1 / (x * (1 - x)));
+                if (weight <= 0) continue;
+                this->taps.push_back({ di, dj, dk, (float)weight });
+                total += weight;
+            }
+        }
+    }
+    for (Tap& tap: this->taps) tap.weight = (float)(tap.weight / total);
+}
+
+void LeniaEngine::buildKernelSpectrum() {
+    // 核はずれの符号を反転して置き, 畳み込みが直接法と同じく sum w A(x + d) になるようにする
+    // The kernel is placed at negated offsets so the convolution is sum w A(x + d), as in the direct method
+    if (!this->kernel_spectrum.empty()) return;
+    const int n = this->length;
+    auto wrap = [n](int x) { return ((x % n) + n) % n; };
+    std::vector<float> kernel(this->cells.size(), 0.0f);
+    for (const Tap& tap: this->taps) {
+        kernel[this->index(this->dim == 3 ? wrap(-tap.di) : 0, wrap(-tap.dj), wrap(-tap.dk))] += tap.weight;
+    }
+    this->kernel_spectrum.resize(this->fft.spectrumSize());
+    this->spectrum.resize(this->fft.spectrumSize());
+    this->fft.forward(kernel.data(), this->kernel_spectrum.data(), *this->pool);
+}
+
+void LeniaEngine::convolveFft() {
+    this->buildKernelSpectrum();
+    this->fft.forward(this->cells.data(), this->spectrum.data(), *this->pool);
+    Fft::Complex* s = this->spectrum.data();
+    const Fft::Complex* ks = this->kernel_spectrum.data();
+    const int blocks = this->length;
+    const std::size_t block = (this->spectrum.size() + blocks - 1) / blocks;
+    auto multiply = [this, s, ks, block](int t, int) {
+        const std::size_t end = std::min(this->spectrum.size(), (t + 1) * block);
+        for (std::size_t x = t * block; x < end; x++) {
+            const Fft::Complex a = s[x];
+            const Fft::Complex b = ks[x];
+            s[x] = Fft::Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+        }
+    };
+    this->pool->parallelFor(blocks, multiply);
+    this->fft.inverse(this->spectrum.data(), this->potential.data(), *this->pool);
+}
+
+void LeniaEngine::convolveDirect(int row_begin, int row_end) {
+    const int n = this->length;
+    const int ni = this->dim == 3 ? n : 1;
+    auto task = [this, n, ni, row_begin](int t, int) {
+        const int row = row_begin + t;
+        const int i = row / n;
+        const int j = row % n;
+        float* out = &this->potential[this->index(i, j, 0)];
+        std::fill(out, out + n, 0.0f);
+        for (const Tap& tap: this->taps) {
+            const int si = ((i + tap.di) % ni + ni) % ni;
+            const int sj = ((j + tap.dj) % n + n) % n;
+            const int shift = (tap.dk % n + n) % n;
+            const float* src = &this->cells[this->index(si, sj, 0)];
+            const float w = tap.weight;
+            // 右へのずれを2つの連続区間に分けて, 内側のループをベクトル化させる
+            // Split the wrapped shift into two contiguous runs so the inner loops vectorize
+            for (int k = 0; k < n - shift; k++) out[k] += w * src[k + shift];
+            for (int k = n - shift; k < n; k++) out[k] += w * src[k + shift - n];
+        }
+    };
+    this->pool->parallelFor(row_end - row_begin, task);
+}
+
+void LeniaEngine::chooseMethod() {
+    using Clock = std::chrono::steady_clock;
+    const int rows = (this->dim == 3 ? this->length : 1) * this->length;
+    // 直接法は行ごとの手間が同じなので, スレッドごとに数行だけ測って全体を見積もる
+    // Every row costs the same with the direct method, so time a few rows per thread and extrapolate
+    const int sample = std::min(rows, 4 * this->pool->threadCount());
+    auto start = Clock::now();
+    this->convolveDirect(0, sample);
+    const double direct = std::chrono::duration<double>(Clock::now() - start).count() * rows / sample;
+    // 核のスペクトルは一度きりの準備なので測る前に作る
+    // The kernel spectrum is one-off setup, so it is built before the clock starts
+    this->buildKernelSpectrum();
+    start = Clock::now();
+    this->convolveFft();
+    const double fourier = std::chrono::duration<double>(Clock::now() - start).count();
+    this->chosen_method = direct < fourier ? ConvolutionMethod::Direct : ConvolutionMethod::Fft;
+}
+
+void LeniaEngine::progressField() {
+    const int n = this->length;
+    const int rows = (this->dim == 3 ? n : 1) * n;
+    if (this->chosen_method == ConvolutionMethod::Auto) this->chooseMethod();
+    else if (this->chosen_method == ConvolutionMethod::Fft) this->convolveFft();
+    else this->convolveDirect(0, rows);
+
+    const float mu = this->params.mu;
+    const float inv_two_sigma2 = 1.0f / (2 * this->params.sigma * this->params.sigma);
+    const float dt = this->params.dt;
+    auto grow = [this, n, mu, inv_two_sigma2, dt](int row, int) {
+        float* a = &this->cells[(std::size_t)row * n];
+        const float* u = &this->potential[(std::size_t)row * n];
+        for (int k = 0; k < n; k++) {
+            const float d = u[k] - mu;
+            const float growth = 2 * std::exp(-d * d * inv_two_sigma2) - 1;
+            a[k] = std::min(1.0f, std::max(0.0f, a[k] + dt * growth));
+        }
+    };
+    this->pool->parallelFor(rows, grow);
+    this->generation++;
+}
+
+void LeniaEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void LeniaEngine::randomize(int size, uint64_t seed) {
+    std::mt19937 eng((std::mt19937::result_type)seed);
+    std::uniform_real_distribution<float> distr(0, 1);
+    const int n = this->length;
+    const int lo = (n - std::min(size, n)) / 2;
+    const int hi = lo + std::min(size, n);
+    std::fill(this->cells.begin(), this->cells.end(), 0.0f);
+    const int ni = this->dim == 3 ? n : 1;
+    for (int i = 0; i < ni; i++) {
+        if (this->dim == 3 && (i < lo || i >= hi)) continue;
+        for (int j = lo; j < hi; j++) {
+            for (int k = lo; k < hi; k++) this->cells[this->index(i, j, k)] = distr(eng);
+        }
+    }
+}
+
+double LeniaEngine::getMass() const {
+    double mass = 0;
+    for (float value: this->cells) mass += value;
+    return mass;
+}
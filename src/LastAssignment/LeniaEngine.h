@@ -0,0 +1,109 @@
+#ifndef LENIA_ENGINE_H_
+#define LENIA_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Fft.h"
+#include "ThreadPool.h"
+
+// Lenia の設定. 半径 radius の球 (平面では円) の核で場を畳み込み, 成長関数
+// G(u) = 2 exp(-(u - mu)^2 / (2 sigma^2)) - 1 に dt を掛けて足し, [0, 1] に収める.
+// 核は半径方向に peaks.size() 個の殻を並べ, 各殻の高さが peaks
+// Lenia settings. The field is convolved with a kernel over a ball of the given radius (a disc when
+// planar), then dt times the growth G(u) = 2 exp(-(u - mu)^2 / (2 sigma^2)) - 1 is added and clamped to
+// [0, 1]. The kernel lines up peaks.size() shells along the radius, with the heights given by peaks
+struct LeniaParams
+{
+    int radius = 10;
+    float mu = 0.15f;
+    float sigma = 0.017f;
+    float dt = 0.1f;
+    std::vector<float> peaks = { 1.0f };
+};
+
+// 畳み込みの方法. Auto は最初の世代で両方の時間を測って速い方に決める
+// How the convolution is done. Auto times both on the first generation and settles on the faster one
+enum class ConvolutionMethod { Auto, Direct, Fft };
+
+// 連続値の場を進める Lenia のエンジン. 場はトーラスで, 畳み込みは核のスペクトルを一度だけ求めておく
+// 実数FFTか, 核の非零の要素を直接足す方法で行う
+// Lenia engine advancing a continuous field on a torus. The convolution goes either through a real
+// FFT against a kernel spectrum computed once, or directly over the non-zero kernel entries
+class LeniaEngine
+{
+private:
+    // 直接法の1要素. 中心からのずれと重み
+    // One entry of the direct method: offset from the center and weight
+    struct Tap
+    {
+        int di;
+        int dj;
+        int dk;
+        float weight;
+    };
+
+    int dim;
+    int length;
+    LeniaParams params;
+    long long generation;
+    std::vector<float> cells;
+    std::vector<float> potential;
+    std::vector<Tap> taps;
+    RealFft3D fft;
+    std::vector<Fft::Complex> spectrum;
+    std::vector<Fft::Complex> kernel_spectrum;
+    ConvolutionMethod method;
+    ConvolutionMethod chosen_method;
+    std::unique_ptr<ThreadPool> pool;
+
+    std::size_t index(int i, int j, int k) const {
+        return ((std::size_t)i * this->length + j) * this->length + k;
+    }
+    void buildKernel();
+    // 核のスペクトルを初めて要るときに一度だけ求める
+    // Computes the kernel spectrum once, the first time it is needed
+    void buildKernelSpectrum();
+    void convolveFft();
+    // 行 [row_begin, row_end) (平面と行を通した番号) だけを直接法で畳み込む
+    // Convolves only rows [row_begin, row_end) (numbered across planes) with the direct method
+    void convolveDirect(int row_begin, int row_end);
+    // Auto のとき, FFT を1回と直接法の一部の行を測って方法を決める. potential は FFT の結果になる
+    // For Auto, times one FFT and a few rows of the direct method to pick one. Leaves the FFT result in potential
+    void chooseMethod();
+
+public:
+    // dim は 2 (i = 0 の平面) か 3. 半径が1未満なら std::invalid_argument
+    // dim is 2 (the i = 0 plane) or 3. Throws std::invalid_argument if the radius is below 1
+    LeniaEngine(int dim, int length, const LeniaParams& params);
+
+    void progressField();
+    void progressField(int generations);
+
+    float get(int i, int j, int k) const { return this->cells[this->index(i, j, k)]; }
+    void set(int i, int j, int k, float value) { this->cells[this->index(i, j, k)] = value; }
+    // 中央の一辺 size の立方体 (平面では正方形) を一様乱数で埋め, 残りを0にする
+    // Fills a centered cube (a square when planar) of side size with uniform random values and zeroes the rest
+    void randomize(int size, uint64_t seed);
+    // 場の値の総和
+    // Sum of the field values
+    double getMass() const;
+
+    int getLength() const { return this->length; }
+    long long getGeneration() const { return this->generation; }
+    const LeniaParams& getParams() const { return this->params; }
+    // 直接法の核の要素数
+    // Number of kernel entries the direct method visits
+    std::size_t getKernelSize() const { return this->taps.size(); }
+
+    // Auto で決まった後は, 選ばれた方法を返す
+    // Once Auto has settled, returns the method it picked
+    ConvolutionMethod getConvolutionMethod() const { return this->chosen_method; }
+    void setConvolutionMethod(ConvolutionMethod method);
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count);
+};
+
+#endif // LENIA_ENGINE_H_
@@ -0,0 +1,150 @@
+#include "MortonEngine.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// std::min が参照で受け取るので定義を置く
+// std::min takes these by reference, so they need definitions
+const int MortonEngine::BRICK_PLANES;
+const int MortonEngine::BRICK_ROWS;
+const int MortonEngine::BRICK_CELLS_K;
+
+MortonEngine::MortonEngine(int length, const Rule& rule, bool isNeumannNeighborhood, bool isTorus)
+    : stepper(isNeumannNeighborhood ? Neighborhood::Neumann : Neighborhood::Moore) {
+    this->length = length;
+    this->rule = rule;
+    this->isTorus = isTorus;
+    this->generation = 0;
+    this->field = MortonField(length, length, length);
+    this->next_field = this->field;
+
+    const int last_cells = length - (length - 1) / BRICK_CELLS_K * BRICK_CELLS_K;
+    for (int w = 0; w < BRICK_WORDS; w++) {
+        const int bits = std::min(64, std::max(0, last_cells - 64 * w));
+        this->last_mask[w] = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        this->full_mask[w] = ~uint64_t(0);
+    }
+}
+
+int MortonEngine::wrap(int x) const {
+    if (x >= 0 && x < this->length) return x;
+    if (!this->isTorus) return -1;
+    return (x + this->length) % this->length;
+}
+
+void MortonEngine::stepBrick(std::size_t slot, int worker) {
+    const std::array<int, 3>& b = this->field.brickAt(slot);
+    const int i0 = b[0] * BRICK_PLANES;
+    const int j0 = b[1] * BRICK_ROWS;
+    const int k0 = b[2] * BRICK_CELLS_K;
+    // 場の端のブリックでは領域内の平面, 行, セルだけを進める
+    // Bricks at the edge of the field step only their in-field planes, rows and cells
+    const int planes = std::min(BRICK_PLANES, this->length - i0);
+    const int rows = std::min(BRICK_ROWS, this->length - j0);
+    const int cells = std::min(BRICK_CELLS_K, this->length - k0);
+    const int west = this->wrap(k0 - 1);
+    const int east = this->wrap(k0 + cells);
+
+    // 周りの平面と行は前, 中, 後の3通りのブリックにしか入らないので, ブリックの位置を先に27個引いておく
+    // Surrounding planes and rows fall into only three bricks each way (before, own, after), so look up the 27 bricks first
+    const int gi_of[3] = { this->wrap(i0 - 1), i0, this->wrap(i0 + planes) };
+    const int gj_of[3] = { this->wrap(j0 - 1), j0, this->wrap(j0 + rows) };
+    const int gk_of[3] = { west, k0, east };
+    const uint64_t* around[3][3][3];
+    for (int x = 0; x < 3; x++) {
+        for (int y = 0; y < 3; y++) {
+            for (int z = 0; z < 3; z++) {
+                const bool inside = gi_of[x] >= 0 && gj_of[y] >= 0 && gk_of[z] >= 0;
+                around[x][y][z] = inside ? this->field.brick(this->field.brickSlot(gi_of[x] / BRICK_PLANES,
+                    gj_of[y] / BRICK_ROWS, gk_of[z] / BRICK_CELLS_K)) : nullptr;
+            }
+        }
+    }
+
+    // 行の前後は k 方向の隣のセル1つだけが要る (西は上端ビット, 東は領域内の最後のセルの次のビット)
+    // Each row needs only the single neighboring cell along k on either side (west in the top bit,
+    // east in the bit after the last in-field cell)
+    const int west_word = west % BRICK_CELLS_K / 64;
+    const int east_word = east % BRICK_CELLS_K / 64;
+    const uint64_t* mask = cells == BRICK_CELLS_K ? this->full_mask : this->last_mask;
+    this->stepper.stepBrick(this->rule, planes, rows, mask, this->next_field.brick(slot), worker,
+        [&](int p, int r, int di, int dj, uint64_t* row) {
+            const uint64_t* const* bricks = around[di][dj];
+            if (bricks[1] == nullptr) {
+                std::fill(row - 1, row + BRICK_WORDS + 1, 0);
+                return;
+            }
+            const int gi = di == 1 ? i0 + p : gi_of[di];
+            const int gj = dj == 1 ? j0 + r : gj_of[dj];
+            const int offset = MortonField::rowInBrick(gi, gj);
+            for (int w = 0; w < BRICK_WORDS; w++) row[w] = bricks[1][offset + w];
+            row[-1] = 0;
+            row[BRICK_WORDS] = 0;
+            if (bricks[0] != nullptr && ((bricks[0][offset + west_word] >> (west % 64)) & 1)) {
+                row[-1] = uint64_t(1) << 63;
+            }
+            if (bricks[2] != nullptr && ((bricks[2][offset + east_word] >> (east % 64)) & 1)) {
+                row[cells / 64] |= uint64_t(1) << (cells % 64);
+            }
+        });
+}
+
+void MortonEngine::progressField() {
+    const std::size_t bricks = this->field.brickCount();
+    const int tasks = (int)((bricks + BRICKS_PER_TASK - 1) / BRICKS_PER_TASK);
+    auto task = [this, bricks](int t, int worker) {
+        const std::size_t end = std::min(bricks, (std::size_t)(t + 1) * BRICKS_PER_TASK);
+        for (std::size_t slot = (std::size_t)t * BRICKS_PER_TASK; slot < end; slot++) this->stepBrick(slot, worker);
+    };
+    this->stepper.getPool().parallelFor(tasks, task);
+    std::swap(this->field, this->next_field);
+    this->generation++;
+}
+
+void MortonEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+void MortonEngine::loadField(const FieldView& view) {
+    if (view.sizeI() != this->length || view.sizeJ() != this->length || view.sizeK() != this->length) {
+        throw std::invalid_argument("field size does not match the engine: " + std::to_string(view.sizeI()));
+    }
+    this->generation = view.generation();
+    if (view.layout() != FieldLayout::Flat) {
+        for (int i = 0; i < this->length; i++) {
+            for (int j = 0; j < this->length; j++) {
+                for (int k = 0; k < this->length; k++) this->field.set(i, j, k, view.at(i, j, k));
+            }
+        }
+        return;
+    }
+
+    // 行優先の場からは64セルずつ, ずれたビット位置をまたいで写す. 袖のビットはマスクで落とす
+    // From a row-major field copy 64 cells at a time across the shifted bit position; mask off the ghost bits
+    const int shift = view.bitOffset() % 64;
+    for (std::size_t slot = 0; slot < this->field.brickCount(); slot++) {
+        const std::array<int, 3>& b = this->field.brickAt(slot);
+        const uint64_t* mask = (b[2] + 1) * BRICK_CELLS_K >= this->length ? this->last_mask : this->full_mask;
+        uint64_t* brick = this->field.brick(slot);
+        for (int p = 0; p < BRICK_PLANES; p++) {
+            for (int r = 0; r < BRICK_ROWS; r++) {
+                const int i = b[0] * BRICK_PLANES + p;
+                const int j = b[1] * BRICK_ROWS + r;
+                uint64_t* dst = brick + MortonField::rowInBrick(i, j);
+                if (i >= this->length || j >= this->length) continue;
+                const uint64_t* src = view.words() + i * view.planeStride() + j * view.rowStride();
+                for (int w = 0; w < BRICK_WORDS; w++) {
+                    const int bit = view.bitOffset() + b[2] * BRICK_CELLS_K + 64 * w;
+                    if (mask[w] == 0) {
+                        dst[w] = 0;
+                        continue;
+                    }
+                    uint64_t x = src[bit / 64] >> shift;
+                    if (shift != 0) x |= src[bit / 64 + 1] << (64 - shift);
+                    dst[w] = x & mask[w];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef MORTON_ENGINE_H_
+#define MORTON_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "BrickStepper.h"
+#include "FieldView.h"
+#include "KernelDispatch.h"
+#include "MortonField.h"
+#include "Rule.h"
+
+// ブリックをZ順に並べた場 (MortonField) で3次元の世代を進めるエンジン. 各ブリックは BrickStepper が
+// 周り1セルごと局所バッファへ集め, 行優先の場と同じカーネル (StepTile) で進める. Z順に続くブリックを
+// まとめて1タスクにするので, 隣のブリックの多くはキャッシュに残っている
+// 3D engine stepping a field whose bricks are stored in Z order (MortonField). BrickStepper gathers
+// each brick with a one-cell border into a local buffer and steps it with the same kernel (StepTile)
+// as the row-major field. Tasks take runs of bricks consecutive in Z order, so most neighboring
+// bricks are still in cache
+class MortonEngine
+{
+private:
+    static const int BRICK_PLANES = MortonField::BRICK_PLANES;
+    static const int BRICK_ROWS = MortonField::BRICK_ROWS;
+    static const int BRICK_WORDS = MortonField::BRICK_WORDS;
+    static const int BRICK_CELLS_K = MortonField::BRICK_CELLS_K;
+    // 1タスクで進めるZ順に続くブリックの数
+    // Bricks, consecutive in Z order, stepped per task
+    static const int BRICKS_PER_TASK = 16;
+
+    int length;
+    Rule rule;
+    bool isTorus;
+    long long generation;
+    BrickStepper stepper;
+    MortonField field;
+    MortonField next_field;
+    // k方向の最後のブリックで領域内のビットだけが立った1行分のマスクと, 全部立ったマスク
+    // Row masks with only the in-field bits of the last brick along k set, and with every bit set
+    uint64_t last_mask[BRICK_WORDS];
+    uint64_t full_mask[BRICK_WORDS];
+
+    // 領域外の座標をトーラスなら折り返し, 有界なら -1 にする
+    // Wraps an out-of-field coordinate on a torus, or maps it to -1 when bounded
+    int wrap(int x) const;
+    void stepBrick(std::size_t slot, int worker);
+
+public:
+    MortonEngine(int length, const Rule& rule, bool isNeumannNeighborhood, bool isTorus);
+
+    void progressField();
+    void progressField(int generations);
+
+    bool get(int i, int j, int k) const { return this->field.get(i, j, k); }
+    void set(int i, int j, int k, bool alive) { this->field.set(i, j, k, alive); }
+    // FieldLayout::MortonBricks のビュー
+    // View in FieldLayout::MortonBricks
+    FieldView getFieldView() const { return this->field.view(this->generation); }
+    long long getGeneration() const { return this->generation; }
+    int getLength() const { return this->length; }
+
+    KernelIsa getKernelIsa() const { return this->stepper.getKernelIsa(); }
+    void setKernelIsa(KernelIsa isa) { this->stepper.setKernelIsa(isa); }
+    // 0 ならハードウェアのスレッド数
+    // 0 means the hardware thread count
+    void setThreadCount(int thread_count) { this->stepper.setThreadCount(thread_count); }
+
+    // 同じ大きさの場 (並べ方は問わない) のセルと世代番号を読み込む
+    // Loads the cells and generation of a field of the same size, in either layout
+    void loadField(const FieldView& field);
+};
+
+#endif // MORTON_ENGINE_H_
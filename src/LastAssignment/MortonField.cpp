@@ -0,0 +1,61 @@
+#include "MortonField.h"
+#include <algorithm>
+#include <utility>
+
+MortonField::MortonField() : MortonField(0, 0, 0) {}
+
+MortonField::MortonField(int ni, int nj, int nk) {
+    this->ni = ni;
+    this->nj = nj;
+    this->nk = nk;
+    this->bricks[0] = (ni + BRICK_PLANES - 1) / BRICK_PLANES;
+    this->bricks[1] = (nj + BRICK_ROWS - 1) / BRICK_ROWS;
+    this->bricks[2] = (nk + BRICK_CELLS_K - 1) / BRICK_CELLS_K;
+
+    // 各軸のビットを下位から k, j, i の順に交互に並べる. ビットを使い切った軸は飛ばす
+    // Interleave the bits of each axis from the bottom in k, j, i order, skipping axes that have run out of bits
+    int bits[3];
+    for (int a = 0; a < 3; a++) {
+        bits[a] = 0;
+        while ((1 << bits[a]) < this->bricks[a]) bits[a]++;
+        this->spread[a].assign(this->bricks[a], 0);
+    }
+    int code_bits = 0;
+    for (int b = 0; b < std::max(bits[0], std::max(bits[1], bits[2])); b++) {
+        for (int a = 2; a >= 0; a--) {
+            if (b >= bits[a]) continue;
+            for (int x = 0; x < this->bricks[a]; x++) {
+                if ((x >> b) & 1) this->spread[a][x] |= uint32_t(1) << code_bits;
+            }
+            code_bits++;
+        }
+    }
+
+    // 実在するブリックだけを符号の順に詰める
+    // Pack only the existing bricks, in code order
+    std::vector<std::pair<uint32_t, std::array<int, 3>>> codes;
+    for (int bi = 0; bi < this->bricks[0]; bi++) {
+        for (int bj = 0; bj < this->bricks[1]; bj++) {
+            for (int bk = 0; bk < this->bricks[2]; bk++) {
+                codes.push_back({ this->spread[0][bi] | this->spread[1][bj] | this->spread[2][bk], { bi, bj, bk } });
+            }
+        }
+    }
+    std::sort(codes.begin(), codes.end());
+    this->rank.assign(std::size_t(1) << code_bits, 0);
+    this->order.resize(codes.size());
+    for (std::size_t slot = 0; slot < codes.size(); slot++) {
+        this->rank[codes[slot].first] = (uint32_t)slot;
+        this->order[slot] = codes[slot].second;
+    }
+    this->words.assign(codes.size() * BRICK_SIZE, 0);
+}
+
+void MortonField::clear() {
+    std::fill(this->words.begin(), this->words.end(), 0);
+}
+
+FieldView MortonField::view(long long generation) const {
+    return FieldView(this->words.data(), this->ni, this->nj, this->nk, this->spread[0].data(),
+        this->spread[1].data(), this->spread[2].data(), this->rank.data(), generation);
+}
@@ -0,0 +1,82 @@
+#ifndef MORTON_FIELD_H_
+#define MORTON_FIELD_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitField.h"
+#include "FieldView.h"
+
+// 8平面 × 8行 × 4ワード (256セル) のブリックをZ順に並べた3次元のビット配列.
+// 行優先の配列では ±j, ±i の隣が1行, 1平面離れるが, ここでは隣のブリックの多くが近くに並ぶ.
+// 各軸のブリック数が2の冪でなくても, 実在するブリックだけを詰めて格納する.
+// 袖は持たず, 領域外のビットは常に0
+// 3D bit array of bricks of 8 planes x 8 rows x 4 words (256 cells) stored in Z order.
+// In a row-major array the +-j and +-i neighbors are a row and a plane away; here most
+// neighboring bricks sit close by. Only existing bricks are stored, even when the brick
+// counts per axis are not powers of two. There is no ghost layer; bits outside the field are always 0
+class MortonField
+{
+public:
+    static const int BRICK_PLANES = FieldView::BRICK_PLANES;
+    static const int BRICK_ROWS = FieldView::BRICK_ROWS;
+    static const int BRICK_WORDS = FieldView::BRICK_WORDS;
+    static const int BRICK_CELLS_K = FieldView::BRICK_CELLS_K;
+    static const int BRICK_SIZE = BRICK_PLANES * BRICK_ROWS * BRICK_WORDS;
+
+private:
+    int ni;
+    int nj;
+    int nk;
+    int bricks[3];
+    // 各軸のブリック座標をZ順の符号のビットへ散らす表と, 符号から格納順への表, 格納順からブリック座標への表
+    // Per-axis tables spreading brick coordinates into Z-order code bits, code-to-slot ranks, and slot-to-brick coordinates
+    std::vector<uint32_t> spread[3];
+    std::vector<uint32_t> rank;
+    std::vector<std::array<int, 3>> order;
+    std::vector<uint64_t, AlignedAllocator<uint64_t>> words;
+
+public:
+    MortonField();
+    MortonField(int ni, int nj, int nk);
+
+    int sizeI() const { return this->ni; }
+    int sizeJ() const { return this->nj; }
+    int sizeK() const { return this->nk; }
+    std::size_t brickCount() const { return this->order.size(); }
+
+    // ブリック (bi, bj, bk) の格納位置
+    // Storage slot of brick (bi, bj, bk)
+    std::size_t brickSlot(int bi, int bj, int bk) const {
+        return this->rank[this->spread[0][bi] | this->spread[1][bj] | this->spread[2][bk]];
+    }
+    // 格納位置 slot にあるブリックの座標 (bi, bj, bk). Z順に並ぶ
+    // Coordinates (bi, bj, bk) of the brick at a slot. Slots follow the Z order
+    const std::array<int, 3>& brickAt(std::size_t slot) const { return this->order[slot]; }
+    const uint64_t* brick(std::size_t slot) const { return this->words.data() + slot * BRICK_SIZE; }
+    uint64_t* brick(std::size_t slot) { return this->words.data() + slot * BRICK_SIZE; }
+    // ブリック内で (i, j) の行が始まるワード
+    // Word where row (i, j) starts inside its brick
+    static int rowInBrick(int i, int j) {
+        return ((i % BRICK_PLANES) * BRICK_ROWS + j % BRICK_ROWS) * BRICK_WORDS;
+    }
+
+    bool get(int i, int j, int k) const {
+        const uint64_t w = this->brick(this->brickSlot(i / BRICK_PLANES, j / BRICK_ROWS, k / BRICK_CELLS_K))
+            [rowInBrick(i, j) + k % BRICK_CELLS_K / 64];
+        return (w >> (k % 64)) & 1;
+    }
+    void set(int i, int j, int k, bool alive) {
+        uint64_t& w = this->brick(this->brickSlot(i / BRICK_PLANES, j / BRICK_ROWS, k / BRICK_CELLS_K))
+            [rowInBrick(i, j) + k % BRICK_CELLS_K / 64];
+        const uint64_t mask = uint64_t(1) << (k % 64);
+        if (alive) w |= mask;
+        else w &= ~mask;
+    }
+
+    void clear();
+    FieldView view(long long generation) const;
+};
+
+#endif // MORTON_FIELD_H_
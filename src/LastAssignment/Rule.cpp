@@ -0,0 +1,111 @@
+#include "Rule.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+uint32_t toMask(const std::vector<int>& counts) {
+    uint32_t mask = 0;
+    for (const int c: counts) {
+        if (c >= 0 && c <= Rule::MAX_COUNT) mask |= uint32_t(1) << c;
+    }
+    return mask;
+}
+
+// "4", "456" (1桁の列), "5,7,9", "4-6" を解釈する
+// Parses "4", "456" (a run of single digits), "5,7,9" and "4-6"
+uint32_t parseCounts(const std::string& notation, const std::string& part) {
+    uint32_t mask = 0;
+    const bool isList = part.find_first_of(",-") != std::string::npos;
+
+    if (!isList) {
+        for (const char ch: part) {
+            if (!std::isdigit((unsigned char)ch)) {
+                throw std::invalid_argument("invalid rule: " + notation);
+            }
+            mask |= uint32_t(1) << (ch - '0');
+        }
+        return mask;
+    }
+
+    std::size_t pos = 0;
+    while (pos <= part.size()) {
+        std::size_t end = part.find(',', pos);
+        if (end == std::string::npos) end = part.size();
+        const std::string item = part.substr(pos, end - pos);
+        const std::size_t dash = item.find('-');
+
+        try {
+            std::size_t used = 0;
+            const int lo = std::stoi(item.substr(0, dash), &used);
+            if (used != (dash == std::string::npos ? item.size() : dash)) throw std::invalid_argument(item);
+            int hi = lo;
+            if (dash != std::string::npos) {
+                hi = std::stoi(item.substr(dash + 1), &used);
+                if (used != item.size() - dash - 1) throw std::invalid_argument(item);
+            }
+            if (lo < 0 || hi > Rule::MAX_COUNT || lo > hi) throw std::invalid_argument(item);
+            for (int c = lo; c <= hi; c++) mask |= uint32_t(1) << c;
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument("invalid rule: " + notation);
+        }
+
+        pos = end + 1;
+    }
+    return mask;
+}
+
+}
+
+Rule::Rule() {
+    this->table = 0;
+}
+
+Rule::Rule(const std::vector<int>& birth_condition, const std::vector<int>& alive_condition) {
+    this->table = (uint64_t)toMask(birth_condition)
+        | ((uint64_t)toMask(alive_condition) << (MAX_COUNT + 1));
+}
+
+Rule Rule::parse(const std::string& notation) {
+    const std::size_t slash = notation.find('/');
+    if (slash == std::string::npos || notation.find('/', slash + 1) != std::string::npos) {
+        throw std::invalid_argument("invalid rule: " + notation);
+    }
+
+    uint32_t birth = 0;
+    uint32_t survival = 0;
+    bool hasBirth = false;
+    bool hasSurvival = false;
+    for (const std::string& part: { notation.substr(0, slash), notation.substr(slash + 1) }) {
+        if (part.empty()) throw std::invalid_argument("invalid rule: " + notation);
+        const char head = (char)std::toupper((unsigned char)part[0]);
+        if (head == 'B' && !hasBirth) {
+            birth = parseCounts(notation, part.substr(1));
+            hasBirth = true;
+        } else if (head == 'S' && !hasSurvival) {
+            survival = parseCounts(notation, part.substr(1));
+            hasSurvival = true;
+        } else {
+            throw std::invalid_argument("invalid rule: " + notation);
+        }
+    }
+
+    Rule rule;
+    rule.table = (uint64_t)birth | ((uint64_t)survival << (MAX_COUNT + 1));
+    return rule;
+}
+
+std::string Rule::toString() const {
+    std::string result;
+    for (const uint32_t mask: { this->birthMask(), this->survivalMask() }) {
+        result += result.empty() ? "B" : "/S";
+        bool first = true;
+        for (int c = 0; c <= MAX_COUNT; c++) {
+            if (!((mask >> c) & 1)) continue;
+            if (!first) result += ',';
+            result += std::to_string(c);
+            first = false;
+        }
+    }
+    return result;
+}
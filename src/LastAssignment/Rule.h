@@ -0,0 +1,34 @@
+#ifndef RULE_H_
+#define RULE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 誕生/生存条件を生存近傍数ごとのビットマスクにコンパイルしたもの
+// Birth/survival conditions compiled into bit masks indexed by live-neighbor count
+class Rule
+{
+private:
+    // 下位27ビットが誕生, 上位27ビットが生存
+    // Low 27 bits are birth, the next 27 bits are survival
+    uint64_t table;
+
+public:
+    static const int MAX_COUNT = 26;
+
+    Rule();
+    Rule(const std::vector<int>& birth_condition, const std::vector<int>& alive_condition);
+    // "B4/S2", "B5,7,9/S4-6" のような表記を解釈する. 不正な表記は std::invalid_argument
+    // Parses notations such as "B4/S2" or "B5,7,9/S4-6". Throws std::invalid_argument when malformed
+    static Rule parse(const std::string& notation);
+
+    bool isNextAlive(bool alive, int count_alive) const {
+        return (this->table >> (count_alive + (alive ? MAX_COUNT + 1 : 0))) & 1;
+    }
+    uint32_t birthMask() const { return (uint32_t)(this->table & 0x7FFFFFF); }
+    uint32_t survivalMask() const { return (uint32_t)(this->table >> (MAX_COUNT + 1)); }
+    std::string toString() const;
+};
+
+#endif // RULE_H_
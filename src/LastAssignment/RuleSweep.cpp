@@ -0,0 +1,182 @@
+#include "RuleSweep.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include "CAEngine.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// 最大の密度がこの値以上で, 初期から十分に増えたら爆発
+// Explodes when the peak density reaches at least this much and grew enough over the initial one
+const double EXPLODE_DENSITY = 0.1;
+// 最後の世代の活動度がこれ未満なら, 周期が見つからなくても安定とみなす
+// Below this activity over the final generations a run counts as stable even without a cycle
+const double QUIET_ACTIVITY = 1e-3;
+// 1セルあたりのエントロピーがこれ未満の場は規則的で, 変化していても混沌とはみなさない
+// Fields below this entropy per cell are ordered and do not count as chaotic even while changing
+const double ORDERED_ENTROPY = 0.05;
+
+// 2x2x2 (平面では 2x2) のブロックの出現頻度から求めた1セルあたりのエントロピー
+// Entropy per cell from the frequencies of 2x2x2 blocks (2x2 when planar)
+double blockEntropy(const CAEngineBase& engine, int dim, int length) {
+    const int half = length / 2;
+    if (half == 0) return 0;
+    std::array<uint64_t, 256> counts{};
+    const int bi_end = dim == 3 ? half : 1;
+    for (int bi = 0; bi < bi_end; bi++) {
+        for (int bj = 0; bj < half; bj++) {
+            for (int bk = 0; bk < half; bk++) {
+                int code = 0;
+                for (int di = 0; di < (dim == 3 ? 2 : 1); di++) {
+                    for (int dj = 0; dj < 2; dj++) {
+                        for (int dk = 0; dk < 2; dk++) {
+                            code = code << 1 | engine.get(dim == 3 ? 2 * bi + di : 0, 2 * bj + dj, 2 * bk + dk);
+                        }
+                    }
+                }
+                counts[code]++;
+            }
+        }
+    }
+    const double blocks = (double)bi_end * half * half;
+    double bits = 0;
+    for (uint64_t c: counts) {
+        if (c > 0) bits -= c / blocks * std::log2(c / blocks);
+    }
+    return bits / (dim == 3 ? 8 : 4);
+}
+
+// 掃引用の1スレッドのエンジン. 試行ごとに reset して使い回す
+// Single-threaded engine for the sweep, reset and reused from job to job
+std::unique_ptr<CAEngineBase> makeSweepEngine(const SweepSettings& settings) {
+    auto engine = makeCAEngine(settings.dim, settings.length, Rule(), settings.isNeumannNeighborhood,
+        settings.isTorus, EngineKind::Bitwise, 1);
+    engine->setStatsCollection(true);
+    engine->setCycleDetection(true);
+    engine->setCycleAction(CycleAction::Stop);
+    return engine;
+}
+
+SweepResult runJobOn(CAEngineBase* engine, const SweepJob& job, const SweepSettings& settings) {
+    const auto start = std::chrono::steady_clock::now();
+    const int dim = settings.dim;
+    const int n = settings.length;
+    const int ni = dim == 3 ? n : 1;
+    const double cells = (double)ni * n * n;
+
+    engine->reset(job.rule);
+
+    std::mt19937_64 eng(job.seed);
+    std::uniform_real_distribution<float> distr(0, 1);
+    for (int i = 0; i < ni; i++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) engine->set(i, j, k, distr(eng) < job.density);
+        }
+    }
+
+    SweepResult result;
+    result.job = job;
+    result.initial_population = engine->getGenerationStats().population;
+    result.peak_density = result.initial_population / cells;
+    // 最後の activity_window 世代の誕生数と死亡数の和を環状に持つ
+    // Births plus deaths of the last activity_window generations, kept in a ring
+    const int window = std::max(1, settings.activity_window);
+    std::vector<uint64_t> changes(window, 0);
+    uint64_t population = result.initial_population;
+    long long steps = 0;
+    while (steps < settings.generations && !engine->getCycle().found) {
+        engine->progressField();
+        const GenerationStats stats = engine->getGenerationStats();
+        population = stats.population;
+        changes[steps % window] = stats.births + stats.deaths;
+        result.peak_density = std::max(result.peak_density, population / cells);
+        steps++;
+    }
+
+    // 周期に入って止めた場合, 残りの世代も同じ活動を繰り返す
+    // When stopped in a cycle, the remaining generations repeat the same activity
+    const CycleInfo& cycle = engine->getCycle();
+    const long long counted = std::min<long long>(steps, window);
+    uint64_t changed = 0;
+    for (long long t = 0; t < counted; t++) changed += changes[t];
+    result.generations = steps;
+    result.final_population = population;
+    result.final_density = population / cells;
+    result.activity = counted > 0 ? changed / (counted * cells) : 0;
+    result.entropy = blockEntropy(*engine, dim, n);
+    result.period = cycle.found ? cycle.period : 0;
+    result.cycle_start = cycle.found ? cycle.start : 0;
+
+    // 増えたかどうかは最大の密度で見る. 初期の2倍, ただし空きセルの半分までを埋めれば十分なので,
+    // 初期密度が 0.5 以上でも爆発しうる. 最後にその増えた分の半分以上が残っていることも求めるので,
+    // 増えきってから止まった場は爆発に入り, 一時的に膨らんでから縮んだ場は入らない
+    // Growth is judged from the peak density: twice the initial one, but filling half of the empty cells
+    // is enough, so runs seeded at 0.5 or more can explode as well. At least half of that gain must remain at
+    // the end, so a field that grew and then froze explodes while one that swelled and shrank back does not
+    const double initial_density = result.initial_population / cells;
+    const double growth = std::min(initial_density, (1 - initial_density) / 2);
+    const bool grew = result.peak_density >= EXPLODE_DENSITY && result.peak_density >= initial_density + growth;
+    const bool kept = result.final_density - initial_density >= (result.peak_density - initial_density) / 2;
+    if (population == 0) result.behavior = Behavior::DiesOut;
+    else if (grew && kept) {
+        result.behavior = Behavior::Explodes;
+    } else if (cycle.found || result.activity < QUIET_ACTIVITY || result.entropy < ORDERED_ENTROPY) {
+        result.behavior = Behavior::Stabilizes;
+    } else {
+        result.behavior = Behavior::Chaotic;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+}
+
+const char* behaviorName(Behavior behavior) {
+    switch (behavior) {
+    case Behavior::DiesOut: return "dies_out";
+    case Behavior::Explodes: return "explodes";
+    case Behavior::Stabilizes: return "stabilizes";
+    default: return "chaotic";
+    }
+}
+
+SweepResult runSweepJob(const SweepJob& job, const SweepSettings& settings) {
+    return runJobOn(makeSweepEngine(settings).get(), job, settings);
+}
+
+std::vector<SweepResult> runSweep(const std::vector<SweepJob>& jobs, const SweepSettings& settings, int thread_count) {
+    if (thread_count <= 0) thread_count = (int)std::thread::hardware_concurrency();
+    if (thread_count <= 0) thread_count = 1;
+    std::vector<SweepResult> results(jobs.size());
+    // 試行ごとの手間は規則で大きく違うので, 空いたスレッドが盗む
+    // Work per run varies widely between rules, so idle threads steal
+    ThreadPool pool(thread_count);
+    pool.setSchedule(ThreadPool::Schedule::Stealing);
+    // ワーカーごとにエンジンを1つ作り, 試行の間で使い回す
+    // One engine per worker, reused across jobs
+    std::vector<std::unique_ptr<CAEngineBase>> engines(thread_count);
+    auto task = [&](int t, int worker) {
+        if (!engines[worker]) engines[worker] = makeSweepEngine(settings);
+        results[t] = runJobOn(engines[worker].get(), jobs[t], settings);
+    };
+    pool.parallelFor((int)jobs.size(), task);
+    return results;
+}
+
+void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "rule,density,seed,behavior,generations,initial_population,final_population,"
+        << "final_density,peak_density,activity,entropy,period,cycle_start,seconds\n";
+    for (const SweepResult& r: results) {
+        // 規則の表記はカンマを含むので引用符で囲む
+        // Rule notations contain commas, so they are quoted
+        out << '"' << r.job.rule.toString() << "\"," << r.job.density << ',' << r.job.seed << ','
+            << behaviorName(r.behavior) << ',' << r.generations << ',' << r.initial_population << ','
+            << r.final_population << ',' << r.final_density << ',' << r.peak_density << ',' << r.activity << ','
+            << r.entropy << ',' << r.period << ',' << r.cycle_start << ',' << r.seconds << '\n';
+    }
+}
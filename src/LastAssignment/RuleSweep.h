@@ -0,0 +1,67 @@
+#ifndef RULE_SWEEP_H_
+#define RULE_SWEEP_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "Rule.h"
+
+// 1回の試行の振る舞い. 死滅, 爆発 (個体数が大きく増える. その後に止まっても), 安定 (周期に入るか,
+// ほとんど変化しないか, 規則的な場), どれでもなく変化し続けるもの
+// Behavior of one run: dies out, explodes (the population grows a lot, even if it freezes afterwards),
+// stabilizes (enters a cycle, barely changes or is ordered), or none of these and keeps changing
+enum class Behavior { DiesOut, Explodes, Stabilizes, Chaotic };
+
+const char* behaviorName(Behavior behavior);
+
+struct SweepJob
+{
+    Rule rule;
+    float density;
+    uint64_t seed;
+};
+
+// すべての試行に共通の設定. activity_window は活動度を平均する最後の世代数
+// Settings shared by every run. activity_window is the number of final generations the activity averages over
+struct SweepSettings
+{
+    int dim = 3;
+    int length = 32;
+    int generations = 300;
+    bool isNeumannNeighborhood = false;
+    bool isTorus = true;
+    int activity_window = 32;
+};
+
+// 密度はセルあたりの個体数, 活動度は1世代1セルあたりの誕生数と死亡数の和.
+// エントロピーは 2x2x2 (平面では 2x2) のブロックの出現頻度から求めた1セルあたりのビット数で,
+// 圧縮しやすい (規則的な) 場ほど小さい. 周期が見つからなければ period は0
+// Densities are live cells per cell; activity is births plus deaths per cell per generation.
+// Entropy is bits per cell from the frequencies of 2x2x2 blocks (2x2 when planar), lower for more
+// compressible (ordered) fields. period is 0 when no cycle was found
+struct SweepResult
+{
+    SweepJob job;
+    Behavior behavior;
+    long long generations;
+    uint64_t initial_population;
+    uint64_t final_population;
+    double final_density;
+    double peak_density;
+    double activity;
+    double entropy;
+    long long period;
+    long long cycle_start;
+    double seconds;
+};
+
+// 1つの試行を1スレッドで進めて分類する. 周期が見つかればそこで止める
+// Runs and classifies one job on one thread, stopping early once a cycle is found
+SweepResult runSweepJob(const SweepJob& job, const SweepSettings& settings);
+// 試行をスレッドプールで並べて進める. 結果は jobs と同じ順. thread_count が0ならハードウェアのスレッド数
+// Runs the jobs side by side on a thread pool. Results come in the order of jobs.
+// thread_count 0 means the hardware thread count
+std::vector<SweepResult> runSweep(const std::vector<SweepJob>& jobs, const SweepSettings& settings, int thread_count);
+void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results);
+
+#endif // RULE_SWEEP_H_
@@ -0,0 +1,105 @@
+#include "SparseEngine.h"
+#include <stdexcept>
+#include <utility>
+
+SparseEngine::SparseEngine(int dim, int length, const Rule& rule, bool isNeumannNeighborhood, bool isTorus) {
+    if (rule.birthMask() & 1) {
+        throw std::invalid_argument("sparse engine cannot run rules with birth on zero neighbors: " + rule.toString());
+    }
+    if (length < 1 || length > (1 << AXIS_BITS)) {
+        throw std::invalid_argument("sparse engine length out of range: " + std::to_string(length));
+    }
+    this->dim = dim;
+    this->length = length;
+    this->rule = rule;
+    this->isNeumannNeighborhood = isNeumannNeighborhood;
+    this->isTorus = isTorus;
+    this->generation = 0;
+
+    for (int di = (dim == 3 ? -1 : 0); di <= (dim == 3 ? 1 : 0); di++) {
+        for (int dj = -1; dj <= 1; dj++) {
+            for (int dk = -1; dk <= 1; dk++) {
+                const int distance = (di != 0) + (dj != 0) + (dk != 0);
+                if (distance == 0 || (isNeumannNeighborhood && distance > 1)) continue;
+                this->offsets.push_back({ di, dj, dk });
+            }
+        }
+    }
+}
+
+void SparseEngine::checkCell(int i, int j, int k) const {
+    const int ni = this->dim == 3 ? this->length : 1;
+    if (i < 0 || i >= ni || j < 0 || j >= this->length || k < 0 || k >= this->length) {
+        throw std::invalid_argument("sparse engine coordinate out of range: (" + std::to_string(i) + ", "
+            + std::to_string(j) + ", " + std::to_string(k) + ")");
+    }
+}
+
+bool SparseEngine::get(int i, int j, int k) const {
+    this->checkCell(i, j, k);
+    return this->live.contains(pack(i, j, k));
+}
+
+void SparseEngine::set(int i, int j, int k, bool alive) {
+    this->checkCell(i, j, k);
+    if (alive) this->live[pack(i, j, k)] = 1;
+    else this->live.erase(pack(i, j, k));
+}
+
+void SparseEngine::progressField() {
+    const int n = this->length;
+    auto wrap = [this, n](int x) { return this->isTorus ? (x + n) % n : x; };
+
+    // 生きたセルから近傍へ数をばらまく. 小さなトーラスで同じセルに重なるずれも, ビット版と同じく重ねて数える
+    // Scatter counts from every live cell to its neighbors. Offsets that land on the same cell of a
+    // small torus are counted each time, as the bitwise engine does
+    // clear は表を直前の要素数に合わせて縮めるので, 下のスロット単位の走査は集団の大きさに比例する
+    // clear shrinks each table to its previous entry count, so the slot-wise scans below scale with the population
+    this->counts.clear();
+    for (std::size_t s = 0; s < this->live.capacity(); s++) {
+        const uint64_t key = this->live.keyAt(s);
+        if (key == CellTable::emptyKey()) continue;
+        const int i = unpack(key, 0);
+        const int j = unpack(key, 1);
+        const int k = unpack(key, 2);
+        for (const auto& o: this->offsets) {
+            const int ii = wrap(i + o[0]);
+            const int jj = wrap(j + o[1]);
+            const int kk = wrap(k + o[2]);
+            if (ii < 0 || ii >= n || jj < 0 || jj >= n || kk < 0 || kk >= n) continue;
+            this->counts[pack(ii, jj, kk)]++;
+        }
+    }
+
+    // 数が付いたセルだけが誕生または生存できる. 0近傍での生存だけは生きたセル側から拾う
+    // Only counted cells can be born or survive, except survival on zero neighbors, which is picked up from the live cells
+    this->next_live.clear();
+    for (std::size_t s = 0; s < this->counts.capacity(); s++) {
+        const uint64_t key = this->counts.keyAt(s);
+        if (key == CellTable::emptyKey()) continue;
+        if (this->rule.isNextAlive(this->live.contains(key), this->counts.valueAt(s))) this->next_live[key] = 1;
+    }
+    if (this->rule.survivalMask() & 1) {
+        for (std::size_t s = 0; s < this->live.capacity(); s++) {
+            const uint64_t key = this->live.keyAt(s);
+            if (key != CellTable::emptyKey() && !this->counts.contains(key)) this->next_live[key] = 1;
+        }
+    }
+
+    std::swap(this->live, this->next_live);
+    this->generation++;
+}
+
+void SparseEngine::progressField(int generations) {
+    for (int t = 0; t < generations; t++) this->progressField();
+}
+
+std::vector<std::array<int, 3>> SparseEngine::getLiveCells() const {
+    std::vector<std::array<int, 3>> cells;
+    cells.reserve(this->live.size());
+    for (std::size_t s = 0; s < this->live.capacity(); s++) {
+        const uint64_t key = this->live.keyAt(s);
+        if (key != CellTable::emptyKey()) cells.push_back({ unpack(key, 0), unpack(key, 1), unpack(key, 2) });
+    }
+    return cells;
+}
@@ -0,0 +1,67 @@
+#ifndef SPARSE_ENGINE_H_
+#define SPARSE_ENGINE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CellTable.h"
+#include "Rule.h"
+
+// 生きたセルだけをハッシュ集合に持つエンジン. メモリと時間は場の大きさではなく個体数に比例するので,
+// 1辺 2^21 までの大部分が空の場を扱える. 0近傍で誕生する規則は場全体が埋まるので扱わない
+// Engine that stores only the live cells in a hash set. Memory and time scale with the population
+// rather than the field size, so mostly empty fields up to 2^21 cells per side fit.
+// Rules with birth on zero neighbors would fill the whole field and are rejected
+class SparseEngine
+{
+private:
+    static const int AXIS_BITS = 21;
+
+    int dim;
+    int length;
+    Rule rule;
+    bool isNeumannNeighborhood;
+    bool isTorus;
+    long long generation;
+    std::vector<std::array<int, 3>> offsets;
+    CellTable live;
+    CellTable next_live;
+    // 生きたセルから近傍へばらまいた生存近傍数
+    // Live-neighbor counts scattered from the live cells
+    CellTable counts;
+
+    static uint64_t pack(int i, int j, int k) {
+        return ((uint64_t)i << (2 * AXIS_BITS)) | ((uint64_t)j << AXIS_BITS) | (uint64_t)k;
+    }
+    static int unpack(uint64_t key, int axis) {
+        return (int)((key >> ((2 - axis) * AXIS_BITS)) & ((uint64_t(1) << AXIS_BITS) - 1));
+    }
+    // 場の外の座標は詰めると別のセル (負なら空きの印) と重なるので std::invalid_argument
+    // Coordinates outside the field would pack onto another cell (or the empty marker when negative),
+    // so they throw std::invalid_argument
+    void checkCell(int i, int j, int k) const;
+
+public:
+    // dim は 2 (i = 0 の平面) か 3. 規則が0近傍での誕生を含むか, length が 2^21 を超えると std::invalid_argument
+    // dim is 2 (the i = 0 plane) or 3. Throws std::invalid_argument for birth on zero neighbors
+    // or a length above 2^21
+    SparseEngine(int dim, int length, const Rule& rule, bool isNeumannNeighborhood, bool isTorus);
+
+    void progressField();
+    void progressField(int generations);
+
+    // 座標は [0, length) で, 2次元では i = 0. 外れると std::invalid_argument
+    // Coordinates lie in [0, length), with i = 0 in 2D; anything else throws std::invalid_argument
+    bool get(int i, int j, int k) const;
+    void set(int i, int j, int k, bool alive);
+    std::size_t getPopulation() const { return this->live.size(); }
+    long long getGeneration() const { return this->generation; }
+    int getLength() const { return this->length; }
+    const Rule& getRule() const { return this->rule; }
+    // 生きたセルの座標 (順不同)
+    // Coordinates of the live cells, in no particular order
+    std::vector<std::array<int, 3>> getLiveCells() const;
+};
+
+#endif // SPARSE_ENGINE_H_
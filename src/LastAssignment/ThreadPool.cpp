@@ -0,0 +1,190 @@
+#include "ThreadPool.h"
+#include <chrono>
+
+namespace {
+
+uint64_t packRange(int begin, int end) {
+    return ((uint64_t)(uint32_t)begin << 32) | (uint32_t)end;
+}
+int rangeBegin(uint64_t range) { return (int)(range >> 32); }
+int rangeEnd(uint64_t range) { return (int)(uint32_t)range; }
+
+}
+
+ThreadPool::ThreadPool(int thread_count) {
+    this->thread_count = thread_count < 1 ? 1 : thread_count;
+    this->schedule = Schedule::Stealing;
+    this->last_imbalance = 1.0;
+    this->slots.reset(new WorkerSlot[this->thread_count]);
+    this->epoch = 0;
+    this->running = 0;
+    this->stopping = false;
+    this->fn = nullptr;
+    this->context = nullptr;
+
+    for (int w = 1; w < this->thread_count; w++) {
+        this->threads.emplace_back(&ThreadPool::workerLoop, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->start_cv.notify_all();
+    for (auto& t: this->threads) t.join();
+}
+
+void ThreadPool::run(int task_count, TaskFn fn, void* context, const double* task_cost) {
+    if (task_count <= 0) return;
+    this->fn = fn;
+    this->context = context;
+
+    if (this->threads.empty()) {
+        this->slots[0].range.store(packRange(0, task_count), std::memory_order_relaxed);
+        this->drain(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->assignRanges(task_count, task_cost);
+        this->running = (int)this->threads.size();
+        this->epoch++;
+    }
+    this->start_cv.notify_all();
+
+    this->drain(0);
+
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done_cv.wait(lock, [this] { return this->running == 0; });
+    }
+
+    long long max_ns = 0;
+    long long total_ns = 0;
+    for (int w = 0; w < this->thread_count; w++) {
+        if (this->slots[w].run_ns > max_ns) max_ns = this->slots[w].run_ns;
+        total_ns += this->slots[w].run_ns;
+    }
+    this->last_imbalance = total_ns > 0 ? (double)max_ns * this->thread_count / total_ns : 1.0;
+}
+
+void ThreadPool::assignRanges(int task_count, const double* task_cost) {
+    const int n = this->thread_count;
+    if (this->schedule == Schedule::Static || task_cost == nullptr) {
+        for (int w = 0; w < n; w++) {
+            const int begin = (int)((long long)task_count * w / n);
+            const int end = (int)((long long)task_count * (w + 1) / n);
+            this->slots[w].range.store(packRange(begin, end), std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // 見積もりコストの累積が total * (w + 1) / n を超えたところで区切る
+    // Cut where the running cost estimate passes total * (w + 1) / n
+    double total = 0;
+    for (int t = 0; t < task_count; t++) total += task_cost[t];
+    int begin = 0;
+    double acc = 0;
+    for (int w = 0; w < n; w++) {
+        int end = begin;
+        const double target = total * (w + 1) / n;
+        while (end < task_count && (w == n - 1 || acc + task_cost[end] * 0.5 <= target)) {
+            acc += task_cost[end];
+            end++;
+        }
+        this->slots[w].range.store(packRange(begin, end), std::memory_order_relaxed);
+        begin = end;
+    }
+}
+
+int ThreadPool::popLocal(int worker) {
+    std::atomic<uint64_t>& range = this->slots[worker].range;
+    uint64_t r = range.load(std::memory_order_acquire);
+    for (;;) {
+        const int begin = rangeBegin(r);
+        const int end = rangeEnd(r);
+        if (begin >= end) return -1;
+        if (range.compare_exchange_weak(r, packRange(begin + 1, end), std::memory_order_acq_rel)) return begin;
+    }
+}
+
+int ThreadPool::steal(int worker) {
+    // 残りが最も多いワーカーから後ろ半分を取り, 先頭を実行して残りを自分の区間にする
+    // Take the back half from the worker with the most left, run its first task and keep the rest
+    for (;;) {
+        int victim = -1;
+        int most = 0;
+        uint64_t r = 0;
+        for (int v = 0; v < this->thread_count; v++) {
+            if (v == worker) continue;
+            const uint64_t vr = this->slots[v].range.load(std::memory_order_acquire);
+            const int left = rangeEnd(vr) - rangeBegin(vr);
+            if (left > most) {
+                most = left;
+                victim = v;
+                r = vr;
+            }
+        }
+        if (victim < 0) return -1;
+
+        const int begin = rangeBegin(r);
+        const int end = rangeEnd(r);
+        const int split = end - (end - begin + 1) / 2;
+        if (this->slots[victim].range.compare_exchange_strong(r, packRange(begin, split), std::memory_order_acq_rel)) {
+            this->slots[worker].range.store(packRange(split + 1, end), std::memory_order_release);
+            return split;
+        }
+    }
+}
+
+void ThreadPool::drain(int worker) {
+    const auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        int task = this->popLocal(worker);
+        if (task < 0 && this->schedule == Schedule::Stealing) task = this->steal(worker);
+        if (task < 0) break;
+        this->fn(this->context, task, worker);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    this->slots[worker].run_ns = ns;
+    this->slots[worker].busy_ns += ns;
+}
+
+void ThreadPool::workerLoop(int worker) {
+    long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->start_cv.wait(lock, [&] { return this->stopping || this->epoch != seen; });
+            if (this->stopping) return;
+            seen = this->epoch;
+        }
+
+        this->drain(worker);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            last = --this->running == 0;
+        }
+        if (last) this->done_cv.notify_one();
+    }
+}
+
+std::vector<double> ThreadPool::busySeconds() const {
+    std::vector<double> seconds(this->thread_count);
+    for (int w = 0; w < this->thread_count; w++) {
+        seconds[w] = this->slots[w].busy_ns * 1e-9;
+    }
+    return seconds;
+}
+
+void ThreadPool::resetBusyTime() {
+    for (int w = 0; w < this->thread_count; w++) {
+        this->slots[w].busy_ns = 0;
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 世代ごとに使い回すスレッドプール. 呼び出し元のスレッドもワーカー0として働く
+// Thread pool reused across generations. The calling thread works as worker 0
+class ThreadPool
+{
+public:
+    using TaskFn = void (*)(void* context, int task, int worker);
+
+    // Static: タスクを個数で等分した連続区間を各ワーカーが処理するだけ
+    // Stealing: コストで等分した区間から始め, 空いたワーカーが他の区間の後ろ半分を盗む
+    // Static: each worker runs one contiguous range holding an equal number of tasks.
+    // Stealing: ranges start split by cost, and idle workers steal the back half of another range
+    enum class Schedule { Static, Stealing };
+
+    // thread_count は呼び出し元を含むスレッド数. 1 ならスレッドを作らない
+    // thread_count includes the caller. No threads are created for 1
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threadCount() const { return this->thread_count; }
+    Schedule getSchedule() const { return this->schedule; }
+    void setSchedule(Schedule schedule) { this->schedule = schedule; }
+
+    // タスク 0..task_count-1 をすべて終えるまで戻らない. ヒープ確保は行わない.
+    // task_cost があれば Stealing の初期区間をその見積もりで等分する
+    // Returns once tasks 0..task_count-1 have all finished. Performs no heap allocation.
+    // When task_cost is given, Stealing splits the initial ranges evenly by that estimate
+    void run(int task_count, TaskFn fn, void* context, const double* task_cost = nullptr);
+
+    // f(task, worker) を呼ぶ run の便利版
+    // Convenience form of run that calls f(task, worker)
+    template <typename F>
+    void parallelFor(int task_count, F& f, const double* task_cost = nullptr) {
+        this->run(task_count, [](void* context, int task, int worker) {
+            (*static_cast<F*>(context))(task, worker);
+        }, &f, task_cost);
+    }
+
+    // 各ワーカーがタスクを実行していた累計秒数
+    // Accumulated seconds each worker spent running tasks
+    std::vector<double> busySeconds() const;
+    void resetBusyTime();
+    // 直前の run での最大実行時間 / 平均実行時間. 1 なら完全に均等
+    // Max over mean worker busy time in the last run. 1 means perfectly even
+    double lastImbalance() const { return this->last_imbalance; }
+
+private:
+    // ワーカーごとの状態. 偽共有を避けるためキャッシュライン単位に置く.
+    // range は残りのタスク区間 [begin, end) を上位/下位32ビットに詰めたもので,
+    // 持ち主は先頭から取り, 盗む側は後ろから取る両端キューとして使う
+    // Per-worker state, one cache line each to avoid false sharing.
+    // range packs the remaining task range [begin, end) into the high and low 32 bits and
+    // serves as a deque: the owner takes from the front, thieves take from the back
+    struct alignas(64) WorkerSlot
+    {
+        std::atomic<uint64_t> range{0};
+        long long busy_ns = 0;
+        long long run_ns = 0;
+    };
+
+    int thread_count;
+    Schedule schedule;
+    double last_imbalance;
+    std::vector<std::thread> threads;
+    std::unique_ptr<WorkerSlot[]> slots;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    long long epoch;
+    int running;
+    bool stopping;
+
+    TaskFn fn;
+    void* context;
+
+    void workerLoop(int worker);
+    void assignRanges(int task_count, const double* task_cost);
+    void drain(int worker);
+    int popLocal(int worker);
+    int steal(int worker);
+};
+
+#endif // THREAD_POOL_H_
@@ -0,0 +1,58 @@
+// 行優先の場 (CA) とZ順のブリック配置 (MortonEngine) の1世代あたりの時間を比べる.
+// 引数は1辺の長さの並び (既定は 256 1024)
+// Compares the time per generation of the row-major field (CA) and the Z-ordered brick layout
+// (MortonEngine). Arguments are side lengths (256 1024 by default)
+#include "CA.h"
+#include "MortonEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* const RULE = "B6/S5,6,7";
+
+template <typename F>
+double millisecondsPerGeneration(int generations, F step) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < generations; t++) step();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / generations;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> lengths;
+    for (int a = 1; a < argc; a++) lengths.push_back(std::atoi(argv[a]));
+    if (lengths.empty()) lengths = { 256, 1024 };
+
+    for (int length: lengths) {
+        const int generations = length >= 1024 ? 3 : 20;
+        CA flat = CA(length, RULE, 0.1, false, true);
+        // ブリック飛ばしは配置と関係ないので切る
+        // Brick skipping is unrelated to the layout, so turn it off
+        flat.setBrickSkipping(false);
+        MortonEngine morton(length, Rule::parse(RULE), false, true);
+        morton.loadField(flat.getFieldView());
+
+        const double flat_ms = millisecondsPerGeneration(generations, [&]() { flat.progressField(); });
+        const double morton_ms = millisecondsPerGeneration(generations, [&]() { morton.progressField(); });
+
+        // 全セルを比べると大きな場では遅いので, 無作為に選んだセルで一致を確かめる
+        // Comparing every cell is slow on large fields, so check agreement on randomly chosen cells
+        const FieldView a = flat.getFieldView();
+        const FieldView b = morton.getFieldView();
+        std::mt19937 eng(length);
+        bool match = true;
+        for (int n = 0; n < 1000000; n++) {
+            const int i = eng() % length, j = eng() % length, k = eng() % length;
+            if (a.at(i, j, k) != b.at(i, j, k)) match = false;
+        }
+
+        std::cout << length << "^3  flat " << flat_ms << " ms/gen  morton " << morton_ms << " ms/gen  ("
+            << kernelIsaName(morton.getKernelIsa()) << ", " << flat.getThreadCount() << " threads, "
+            << (match ? "fields match" : "FIELDS DIFFER") << ")\n";
+    }
+}
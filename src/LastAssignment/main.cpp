@@ -6,6 +6,7 @@
 #include <vector>
 #include <algorithm>
 #include <cstdlib>
+#include <memory>
 
 #include <glad/gl.h>
 #include "shaders.h"
@@ -24,6 +25,8 @@
 
 #include "common.h"
 #include "CA.h"
+#include "GenerationsEngine.h"
+#include "LeniaEngine.h"
 
 static const int LENGTH = 50;
 
@@ -161,9 +164,10 @@ void initializeGL(GLuint& programId, GLFWwindow* window) {
     programId = initShaders();
 }
 
-// ユーザ定義のOpenGL描画
-// User-defined OpenGL drawing
-void paintGL(GLuint programId, GLFWwindow* window, CA& ca) {
+// ユーザ定義のOpenGL描画. shade(i, j, k) はセルの明るさで, 0 なら描かない
+// User-defined OpenGL drawing. shade(i, j, k) is the brightness of a cell; cells at 0 are not drawn
+template <typename Shade>
+void paintGL(GLuint programId, GLFWwindow* window, Shade shade) {
     // 背景色と深度値のクリア
     // Clear background color and depth values
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -182,19 +186,20 @@ void paintGL(GLuint programId, GLFWwindow* window, CA& ca) {
     // Transfer uniform variables
     GLuint mvpMatLocId = glGetUniformLocation(programId, "u_mvpMat");
     glUniformMatrix4fv(mvpMatLocId, 1, GL_FALSE, glm::value_ptr(mvpMat));
+    GLuint shadeLocId = glGetUniformLocation(programId, "u_shade");
 
     // VAOの有効化
     // Enable VAO
     glBindVertexArray(vaoId);
 
-    auto&& field = ca.getField();
-
     // 三角形の描画
     // Draw triangles
     for(int i = 0; i < LENGTH; i++) {
         for(int j = 0; j < LENGTH; j++) {
             for(int k = 0; k < LENGTH; k++) {
-                if(field[i][j][k]) {
+                const float brightness = shade(i, j, k);
+                if(brightness > 0.0f) {
+                    glUniform1f(shadeLocId, brightness);
                     glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 
                             (void*)(((i * LENGTH * LENGTH) + (j * LENGTH) + k) * sizeof(GLuint) * 36));
                 }
@@ -295,9 +300,46 @@ int main(int argc, char **argv) {
     // std::vector<int> alive_condition{4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26};
     // CA ca = CA(LENGTH, birth_condition, alive_condition, 0.05, false, false);
 
+    // 描く場. Generations は減衰中のセルを暗く, Lenia は値をそのまま明るさにして描く
+    // Which field to draw. Generations draws decaying cells darker; Lenia uses the values as brightness
+    enum class Shown { Binary, Generations, Lenia };
+    const Shown shown = Shown::Binary;
+    // 使わない場は作らない
+    // Fields that are not shown are never built
+    std::unique_ptr<GenerationsEngine> generations;
+    if (shown == Shown::Generations) {
+        generations = std::make_unique<GenerationsEngine>(3, LENGTH, GenerationsRule::parse("B4/S2/C6"), false, false);
+        generations->randomize(0.01f, 1);
+    }
+    std::unique_ptr<LeniaEngine> lenia;
+    if (shown == Shown::Lenia) {
+        lenia = std::make_unique<LeniaEngine>(3, LENGTH, LeniaParams());
+        lenia->randomize(LENGTH / 2, 1);
+    }
+
     while (glfwWindowShouldClose(window) == GLFW_FALSE) {
-        paintGL(programId, window, ca);
-        ca.progressField();
+        if (shown == Shown::Lenia) {
+            // 薄いセルまで描くと中が見えないので, 0.1 未満は描かない
+            // Drawing faint cells hides the inside, so values below 0.1 are skipped
+            paintGL(programId, window, [&](int i, int j, int k) {
+                const float value = lenia->get(i, j, k);
+                return value < 0.1f ? 0.0f : value;
+            });
+            lenia->progressField();
+        } else if (shown == Shown::Generations) {
+            // 生きたセルは明るさ1, 減衰中のセルは状態が進むほど暗くする
+            // Live cells have brightness 1; decaying cells get darker as their state advances
+            const int states = generations->getRule().states;
+            paintGL(programId, window, [&](int i, int j, int k) {
+                const int state = generations->getState(i, j, k);
+                return state == 0 ? 0.0f : 1.0f - 0.8f * (state - 1) / (states - 1);
+            });
+            generations->progressField();
+        } else {
+            const FieldView field = ca.getFieldView();
+            paintGL(programId, window, [&](int i, int j, int k) { return field.at(i, j, k) ? 1.0f : 0.0f; });
+            ca.progressField();
+        }
 
         // 描画用バッファの切り替え
         // Swap drawing target buffers
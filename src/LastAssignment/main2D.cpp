@@ -178,18 +178,20 @@ void paintGL(GLuint programId, GLFWwindow* window, CA2D& ca) {
     // Transfer uniform variables
     GLuint mvpMatLocId = glGetUniformLocation(programId, "u_mvpMat");
     glUniformMatrix4fv(mvpMatLocId, 1, GL_FALSE, glm::value_ptr(mvpMat));
+    GLuint shadeLocId = glGetUniformLocation(programId, "u_shade");
+    glUniform1f(shadeLocId, 1.0f);
 
     // VAOの有効化
     // Enable VAO
     glBindVertexArray(vaoId);
 
-    auto&& field = ca.getField();
+    const FieldView field = ca.getFieldView();
 
     // 三角形の描画
     // Draw triangles
     for(int i = 0; i < LENGTH; i++) {
         for(int j = 0; j < LENGTH; j++) {
-            if(field[i][j]) {
+            if(field.at(i, j)) {
                 glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 
                         (void*)(((i * LENGTH) + j) * sizeof(GLuint) * 36));
             }
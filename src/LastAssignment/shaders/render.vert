@@ -9,6 +9,8 @@ out vec3 f_fragColor;
 
 // Uniform変数
 uniform mat4 u_mvpMat;
+// セルの明るさ (Generations の減衰状態を暗く描く)
+uniform float u_shade;
 
 void main() {
     // gl_Positionは頂点シェーダの組み込み変数
@@ -16,5 +18,5 @@ void main() {
     gl_Position = u_mvpMat * vec4(in_position, 1.0);
 
     // Varying変数への代入
-    f_fragColor = in_color;
+    f_fragColor = in_color * u_shade;
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+// 規則と初期密度の組を画面なしで並列に回し, 振る舞いを分類して CSV に書く.
+// 使い方: sweep_rules [オプション] [規則 ...]
+//   --rules FILE         1行1規則のファイル (# 以降は注釈)
+//   --random N           3次元 Moore 近傍向けの無作為な規則を N 個足す (--rule-seed で種)
+//   --densities A,B,..   初期密度 (既定 0.05,0.1,0.3)
+//   --seeds N            密度ごとの種の数 (既定 4)
+//   --length N           1辺の長さ (既定 32)
+//   --generations N      最大の世代数 (既定 300)
+//   --2d, --neumann, --bounded
+//   --threads N          スレッド数 (既定はハードウェアのスレッド数)
+//   --out FILE           CSV の出力先 (既定は標準出力)
+// Runs rule and initial-density combinations headless and in parallel, classifies their behavior and
+// writes CSV.
+// Usage: sweep_rules [options] [rule ...]
+//   --rules FILE         file with one rule per line (# starts a comment)
+//   --random N           adds N random rules for the 3D Moore neighborhood (seeded by --rule-seed)
+//   --densities A,B,..   initial densities (0.05,0.1,0.3 by default)
+//   --seeds N            seeds per density (4 by default)
+//   --length N           side length (32 by default)
+//   --generations N      most generations per run (300 by default)
+//   --2d, --neumann, --bounded
+//   --threads N          thread count (the hardware thread count by default)
+//   --out FILE           where the CSV goes (standard output by default)
+#include "RuleSweep.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<float> parseDensities(const std::string& list) {
+    std::vector<float> densities;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) densities.push_back(std::stof(item));
+    return densities;
+}
+
+void readRules(const std::string& path, std::vector<Rule>& rules) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open rule file: " + path);
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty()) rules.push_back(Rule::parse(line));
+    }
+}
+
+// 各近傍数を確率 1/6 で誕生と生存の条件に入れる. 0近傍での誕生は場全体が点滅するだけなので除く
+// Puts each count into the birth and survival conditions with probability 1/6. Birth on zero
+// neighbors only makes the whole field blink, so it is left out
+Rule randomRule(std::mt19937& eng) {
+    std::vector<int> birth;
+    std::vector<int> survival;
+    for (int c = 0; c <= Rule::MAX_COUNT; c++) {
+        if (c > 0 && eng() % 6 == 0) birth.push_back(c);
+        if (eng() % 6 == 0) survival.push_back(c);
+    }
+    return Rule(birth, survival);
+}
+
+}
+
+int main(int argc, char** argv) {
+    SweepSettings settings;
+    std::vector<Rule> rules;
+    std::vector<float> densities = { 0.05f, 0.1f, 0.3f };
+    int seeds = 4;
+    int random_rules = 0;
+    unsigned rule_seed = 1;
+    int thread_count = 0;
+    std::string out_path;
+
+    try {
+        for (int a = 1; a < argc; a++) {
+            const std::string arg = argv[a];
+            auto value = [&]() -> std::string {
+                if (a + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++a];
+            };
+            if (arg == "--rules") readRules(value(), rules);
+            else if (arg == "--random") random_rules = std::stoi(value());
+            else if (arg == "--rule-seed") rule_seed = (unsigned)std::stoul(value());
+            else if (arg == "--densities") densities = parseDensities(value());
+            else if (arg == "--seeds") seeds = std::stoi(value());
+            else if (arg == "--length") settings.length = std::stoi(value());
+            else if (arg == "--generations") settings.generations = std::stoi(value());
+            else if (arg == "--2d") settings.dim = 2;
+            else if (arg == "--neumann") settings.isNeumannNeighborhood = true;
+            else if (arg == "--bounded") settings.isTorus = false;
+            else if (arg == "--threads") thread_count = std::stoi(value());
+            else if (arg == "--out") out_path = value();
+            else if (arg.rfind("--", 0) == 0) throw std::invalid_argument("unknown option: " + arg);
+            else rules.push_back(Rule::parse(arg));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    std::mt19937 eng(rule_seed);
+    for (int r = 0; r < random_rules; r++) rules.push_back(randomRule(eng));
+    // 何も指定が無ければ main.cpp の面白いパターンを回す
+    // Without any rule, run the interesting patterns from main.cpp
+    if (rules.empty()) {
+        for (const char* notation: { "B4/S2", "B4,5,6/S1", "B4/S2,6",
+            "B5,7,9,11,13,15,17,19,21,23,25/S4,6,8,10,12,14,16,18,20,22,24,26" }) {
+            rules.push_back(Rule::parse(notation));
+        }
+    }
+
+    std::vector<SweepJob> jobs;
+    for (const Rule& rule: rules) {
+        for (float density: densities) {
+            for (int s = 0; s < seeds; s++) jobs.push_back({ rule, density, (uint64_t)jobs.size() + 1 });
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<SweepResult> results = runSweep(jobs, settings, thread_count);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (out_path.empty()) {
+        writeSweepCsv(std::cout, results);
+    } else {
+        std::ofstream out(out_path);
+        if (!out) {
+            std::cerr << "cannot write " << out_path << '\n';
+            return EXIT_FAILURE;
+        }
+        writeSweepCsv(out, results);
+    }
+
+    std::map<std::string, int> classes;
+    for (const SweepResult& r: results) classes[behaviorName(r.behavior)]++;
+    std::cerr << jobs.size() << " runs in " << seconds << " s (" << (int)(jobs.size() / seconds * 3600) << " per hour):";
+    for (const auto& c: classes) std::cerr << ' ' << c.first << ' ' << c.second;
+    std::cerr << '\n';
+}